@@ -0,0 +1,392 @@
+// grid_bench.cpp
+//
+// Dispatch, shedding, churn, economic dispatch, fork and power flow benchmarks over synthetic grids. Run with
+//   grid_bench --benchmark_format=json --benchmark_out=results.json
+// for machine-readable results; each benchmark also reports the grid shape
+// and loads handled per second as counters.
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include "../include/Grid.h"
+
+namespace {
+
+// Size and stress of a synthetic grid. The overload ratio is total demand
+// over total source capacity, so values above 1 force shedding.
+struct GridShape {
+    int busbars;
+    int loadsPerBusbar;
+    int sources;
+    double overload;
+};
+
+GridShape shapeFrom(const benchmark::State& state) {
+    return {static_cast<int>(state.range(0)), static_cast<int>(state.range(1)),
+            static_cast<int>(state.range(2)), static_cast<double>(state.range(3)) / 100.0};
+}
+
+// Loads get random demands (1-100 kW), types and priorities. Sources are
+// spread round-robin over the busbars, with capacities drawn so the grid as
+// a whole has the requested overload ratio. The same shape and seed always
+// give the same grid.
+std::unique_ptr<Grid> makeGrid(const GridShape& shape, std::uint32_t seed = 1) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> demand(1.0, 100.0);
+    std::uniform_real_distribution<double> weight(0.5, 1.5);
+    std::uniform_int_distribution<int> type(0, 3);
+    std::uniform_int_distribution<int> priority(1, 5);
+
+    auto grid = std::make_unique<Grid>("Synthetic Grid");
+    grid->setShedReporting(false);
+    std::size_t loadCount = static_cast<std::size_t>(shape.busbars) * shape.loadsPerBusbar;
+    grid->reserve(shape.busbars, shape.sources, loadCount);
+
+    std::vector<Grid::LoadPlacement> loads;
+    loads.reserve(loadCount);
+    double totalDemand = 0.0;
+    for (int b = 0; b < shape.busbars; ++b) {
+        auto busbar = grid->createBusbar("B" + std::to_string(b));
+        grid->addBusbar(busbar);
+        for (int l = 0; l < shape.loadsPerBusbar; ++l) {
+            double kw = demand(rng);
+            totalDemand += kw;
+            loads.push_back({grid->createLoad("L" + std::to_string(b) + "-" + std::to_string(l), kw,
+                                              static_cast<LoadType>(type(rng)),
+                                              static_cast<Priority>(priority(rng))),
+                             busbar.get()});
+        }
+    }
+    grid->addLoads(loads);
+
+    std::vector<double> weights(shape.sources);
+    double totalWeight = 0.0;
+    for (double& w : weights) {
+        w = weight(rng);
+        totalWeight += w;
+    }
+    std::vector<Grid::SourcePlacement> sources;
+    const auto& busbars = grid->getBusbars();
+    for (int s = 0; s < shape.sources; ++s) {
+        double capacity = totalDemand / shape.overload * weights[s] / totalWeight;
+        sources.push_back({grid->createSource("S" + std::to_string(s), capacity),
+                           busbars[s % busbars.size()].get()});
+    }
+    grid->addSources(sources);
+
+    grid->distributeLoadOptimally();
+    return grid;
+}
+
+void setShapeCounters(benchmark::State& state, const GridShape& shape, std::int64_t loadsPerIteration) {
+    state.counters["busbars"] = shape.busbars;
+    state.counters["loads"] = static_cast<double>(shape.busbars) * shape.loadsPerBusbar;
+    state.counters["sources"] = shape.sources;
+    state.counters["overload"] = shape.overload;
+    if (loadsPerIteration > 0) {
+        state.SetItemsProcessed(state.iterations() * loadsPerIteration);
+    }
+}
+
+// Arguments: busbars, loads per busbar, sources, overload percent. At 30%
+// most busbars are covered by their first source and skip allocation.
+void gridShapes(benchmark::internal::Benchmark* benchmark) {
+    benchmark->ArgNames({"busbars", "loads_per_busbar", "sources", "overload_pct"});
+    for (int overload : {30, 80, 120}) {
+        benchmark->Args({16, 64, 32, overload});
+        benchmark->Args({256, 256, 512, overload});
+        benchmark->Args({1024, 1024, 2048, overload});
+    }
+}
+
+// One busbar dispatched from scratch: the per-busbar kernel on its own
+void BM_BusbarDispatch(benchmark::State& state) {
+    GridShape shape{1, static_cast<int>(state.range(0)), static_cast<int>(state.range(1)),
+                    static_cast<double>(state.range(2)) / 100.0};
+    auto grid = makeGrid(shape);
+    Busbar& busbar = *grid->getBusbars().front();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(busbar.distributeLoadsToPowerSources());
+    }
+    setShapeCounters(state, shape, shape.loadsPerBusbar);
+}
+BENCHMARK(BM_BusbarDispatch)
+    ->ArgNames({"loads", "sources", "overload_pct"})
+    ->Args({16, 2, 30})->Args({16, 2, 80})->Args({16, 2, 120})
+    ->Args({256, 4, 80})->Args({256, 4, 120})
+    ->Args({4096, 16, 80})->Args({4096, 16, 120});
+
+// The same with knapsack shedding: greedy start, then the exact search up to
+// 64 non-critical loads
+void BM_BusbarDispatchKnapsack(benchmark::State& state) {
+    GridShape shape{1, static_cast<int>(state.range(0)), static_cast<int>(state.range(1)),
+                    static_cast<double>(state.range(2)) / 100.0};
+    auto grid = makeGrid(shape);
+    grid->setAllocationStrategy(AllocationStrategy::create("knapsack"));
+    Busbar& busbar = *grid->getBusbars().front();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(busbar.distributeLoadsToPowerSources());
+    }
+    setShapeCounters(state, shape, shape.loadsPerBusbar);
+}
+BENCHMARK(BM_BusbarDispatchKnapsack)
+    ->ArgNames({"loads", "sources", "overload_pct"})
+    ->Args({16, 2, 120})->Args({64, 4, 120})->Args({256, 4, 120})->Args({4096, 16, 120})
+    ->Unit(benchmark::kMicrosecond);
+
+// The same with every load curtailable: one water level per priority tier
+void BM_BusbarDispatchCurtailed(benchmark::State& state) {
+    GridShape shape{1, static_cast<int>(state.range(0)), static_cast<int>(state.range(1)),
+                    static_cast<double>(state.range(2)) / 100.0};
+    auto grid = makeGrid(shape);
+    grid->setCurtailment(true);
+    Busbar& busbar = *grid->getBusbars().front();
+    ConnectionView<Load> loads = busbar.getLoadView();
+    for (std::size_t i = 0; i < loads.size(); ++i) {
+        loads.share(i)->setCurtailable(true);
+    }
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(busbar.distributeLoadsToPowerSources());
+    }
+    setShapeCounters(state, shape, shape.loadsPerBusbar);
+}
+BENCHMARK(BM_BusbarDispatchCurtailed)
+    ->ArgNames({"loads", "sources", "overload_pct"})
+    ->Args({16, 2, 120})->Args({256, 4, 120})->Args({4096, 16, 80})->Args({4096, 16, 120});
+
+// Every busbar changed since the last dispatch
+void BM_GridDispatchFull(benchmark::State& state) {
+    GridShape shape = shapeFrom(state);
+    auto grid = makeGrid(shape);
+    GridState& gridState = grid->getState();
+    const auto& busbars = grid->getBusbars();
+    for (auto _ : state) {
+        for (const auto& busbar : busbars) {
+            gridState.markBusbarDirty(busbar->getIndex());
+        }
+        grid->distributeLoadOptimally();
+    }
+    setShapeCounters(state, shape, static_cast<std::int64_t>(shape.busbars) * shape.loadsPerBusbar);
+}
+BENCHMARK(BM_GridDispatchFull)->Apply(gridShapes)->Unit(benchmark::kMicrosecond);
+
+// One load's demand changes per dispatch, so one busbar is re-solved
+void BM_GridDispatchIncremental(benchmark::State& state) {
+    GridShape shape = shapeFrom(state);
+    auto grid = makeGrid(shape);
+    std::mt19937 rng(2);
+    std::uniform_int_distribution<int> busbar(0, shape.busbars - 1);
+    std::uniform_int_distribution<int> load(0, shape.loadsPerBusbar - 1);
+    std::uniform_real_distribution<double> demand(1.0, 100.0);
+    std::vector<std::shared_ptr<Load>> targets;
+    for (int i = 0; i < 1024; ++i) {
+        targets.push_back(grid->getLoad("L" + std::to_string(busbar(rng)) + "-" + std::to_string(load(rng))));
+    }
+    std::size_t next = 0;
+    for (auto _ : state) {
+        targets[next]->setPowerDemand(demand(rng));
+        next = (next + 1) % targets.size();
+        grid->distributeLoadOptimally();
+    }
+    setShapeCounters(state, shape, shape.loadsPerBusbar);
+}
+BENCHMARK(BM_GridDispatchIncremental)->Apply(gridShapes);
+
+void BM_SystemWideShedding(benchmark::State& state) {
+    GridShape shape = shapeFrom(state);
+    auto grid = makeGrid(shape);
+    for (auto _ : state) {
+        grid->performSystemWideLoadShedding();
+    }
+    setShapeCounters(state, shape, static_cast<std::int64_t>(shape.busbars) * shape.loadsPerBusbar);
+}
+BENCHMARK(BM_SystemWideShedding)->Apply(gridShapes)->Unit(benchmark::kMillisecond);
+
+void BM_UpdateStatistics(benchmark::State& state) {
+    GridShape shape = shapeFrom(state);
+    auto grid = makeGrid(shape);
+    for (auto _ : state) {
+        grid->updateStatistics();
+        benchmark::DoNotOptimize(grid->getShedLoad());
+    }
+    setShapeCounters(state, shape, 0);
+}
+BENCHMARK(BM_UpdateStatistics)->Apply(gridShapes);
+
+// The full rescan behind updateStatistics' running totals
+void BM_RecomputeStatistics(benchmark::State& state) {
+    GridShape shape = shapeFrom(state);
+    auto grid = makeGrid(shape);
+    for (auto _ : state) {
+        grid->recomputeStatistics();
+        benchmark::DoNotOptimize(grid->getShedLoad());
+    }
+    setShapeCounters(state, shape, static_cast<std::int64_t>(shape.busbars) * shape.loadsPerBusbar);
+}
+BENCHMARK(BM_RecomputeStatistics)->Apply(gridShapes);
+
+// A random load is removed and added back to its busbar, then dispatched
+void BM_LoadChurn(benchmark::State& state) {
+    GridShape shape = shapeFrom(state);
+    auto grid = makeGrid(shape);
+    std::mt19937 rng(3);
+    std::uniform_int_distribution<int> busbar(0, shape.busbars - 1);
+    std::uniform_int_distribution<int> load(0, shape.loadsPerBusbar - 1);
+    std::vector<std::pair<std::string, std::string>> targets;  // Load and busbar IDs
+    for (int i = 0; i < 1024; ++i) {
+        int b = busbar(rng);
+        targets.emplace_back("L" + std::to_string(b) + "-" + std::to_string(load(rng)), "B" + std::to_string(b));
+    }
+    std::size_t next = 0;
+    for (auto _ : state) {
+        const auto& target = targets[next];
+        next = (next + 1) % targets.size();
+        auto removed = grid->getLoad(target.first);
+        grid->removeLoad(target.first);
+        grid->addLoad(removed, target.second);
+        grid->distributeLoadOptimally();
+    }
+    setShapeCounters(state, shape, shape.loadsPerBusbar);
+}
+BENCHMARK(BM_LoadChurn)->Apply(gridShapes);
+
+// Economic dispatch on: one random source's capacity changes per dispatch,
+// so its segments move in the merit order and its busbar is re-solved
+void BM_GridDispatchEconomic(benchmark::State& state) {
+    GridShape shape = shapeFrom(state);
+    auto grid = makeGrid(shape);
+    std::mt19937 rng(4);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    std::vector<std::shared_ptr<PowerSource>> sources;
+    for (int s = 0; s < shape.sources; ++s) {
+        auto source = grid->getSource("S" + std::to_string(s));
+        double capacity = source->getCapacity();
+        double cost = 0.05 + 0.1 * unit(rng);
+        source->setMinOutput(0.1 * capacity * unit(rng));
+        source->setCostCurve({{0.5 * capacity, cost}, {0.8 * capacity, cost + 0.02}, {capacity, cost + 0.05}});
+        sources.push_back(source);
+    }
+    grid->setEconomicDispatch(true);
+    grid->distributeLoadOptimally();
+    std::uniform_int_distribution<int> source(0, shape.sources - 1);
+    for (auto _ : state) {
+        auto& target = sources[source(rng)];
+        target->setCapacity(target->getCapacity() * (0.9 + 0.2 * unit(rng)));
+        grid->distributeLoadOptimally();
+        benchmark::DoNotOptimize(grid->getOperatingCost());
+    }
+    setShapeCounters(state, shape, shape.loadsPerBusbar);
+}
+BENCHMARK(BM_GridDispatchEconomic)->Apply(gridShapes);
+
+// A what-if branch: fork, trip a source, grow a load and dispatch, then drop
+// the branch. Only the columns the branch writes are copied.
+void BM_ForkWhatIf(benchmark::State& state) {
+    GridShape shape = shapeFrom(state);
+    auto grid = makeGrid(shape);
+    grid->fork();  // Builds the ID index every later fork shares
+    for (auto _ : state) {
+        auto branch = grid->fork();
+        branch->getSource("S0")->setOperational(false);
+        auto load = branch->getLoad("L0-0");
+        load->setPowerDemand(load->getPowerDemand() * 1.2);
+        branch->distributeLoadOptimally();
+        benchmark::DoNotOptimize(branch->getShedLoad());
+    }
+    setShapeCounters(state, shape, 0);
+}
+BENCHMARK(BM_ForkWhatIf)->Apply(gridShapes)->Unit(benchmark::kMicrosecond);
+
+// A branch that adds and removes a load: structural edits copy the numeric
+// load columns whole, but only the pages of IDs and the member list of the
+// busbar they touch
+void BM_ForkStructuralEdit(benchmark::State& state) {
+    GridShape shape = shapeFrom(state);
+    auto grid = makeGrid(shape);
+    grid->fork();  // Builds the ID index every later fork shares
+    for (auto _ : state) {
+        auto branch = grid->fork();
+        branch->addLoad(branch->createLoad("L-new", 10.0, LoadType::COMMERCIAL, Priority::HIGH), "B0");
+        branch->removeLoad("L0-0");
+        branch->distributeLoadOptimally();
+        benchmark::DoNotOptimize(branch->getShedLoad());
+    }
+    setShapeCounters(state, shape, 0);
+}
+BENCHMARK(BM_ForkStructuralEdit)->Apply(gridShapes)->Unit(benchmark::kMicrosecond);
+
+// Ties every busbar to its right and lower neighbours on a side x side
+// square, with reactances from 0.5 to 1.5 per unit
+void addTieMesh(Grid& grid, int side) {
+    std::mt19937 rng(5);
+    std::uniform_real_distribution<double> reactance(0.5, 1.5);
+    int tie = 0;
+    for (int row = 0; row < side; ++row) {
+        for (int column = 0; column < side; ++column) {
+            int b = row * side + column;
+            if (column + 1 < side) {
+                grid.addTie("T" + std::to_string(tie++), "B" + std::to_string(b), "B" + std::to_string(b + 1),
+                            1000.0, true, reactance(rng));
+            }
+            if (row + 1 < side) {
+                grid.addTie("T" + std::to_string(tie++), "B" + std::to_string(b), "B" + std::to_string(b + side),
+                            1000.0, true, reactance(rng));
+            }
+        }
+    }
+}
+
+// Argument: side of the square tie mesh (side^2 busbars, 4 loads each)
+void meshShapes(benchmark::internal::Benchmark* benchmark) {
+    benchmark->ArgNames({"side"});
+    for (int side : {16, 64, 128}) {
+        benchmark->Arg(side);
+    }
+}
+
+// Dispatch plus power flow after one load changes. The ties are unchanged,
+// so each solve reuses the factor.
+void BM_PowerFlowSolve(benchmark::State& state) {
+    int side = static_cast<int>(state.range(0));
+    GridShape shape{side * side, 4, side * side, 0.3};
+    auto grid = makeGrid(shape);
+    addTieMesh(*grid, side);
+    grid->setPowerFlow(true);
+    grid->distributeLoadOptimally();
+    std::mt19937 rng(6);
+    std::uniform_int_distribution<int> busbar(0, shape.busbars - 1);
+    std::uniform_real_distribution<double> scale(0.9, 1.1);
+    for (auto _ : state) {
+        auto load = grid->getLoad("L" + std::to_string(busbar(rng)) + "-0");
+        load->setPowerDemand(load->getPowerDemand() * scale(rng));
+        grid->distributeLoadOptimally();
+        benchmark::DoNotOptimize(grid->getMaxTieLoadingPercent());
+    }
+    setShapeCounters(state, shape, 1);
+}
+BENCHMARK(BM_PowerFlowSolve)->Apply(meshShapes)->Unit(benchmark::kMicrosecond);
+
+// The same with a tie switched each iteration, so every solve refactorizes
+void BM_PowerFlowRefactorize(benchmark::State& state) {
+    int side = static_cast<int>(state.range(0));
+    GridShape shape{side * side, 4, side * side, 0.3};
+    auto grid = makeGrid(shape);
+    addTieMesh(*grid, side);
+    grid->setPowerFlow(true);
+    grid->distributeLoadOptimally();
+    bool closed = true;
+    for (auto _ : state) {
+        closed = !closed;
+        grid->setTieClosed("T0", closed);
+        grid->distributeLoadOptimally();
+        benchmark::DoNotOptimize(grid->getMaxTieLoadingPercent());
+    }
+    setShapeCounters(state, shape, 0);
+}
+BENCHMARK(BM_PowerFlowRefactorize)->Apply(meshShapes)->Unit(benchmark::kMicrosecond);
+
+} // namespace
+
+BENCHMARK_MAIN();
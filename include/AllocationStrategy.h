@@ -0,0 +1,122 @@
+// AllocationStrategy.h
+#ifndef ALLOCATION_STRATEGY_H
+#define ALLOCATION_STRATEGY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+class GridState;
+
+// One packing problem: which loads go on which sources. Loads are listed in
+// priority order (critical first); only available sources are listed, with
+// the headroom they have left.
+struct AllocationProblem {
+    std::vector<double> demands;
+    std::vector<std::uint8_t> priorities;
+    std::vector<double> capacities;
+};
+
+// Decides which source, if any, serves each load. Loads of a higher priority
+// always take precedence over lower ones; strategies differ in how they pack
+// loads within a priority tier.
+class AllocationStrategy {
+public:
+    static constexpr std::size_t UNSERVED = static_cast<std::size_t>(-1);
+
+    virtual ~AllocationStrategy() = default;
+
+    virtual std::string getName() const = 0;
+
+    // Fills assignment[i] with the index of the source serving load i, or
+    // UNSERVED. Must be safe to call from several threads at once.
+    virtual void allocate(const AllocationProblem& problem,
+                          std::vector<std::size_t>& assignment) const = 0;
+
+    // Builds a strategy from a command-line name: "first-fit", "best-fit",
+    // "branch-and-bound[:<budget in microseconds>]" or
+    // "knapsack[:<budget in microseconds>]". Returns nullptr for unknown
+    // names and for budgets that are not non-negative numbers.
+    static std::shared_ptr<AllocationStrategy> create(const std::string& name);
+};
+
+// Each load goes to the first source it fits on (the historical behaviour)
+class FirstFitStrategy : public AllocationStrategy {
+public:
+    std::string getName() const override;
+    void allocate(const AllocationProblem& problem,
+                  std::vector<std::size_t>& assignment) const override;
+};
+
+// Within each tier, largest loads first onto the tightest source that fits
+class BestFitDecreasingStrategy : public AllocationStrategy {
+public:
+    std::string getName() const override;
+    void allocate(const AllocationProblem& problem,
+                  std::vector<std::size_t>& assignment) const override;
+};
+
+// Searches for the packing that serves the most kW in each tier, higher
+// tiers first, starting from the better of first-fit and best-fit-decreasing
+// per tier. The search stops when the per-problem time budget runs out and
+// keeps the best packing found so far; given enough time it is exact.
+class BranchAndBoundStrategy : public AllocationStrategy {
+private:
+    double timeBudgetMicroseconds;
+
+public:
+    explicit BranchAndBoundStrategy(double timeBudgetMicroseconds = 500.0);
+
+    std::string getName() const override;
+    void allocate(const AllocationProblem& problem,
+                  std::vector<std::size_t>& assignment) const override;
+};
+
+// Sheds for the least customer impact rather than strictly by priority: the
+// packing serves the most kW weighted by priority (by default HIGH 8,
+// MEDIUM 4, LOW 2, MINIMAL 1), so several small loads can outweigh one
+// large load of the same or a higher priority. CRITICAL loads are packed
+// first, as by branch-and-bound's starting packing, and are never traded
+// away. The rest start from the better of first-fit and a greedy packing
+// that serves at least a third of the best achievable weighted demand (half
+// with a single source); busbars with at most exactLoadLimit of them are
+// then searched exactly until the per-busbar time budget runs out.
+class KnapsackStrategy : public AllocationStrategy {
+public:
+    static constexpr std::size_t PRIORITY_LEVELS = 5;
+
+private:
+    double timeBudgetMicroseconds;
+    std::size_t exactLoadLimit;
+    double priorityWeights[PRIORITY_LEVELS];
+
+public:
+    explicit KnapsackStrategy(double timeBudgetMicroseconds = 200.0, std::size_t exactLoadLimit = 64);
+
+    // Returns false (changing nothing) for CRITICAL, an unknown priority or
+    // a weight that is not positive
+    bool setPriorityWeight(std::uint8_t priority, double weight);
+    double getPriorityWeight(std::uint8_t priority) const;
+
+    std::string getName() const override;
+    void allocate(const AllocationProblem& problem,
+                  std::vector<std::size_t>& assignment) const override;
+};
+
+// Result of running a strategy and first-fit side by side on every busbar
+struct AllocationComparison {
+    std::string strategy;
+    std::size_t busbars = 0;
+    double servedKw = 0.0;
+    double firstFitServedKw = 0.0;
+    double extraServedKw = 0.0;
+    double solveSeconds = 0.0;
+    double firstFitSolveSeconds = 0.0;
+    double maxBusbarSolveSeconds = 0.0;
+};
+
+AllocationComparison compareWithFirstFit(const GridState& state, const AllocationStrategy& strategy);
+
+#endif // ALLOCATION_STRATEGY_H
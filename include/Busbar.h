@@ -7,35 +7,138 @@
 #include <memory>
 #include "Load.h"
 #include "PowerSource.h"
+#include "GridState.h"
+#include "ConnectionView.h"
 
 class Busbar {
+public:
+    enum class LoadFilter {
+        ALL,
+        CONNECTED,
+        SERVED,
+        SHED  // Connected but not served
+    };
+    
+    enum class SourceFilter {
+        ALL,
+        OPERATIONAL
+    };
+
 private:
     std::string id;
     std::vector<std::shared_ptr<Load>> connectedLoads;
     std::vector<std::shared_ptr<PowerSource>> connectedSources;
-    bool energized;  // Whether the busbar is energized
+    
+    // Dispatch runs over the owning grid's state arrays; these are set
+    // when the busbar is added to a grid.
+    GridState* state;
+    GridState::Handle index;
+    
+    // Loads shed by the most recent dispatch (reused between calls)
+    std::vector<GridState::Handle> shedLoads;
+    
+    // Removal moves the last connection into the freed slot
+    void removeLoadAt(std::size_t slot);
+    void removeSourceAt(std::size_t slot);
+    
+    // Binds the busbar to a slot already in the state, along with views of
+    // everything on it (Grid creates a fork's views this way)
+    void adopt(GridState* gridState, GridState::Handle handle,
+               std::vector<std::shared_ptr<Load>> loads,
+               std::vector<std::shared_ptr<PowerSource>> sources);
+    friend class Grid;
+    
+    // Filters read the grid state's columns directly while attached
+    bool matches(const Load& load, LoadFilter filter) const {
+        bool connected = state ? state->loadConnected[load.handle] != 0 : load.isConnected;
+        bool served = state ? state->loadServed[load.handle] != 0 : load.isServed;
+        switch (filter) {
+            case LoadFilter::CONNECTED: return connected;
+            case LoadFilter::SERVED: return served;
+            case LoadFilter::SHED: return connected && !served;
+            default: return true;
+        }
+    }
+    
+    bool matches(const PowerSource& source, SourceFilter filter) const {
+        if (filter == SourceFilter::OPERATIONAL) {
+            return state ? state->sourceOperational[source.handle] != 0 : source.operational;
+        }
+        return true;
+    }
 
 public:
     // Constructor
     Busbar(const std::string& id);
     
     // Getters
-    std::string getId() const;
-    bool isEnergized() const;
+    const std::string& getId() const;
+    // Aggregates are O(1) while the busbar is part of a grid
+    bool isEnergized() const;  // Whether any connected source is operational
     double getTotalConnectedLoad() const;
+    double getConnectedLoad(Priority priority) const;
+    double getOperationalCapacity() const;
     double getTotalAvailablePower() const;
+    // Incremental cost of the last economic dispatch (0 when detached)
+    double getIncrementalCost() const;
+    // Copies of the connection lists; the views below avoid the copy
     std::vector<std::shared_ptr<Load>> getConnectedLoads() const;
     std::vector<std::shared_ptr<PowerSource>> getConnectedSources() const;
     
-    // Connection management
+    // Connections in connection order, without copying (see ConnectionView)
+    ConnectionView<Load> getLoadView() const;
+    ConnectionView<PowerSource> getSourceView() const;
+    
+    // Calls visit(const Load&) / visit(const PowerSource&) for each
+    // connection passing the filter, in connection order. The busbar's
+    // connections must not change during the walk.
+    template <typename Visitor>
+    void forEachLoad(LoadFilter filter, Visitor&& visit) const {
+        for (const auto& load : connectedLoads) {
+            const Load& entry = *load;
+            if (matches(entry, filter)) {
+                visit(entry);
+            }
+        }
+    }
+    
+    template <typename Visitor>
+    void forEachSource(SourceFilter filter, Visitor&& visit) const {
+        for (const auto& source : connectedSources) {
+            const PowerSource& entry = *source;
+            if (matches(entry, filter)) {
+                visit(entry);
+            }
+        }
+    }
+    
+    // Pre-sizes the connection lists ahead of a bulk build
+    void reserve(std::size_t loadCount, std::size_t sourceCount);
+    
+    // Connection management (disconnecting moves the last connection into
+    // the freed position, so connection order is not preserved)
     void connectLoad(std::shared_ptr<Load> load);
-    void disconnectLoad(const std::string& loadId);
+    // Bulk variant for Grid::addLoads: the grid state's priority order is
+    // restored once the whole batch is in (GridState::commitAppendedLoads)
+    void appendLoad(std::shared_ptr<Load> load);
+    void disconnectLoad(const std::string& loadId);  // Searches the busbar
+    void disconnectLoad(Load& load);
     void connectSource(std::shared_ptr<PowerSource> source);
     void disconnectSource(const std::string& sourceId);
+    void disconnectSource(PowerSource& source);
+    
+    // Grid state binding
+    void attach(GridState* gridState);
+    void detach();
+    bool isAttached() const;
+    GridState::Handle getIndex() const;
+    bool needsDispatch() const;  // Whether anything changed since the last dispatch
     
     // Power distribution
-    bool distributeLoadsToPowerSources();
-    void performLoadShedding();
+    bool distributeLoadsToPowerSources();  // Returns false if any load was shed
+    double solveLoads();                   // Dispatch without updating grid totals
+    // Shed by the busbar's last dispatch through the two calls above
+    const std::vector<GridState::Handle>& getShedLoads() const;
 };
 
 #endif // BUSBAR_H
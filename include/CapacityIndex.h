@@ -0,0 +1,38 @@
+// CapacityIndex.h
+#ifndef CAPACITY_INDEX_H
+#define CAPACITY_INDEX_H
+
+#include <cstddef>
+#include <vector>
+
+// Max segment tree over the headroom of a fixed list of sources. Finds the
+// first source (in list order) whose headroom reaches a demand in O(log n),
+// so first-fit packing over many sources no longer scans them all.
+class CapacityIndex {
+public:
+    static constexpr std::size_t NONE = static_cast<std::size_t>(-1);
+
+private:
+    std::size_t count;
+    std::size_t leaves;
+    std::vector<double> tree;  // 1-based heap layout, leaves at [leaves, 2 * leaves)
+
+    std::size_t findFirst(std::size_t node, std::size_t begin, std::size_t end,
+                          std::size_t from, double demand) const;
+
+public:
+    // Unavailable sources can be given a negative headroom
+    CapacityIndex();
+    explicit CapacityIndex(const std::vector<double>& headroom);
+    // Rebuilds over a new list, reusing the tree's storage
+    void assign(const std::vector<double>& headroom);
+
+    std::size_t size() const;
+    double getHeadroom(std::size_t index) const;
+    void setHeadroom(std::size_t index, double headroom);
+
+    // First index >= from with headroom >= demand, or NONE
+    std::size_t findFirst(double demand, std::size_t from = 0) const;
+};
+
+#endif // CAPACITY_INDEX_H
@@ -0,0 +1,90 @@
+// ConnectionView.h
+#ifndef CONNECTION_VIEW_H
+#define CONNECTION_VIEW_H
+
+#include <cstddef>
+#include <iterator>
+#include <memory>
+
+// Read-only view of a busbar's connection list. Iterating yields const
+// references to the entities, so walking a busbar copies nothing and never
+// touches the shared_ptr reference counts; share() hands out the owning
+// pointer to callers that need to keep or change an entity. The view is invalidated when the busbar's
+// connections change, like an iterator into the list.
+template <typename T>
+class ConnectionView {
+private:
+    const std::shared_ptr<T>* first;
+    std::size_t count;
+
+public:
+    class iterator {
+    private:
+        const std::shared_ptr<T>* position;
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const T*;
+        using reference = const T&;
+
+        explicit iterator(const std::shared_ptr<T>* position) : position(position) {}
+
+        const T& operator*() const {
+            return **position;
+        }
+
+        const T* operator->() const {
+            return position->get();
+        }
+
+        iterator& operator++() {
+            ++position;
+            return *this;
+        }
+
+        iterator operator++(int) {
+            iterator previous = *this;
+            ++position;
+            return previous;
+        }
+
+        bool operator==(const iterator& other) const {
+            return position == other.position;
+        }
+
+        bool operator!=(const iterator& other) const {
+            return position != other.position;
+        }
+    };
+
+    ConnectionView(const std::shared_ptr<T>* first, std::size_t count) : first(first), count(count) {}
+
+    iterator begin() const {
+        return iterator(first);
+    }
+
+    iterator end() const {
+        return iterator(first + count);
+    }
+
+    std::size_t size() const {
+        return count;
+    }
+
+    bool empty() const {
+        return count == 0;
+    }
+
+    const T& operator[](std::size_t i) const {
+        return *first[i];
+    }
+
+    // The owning pointer, for callers that need to keep the entity
+    const std::shared_ptr<T>& share(std::size_t i) const {
+        return first[i];
+    }
+};
+
+#endif // CONNECTION_VIEW_H
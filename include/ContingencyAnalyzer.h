@@ -0,0 +1,80 @@
+// ContingencyAnalyzer.h
+#ifndef CONTINGENCY_ANALYZER_H
+#define CONTINGENCY_ANALYZER_H
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+#include "Grid.h"
+#include "GridState.h"
+#include "ThreadPool.h"
+
+// N-k source outage studies. Every case re-solves only the busbars that lose
+// a source, on per-thread scratch copies of their source loading, so the
+// live grid is never modified and cases can be evaluated in parallel.
+//
+// On a grid with closed bus ties an outage also changes what transfers can
+// serve, so each case is instead dispatched on a fork of a dispatched copy
+// of the grid, with the sources tripped, and compared over the whole tie
+// groups of the busbars that lose a source. Such cases cost a fork and a
+// dispatch of those groups each.
+class ContingencyAnalyzer {
+public:
+    static constexpr std::size_t PRIORITY_COUNT = 5;
+    static constexpr std::size_t NONE = static_cast<std::size_t>(-1);
+
+    struct Options {
+        std::size_t outageSize = 1;     // k: sources tripped together
+        std::size_t samples = 0;        // 0 enumerates every k-combination
+        unsigned int seed = 1;          // Sampling seed
+        double minAdditionalShed = 0.0; // Cases shedding less extra load are dropped
+        bool collectLoadIds = false;    // Keep the IDs of newly shed loads
+    };
+
+    struct Result {
+        std::vector<std::string> outagedSources;
+        double shedKw = 0.0;            // System-wide shed load under the outage
+        double additionalShedKw = 0.0;  // Shed load beyond the base case
+        // Loads that lose supply compared to the base case, by priority
+        std::array<double, PRIORITY_COUNT> additionalShedKwByPriority{};
+        std::array<std::size_t, PRIORITY_COUNT> additionalLoadsShedByPriority{};
+        std::vector<std::string> affectedLoads;
+    };
+
+private:
+    const GridState& state;
+    std::shared_ptr<ThreadPool> pool;
+
+    // Base case per busbar: shed loads (sorted) and shed kW
+    std::vector<std::vector<GridState::Handle>> baseShed;
+    std::vector<double> baseShedKw;
+    double baseTotalShedKw;
+    std::vector<GridState::Handle> candidates;  // Operational sources
+    // With closed ties: the dispatched copy cases fork from, and each
+    // busbar's tie group (NONE if it has no closed tie)
+    std::shared_ptr<Grid> base;
+    std::vector<std::size_t> groupOf;
+    std::vector<std::vector<GridState::Handle>> groups;
+
+    void computeBaseCase();
+    void computeTiedBaseCase(const Grid& grid);
+    // Adds the busbars' shed beyond the base case to the result
+    void compareShed(const GridState& solved, const std::vector<GridState::Handle>& busbars,
+                     const Options& options, Result& result) const;
+    bool evaluate(const GridState::Handle* outage, std::size_t count,
+                  const Options& options, Result& result) const;
+
+public:
+    // Constructor (the grid must outlive the analyzer and not change meanwhile)
+    ContingencyAnalyzer(const Grid& grid, std::shared_ptr<ThreadPool> pool = nullptr);
+
+    double getBaseShedKw() const;
+    std::size_t getCandidateCount() const;
+
+    // Runs the study; results are ordered by additional shed, worst first
+    std::vector<Result> run(const Options& options);
+};
+
+#endif // CONTINGENCY_ANALYZER_H
@@ -0,0 +1,76 @@
+// CowColumn.h
+#ifndef COW_COLUMN_H
+#define COW_COLUMN_H
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+// A state column that copies of the grid state share until one of them
+// writes to it (copy-on-write). Reads go straight to the values; writes go
+// through edit(), which first takes a private copy if another state still
+// shares them. Kernels hold on to the reference (or data pointer) edit()
+// returns for the length of a pass, so the sharing check is paid once per
+// pass rather than once per element.
+//
+// edit() is not safe to call concurrently on a shared column; it may be on
+// a column this state already owns alone.
+template <typename T>
+class CowColumn {
+private:
+    std::shared_ptr<std::vector<T>> values;
+
+public:
+    using const_iterator = typename std::vector<T>::const_iterator;
+
+    CowColumn() : values(std::make_shared<std::vector<T>>()) {}
+
+    const T& operator[](std::size_t i) const {
+        return (*values)[i];
+    }
+
+    const T* data() const {
+        return values->data();
+    }
+
+    std::size_t size() const {
+        return values->size();
+    }
+
+    bool empty() const {
+        return values->empty();
+    }
+
+    const_iterator begin() const {
+        return values->cbegin();
+    }
+
+    const_iterator end() const {
+        return values->cend();
+    }
+
+    bool isShared() const {
+        return values.use_count() > 1;
+    }
+
+    std::vector<T>& edit() {
+        if (isShared()) {
+            values = std::make_shared<std::vector<T>>(*values);
+        }
+        return *values;
+    }
+
+    // Appends, taking the private copy with room to grow so that adding an
+    // entity to a fork copies the column once rather than twice
+    void push_back(const T& value) {
+        if (isShared()) {
+            auto copy = std::make_shared<std::vector<T>>();
+            copy->reserve(values->size() + values->size() / 2 + 1);
+            copy->assign(values->begin(), values->end());
+            values = std::move(copy);
+        }
+        values->push_back(value);
+    }
+};
+
+#endif // COW_COLUMN_H
@@ -0,0 +1,67 @@
+// EntityArena.h
+#ifndef ENTITY_ARENA_H
+#define ENTITY_ARENA_H
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <utility>
+
+// Pooled storage for a grid's loads, sources and busbars. Each entity is
+// allocated together with its shared_ptr control block from a size-class
+// pool, so building a grid costs a few large allocations rather than one
+// per entity, entities created together sit together in memory, and the
+// blocks of removed entities are reused by the next ones created.
+//
+// Every entity keeps the arena alive, so entities may outlive the grid.
+// Not thread-safe: entities are created and released by whoever edits the
+// grid, never by dispatch.
+class EntityArena : public std::enable_shared_from_this<EntityArena> {
+private:
+    std::pmr::unsynchronized_pool_resource pool;
+
+    // Allocator stored in each entity's control block
+    template <typename T>
+    class Allocator {
+    public:
+        using value_type = T;
+
+        std::shared_ptr<EntityArena> arena;
+
+        explicit Allocator(std::shared_ptr<EntityArena> arena) : arena(std::move(arena)) {}
+
+        template <typename U>
+        Allocator(const Allocator<U>& other) : arena(other.arena) {}
+
+        T* allocate(std::size_t n) {
+            return static_cast<T*>(arena->pool.allocate(n * sizeof(T), alignof(T)));
+        }
+
+        void deallocate(T* p, std::size_t n) {
+            arena->pool.deallocate(p, n * sizeof(T), alignof(T));
+        }
+
+        template <typename U>
+        bool operator==(const Allocator<U>& other) const {
+            return arena == other.arena;
+        }
+
+        template <typename U>
+        bool operator!=(const Allocator<U>& other) const {
+            return arena != other.arena;
+        }
+    };
+
+public:
+    EntityArena() = default;
+    EntityArena(const EntityArena&) = delete;
+    EntityArena& operator=(const EntityArena&) = delete;
+
+    // The arena must itself be owned by a shared_ptr
+    template <typename T, typename... Args>
+    std::shared_ptr<T> make(Args&&... args) {
+        return std::allocate_shared<T>(Allocator<T>(shared_from_this()), std::forward<Args>(args)...);
+    }
+};
+
+#endif // ENTITY_ARENA_H
@@ -0,0 +1,70 @@
+// EventQueue.h
+#ifndef EVENT_QUEUE_H
+#define EVENT_QUEUE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class Grid;
+
+// A timed change to a grid. Times are in simulation steps (one step is one
+// load profile interval).
+struct GridEvent {
+    enum class Type {
+        SET_DEMAND,
+        SET_CAPACITY,
+        TRIP_SOURCE,
+        RESTORE_SOURCE,
+        CONNECT_LOAD,
+        DISCONNECT_LOAD,
+        OPEN_TIE,
+        CLOSE_TIE,
+        PROFILE_INTERVAL,  // Moves demand to the profiles' interval at this time
+        DISPATCH           // Changes nothing, but forces a re-solve at this time
+    };
+
+    long long time;
+    Type type;
+    std::string targetId;
+    double value;
+
+    // Applies the event; returns false (changing nothing) when the target
+    // does not exist
+    bool apply(Grid& grid) const;
+};
+
+// Discrete-event scheduler: a binary min-heap of events ordered by time,
+// with events at the same time kept in the order they were scheduled.
+class EventQueue {
+public:
+    using Time = long long;
+
+private:
+    struct Entry {
+        GridEvent event;
+        std::uint64_t sequence;
+    };
+
+    std::vector<Entry> heap;
+    std::uint64_t nextSequence;
+
+    static bool later(const Entry& a, const Entry& b);
+
+public:
+    EventQueue();
+
+    void schedule(GridEvent event);
+    void clear();
+    bool empty() const;
+    std::size_t size() const;
+    Time nextTime() const;  // Time of the earliest event; the queue must not be empty
+
+    // Applies every event due at the earliest time, in scheduling order, and
+    // returns that time. Profile events reschedule themselves one step later.
+    // 'applied' receives the number of events whose target existed.
+    Time applyNext(Grid& grid, std::size_t& applied);
+};
+
+#endif // EVENT_QUEUE_H
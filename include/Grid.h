@@ -5,57 +5,222 @@
 #include <string>
 #include <vector>
 #include <memory>
-#include <map>
 #include "Busbar.h"
 #include "Load.h"
 #include "PowerSource.h"
+#include "GridState.h"
+#include "LoadProfiles.h"
+#include "ThreadPool.h"
+#include "AllocationStrategy.h"
+#include "IdIndex.h"
+#include "ReportSink.h"
+#include "EntityArena.h"
+#include "CapacityIndex.h"
+#include "Topology.h"
+#include "PowerFlow.h"
 
 class Grid {
+public:
+    // One entry of a bulk insert: an entity and the busbar (of this grid) it
+    // connects to
+    struct LoadPlacement {
+        std::shared_ptr<Load> load;
+        Busbar* busbar;
+    };
+    
+    struct SourcePlacement {
+        std::shared_ptr<PowerSource> source;
+        Busbar* busbar;
+    };
+    
+    // A load shed by a dispatch, with its demand at the time
+    struct ShedEvent {
+        GridState::Handle load;
+        GridState::Handle busbar;  // INVALID_HANDLE when shed system-wide
+        double demandKw;
+    };
+
 private:
     std::string name;
-    std::vector<std::shared_ptr<Busbar>> busbars;
-    std::map<std::string, std::shared_ptr<Load>> allLoads;
-    std::map<std::string, std::shared_ptr<PowerSource>> allSources;
+    std::shared_ptr<EntityArena> arena;  // Storage for entities made by create*
+    std::vector<std::shared_ptr<Busbar>> busbars;  // In the order they were added
+    std::vector<GridState::Handle> busbarHandles;  // The same order
+    IdIndex<Busbar> busbarIndex;
+    IdIndex<Load> allLoads;
+    IdIndex<PowerSource> allSources;
+    
+    // A fork creates its entities' views only when they are asked for;
+    // until then they are not in the indexes above, and 'busbars' is empty
+    bool lazyViews;
+    
+    // Flat storage the dispatch kernels run over
+    std::unique_ptr<GridState> state;
+    
+    // Bus ties between busbars, and the DC power flow over them (solved
+    // after every dispatch while enabled)
+    Topology topology;
+    PowerFlow powerFlow;
+    bool powerFlowEnabled;
+    
+    // Optional time-varying demand (nullptr keeps demands fixed)
+    std::shared_ptr<LoadProfiles> loadProfiles;
+    
+    // Optional pool for dispatching busbars concurrently (nullptr is serial)
+    std::shared_ptr<ThreadPool> dispatchPool;
+    std::vector<double> busbarServedScratch;
+    std::vector<std::vector<GridState::Handle>> busbarShedScratch;
+    
+    // Optional packing strategy (nullptr is first-fit)
+    std::shared_ptr<AllocationStrategy> allocationStrategy;
     
     // Statistics
     double totalDemand;
     double totalSupply;
     double servedDemand;
     double shedLoad;
+    
+    // Loads shed by the most recent dispatch, in busbar order (reused
+    // between dispatches)
+    std::vector<ShedEvent> shedEvents;
+    bool shedReporting;  // Whether dispatch prints its shed events
+    
+    // Loads and sources in ID order for system-wide shedding, rebuilt only
+    // after loads or sources are added or removed (and shared with forks)
+    CowColumn<GridState::Handle> loadsById;
+    CowColumn<GridState::Handle> sourcesById;
+    bool idOrderValid;
+    
+    // Scratch reused by every system-wide shedding pass
+    std::vector<GridState::Handle> systemLoadsScratch;
+    std::vector<double> headroomScratch;
+    CapacityIndex capacityScratch;
+    AllocationProblem systemProblemScratch;
+    std::vector<GridState::Handle> availableSourcesScratch;
+    std::vector<std::size_t> assignmentScratch;
+    
+    void refreshIdOrder();
+    void recordBusbarShedLoads(GridState::Handle busbar, const std::vector<GridState::Handle>& shed);
+    void reportShedEvents() const;
+    
+    // The entity's view, created (and indexed) first if need be
+    std::shared_ptr<Load> loadView(GridState::Handle load);
+    std::shared_ptr<PowerSource> sourceView(GridState::Handle source);
+    std::shared_ptr<Busbar> busbarView(GridState::Handle busbar);
+    void createAllViews();
 
 public:
     // Constructor
     Grid(const std::string& name);
     
+    // Getters
+    std::string getName() const;
+    const std::vector<std::shared_ptr<Busbar>>& getBusbars();
+    const std::vector<GridState::Handle>& getBusbarHandles() const;  // Same order, without views
+    
+    // A what-if branch: a grid equal to this one and independent of it from
+    // then on. The two share their state columns until either writes to one
+    // (see CowColumn), and the fork creates entity views only as they are
+    // asked for, so a branch costs the per-busbar bookkeeping plus the
+    // columns it changes. It shares the thread pool, allocation strategy and
+    // load profiles; its busbars list connections in dispatch order. Views
+    // of one grid must not be passed to the other.
+    std::shared_ptr<Grid> fork() const;
+    
+    // Entities allocated from the grid's arena; they still have to be added
+    // (and may also be added to another grid)
+    std::shared_ptr<Busbar> createBusbar(const std::string& id);
+    std::shared_ptr<Load> createLoad(const std::string& id, double powerDemand, LoadType type, Priority priority);
+    std::shared_ptr<PowerSource> createSource(const std::string& id, double capacity);
+    
+    // Pre-sizes the indexes and state arrays ahead of a bulk build
+    void reserve(std::size_t busbarCount, std::size_t sourceCount, std::size_t loadCount);
+    
     // Grid structure management
     void addBusbar(std::shared_ptr<Busbar> busbar);
     void removeBusbar(const std::string& busbarId);
     std::shared_ptr<Busbar> getBusbar(const std::string& busbarId);
     
+    // Bus ties: a closed tie lets either busbar serve the other's shed loads
+    // up to the transfer limit (see Topology). The reactance (per unit) only
+    // matters to the power flow.
+    void addTie(const std::string& tieId, const std::string& fromBusbarId, const std::string& toBusbarId,
+                double limitKw, bool closed = true, double reactance = 1.0);
+    void removeTie(const std::string& tieId);
+    void setTieClosed(const std::string& tieId, bool closed);
+    void setTieLimit(const std::string& tieId, double limitKw);
+    const Topology& getTopology() const;
+    Topology& getTopology();
+    
+    // Busbar a load or source is connected to (nullptr if none, or if it
+    // belongs to another grid)
+    Busbar* getOwningBusbar(const Load& load);
+    Busbar* getOwningBusbar(const PowerSource& source);
+    
     // Load management
     void addLoad(std::shared_ptr<Load> load, const std::string& busbarId);
     void removeLoad(const std::string& loadId);
     std::shared_ptr<Load> getLoad(const std::string& loadId);
+    // Adds a batch with the same result as adding the loads one at a time,
+    // but sizes the indexes once and restores each busbar's priority order
+    // once at the end instead of on every insert
+    void addLoads(const std::vector<LoadPlacement>& loads);
     
     // Source management
     void addSource(std::shared_ptr<PowerSource> source, const std::string& busbarId);
     void removeSource(const std::string& sourceId);
     std::shared_ptr<PowerSource> getSource(const std::string& sourceId);
+    void addSources(const std::vector<SourcePlacement>& sources);
+    
+    // Load profiles
+    void setLoadProfiles(std::shared_ptr<LoadProfiles> profiles);
+    std::shared_ptr<LoadProfiles> getLoadProfiles() const;
+    bool applyLoadProfiles(long long step);  // Returns true if demands changed
     
     // Power distribution and load shedding
+    void setShedReporting(bool enabled);
+    void setThreadPool(std::shared_ptr<ThreadPool> pool);
+    void setAllocationStrategy(std::shared_ptr<AllocationStrategy> strategy);
+    std::shared_ptr<AllocationStrategy> getAllocationStrategy() const;
+    // Partial service of curtailable loads by distributeLoadOptimally (see
+    // GridState::setCurtailment); system-wide shedding still packs whole loads
+    void setCurtailment(bool enabled);
+    bool isCurtailmentEnabled() const;
+    // Least-cost source outputs after every dispatch (see
+    // GridState::setEconomicDispatch)
+    void setEconomicDispatch(bool enabled);
+    bool isEconomicDispatchEnabled() const;
+    // DC power flow over the closed ties after every dispatch (see
+    // PowerFlow); each tie's powerFlowKw then holds its flow
+    void setPowerFlow(bool enabled);
+    bool isPowerFlowEnabled() const;
     void distributeLoadOptimally();
     void performSystemWideLoadShedding();
+    // Loads shed by the last dispatch; after distributeLoadOptimally these
+    // cover only the busbars it re-solved
+    const std::vector<ShedEvent>& getShedEvents() const;
     
     // Statistics and reporting
     void updateStatistics();
+    void recomputeStatistics();  // Full rescan, e.g. to discard accumulated rounding
     double getTotalDemand() const;
     double getTotalSupply() const;
     double getServedDemand() const;
+    double getOperatingCost() const;  // Per hour, at the sources' current outputs
     double getShedLoad() const;
     double getSupplyUtilizationPercent() const;
+    // Ties loaded past their limit by the last power flow, and the highest
+    // tie loading in percent of its limit
+    std::size_t getTieOverloadCount() const;
+    double getMaxTieLoadingPercent() const;
+    
+    // Direct access to the flat state, for analysis engines
+    const GridState& getState() const;
+    GridState& getState();
     
     // System report
-    void printSystemReport() const;
+    void printSystemReport() const;  // As a table on standard output
+    void writeReport(ReportSink& sink) const;
+    void writeShedEvents(ReportSink& sink, long long step) const;
 };
 
 #endif // GRID_H
@@ -0,0 +1,43 @@
+// GridSnapshot.h
+#ifndef GRID_SNAPSHOT_H
+#define GRID_SNAPSHOT_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include "Grid.h"
+
+// Binary image of a grid: busbars, sources and loads with their live values
+// (connection status, served flags and curtailed power, source loading),
+// source minimum outputs and cost curves, bus ties with their reactances and
+// flows, plus any load profiles.
+//
+// The file is a fixed header followed by arrays of fixed-size records and a
+// pool of ID strings, in native byte order. Sources and loads are grouped by
+// busbar, in the order the busbar dispatches them, so a loaded grid packs
+// exactly like the one that was saved. Loading maps the file into memory and
+// builds the grid straight from the records.
+class GridSnapshot {
+public:
+    // Versions 1 (no ties), 2 (no curtailment), 3 (no costs) and 4 (no
+    // reactances) still load
+    static constexpr std::uint32_t VERSION = 5;
+
+private:
+    std::string lastError;
+
+public:
+    // Writes the grid in one pass. Returns false on I/O errors.
+    bool save(const Grid& grid, const std::string& path);
+
+    // Builds a new grid from a snapshot. Returns nullptr if the file is not a
+    // snapshot of a supported version or is damaged.
+    std::shared_ptr<Grid> load(const std::string& path);
+
+    const std::string& getLastError() const;
+
+    // Whether the file starts with the snapshot signature
+    static bool isSnapshotFile(const std::string& path);
+};
+
+#endif // GRID_SNAPSHOT_H
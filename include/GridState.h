@@ -0,0 +1,317 @@
+// GridState.h
+#ifndef GRID_STATE_H
+#define GRID_STATE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "Load.h"
+#include "PowerSource.h"
+#include "AllocationStrategy.h"
+#include "CowColumn.h"
+#include "PagedCowColumn.h"
+#include "MeritOrder.h"
+
+class Busbar;
+
+// Structure-of-arrays storage for everything the dispatch hot path touches.
+// Loads, sources and busbars are addressed by dense integer handles; the
+// Load/PowerSource objects handed out by Grid are thin views over these arrays.
+// Flags are stored one byte per entry (rather than packed bits) so that
+// different busbars can be written independently.
+//
+// The per-entity columns are copy-on-write, so fork() is cheap: a fork
+// shares every column with its origin until either of them writes to it.
+// The numeric columns are copied whole on their first write, since the
+// kernels need them contiguous; IDs and busbar member lists are paged, so
+// they copy only the pages an edit touches. Value edits in a branch
+// therefore copy a few columns of numbers, while adding or removing a load
+// or source also copies every numeric column of that entity kind
+// (BM_ForkStructuralEdit in grid_bench measures it).
+// Views are per state; a fork starts with none and Grid creates them on
+// demand.
+class GridState {
+public:
+    using Handle = std::size_t;
+    static constexpr Handle INVALID_HANDLE = static_cast<Handle>(-1);
+    static constexpr std::size_t PRIORITY_COUNT = 5;
+    // loadServed value of a load curtailment serves only in part
+    static constexpr std::uint8_t CURTAILED = 2;
+    using IdColumn = PagedCowColumn<std::string, 1024>;
+    using MemberColumn = PagedCowColumn<std::vector<Handle>, 8>;
+
+    // Load columns
+    CowColumn<double> loadDemand;
+    CowColumn<std::uint8_t> loadPriority;
+    CowColumn<std::uint8_t> loadType;
+    CowColumn<std::uint8_t> loadConnected;
+    CowColumn<std::uint8_t> loadServed;    // 0 shed, 1 served, or CURTAILED
+    CowColumn<double> loadServedKw;        // Only meaningful while CURTAILED
+    CowColumn<std::uint8_t> loadCurtailable;
+    CowColumn<Handle> loadBusbar;
+    IdColumn loadIds;
+    
+    // Load profile inputs: demand = base * scale * factor of the load's type
+    CowColumn<double> loadBaseDemand;
+    CowColumn<double> loadProfileScale;
+
+    // Source columns
+    CowColumn<double> sourceCapacity;
+    CowColumn<double> sourceCurrentLoad;
+    CowColumn<std::uint8_t> sourceOperational;
+    CowColumn<double> sourceMinOutput;
+    CowColumn<std::vector<CostSegment>> sourceCostCurve;
+    CowColumn<Handle> sourceBusbar;
+    IdColumn sourceIds;
+
+    // Busbar membership. Loads are kept ordered by priority (critical first,
+    // connection order within a priority) so dispatch never has to sort.
+    MemberColumn busbarLoads;
+    MemberColumn busbarSources;
+    IdColumn busbarIds;
+
+    GridState() = default;
+    GridState(const GridState&) = delete;
+    GridState& operator=(const GridState&) = delete;
+    ~GridState();
+    
+    // A logically independent copy sharing every column with this state
+    // (see CowColumn). The fork has no views bound; its allocation strategy
+    // is the same object as this state's.
+    std::unique_ptr<GridState> fork() const;
+    
+    // Views bound to the slots (nullptr if none)
+    Load* getLoadView(Handle load) const;
+    PowerSource* getSourceView(Handle source) const;
+    Busbar* getBusbarView(Handle busbar) const;
+    // Binds a new view to an existing slot, for views created on demand. The
+    // view's own values are not used; it must not be bound anywhere else.
+    void bindLoadView(Load* view, Handle load);
+    void bindSourceView(PowerSource* view, Handle source);
+    void bindBusbarView(Busbar* view, Handle busbar);
+    
+    // Slot of the entity with the ID (INVALID_HANDLE if none). The index is
+    // built on first use, shared with forks, and dropped whenever an entity
+    // is added or removed.
+    Handle findLoad(std::string_view id) const;
+    Handle findSource(std::string_view id) const;
+    Handle findBusbar(std::string_view id) const;
+    
+    // Entity lifecycle
+    Handle addBusbar(Busbar* view);
+    void removeBusbar(Handle busbar);
+    Handle addLoad(Load* view, Handle busbar);
+    // Bulk variant: appends without keeping the busbar's priority order;
+    // commitAppendedLoads restores it for every busbar touched, and must run
+    // before any other load edit or dispatch
+    Handle appendLoad(Load* view, Handle busbar);
+    void commitAppendedLoads();
+    void removeLoad(Handle load);
+    Handle addSource(PowerSource* view, Handle busbar);
+    void removeSource(Handle source);
+
+    void reserve(std::size_t busbarCount, std::size_t sourceCount, std::size_t loadCount);
+
+    std::size_t loadSlotCount() const;
+    std::size_t sourceSlotCount() const;
+    std::size_t busbarSlotCount() const;
+    bool isLoadSlotUsed(Handle load) const;
+    bool isSourceSlotUsed(Handle source) const;
+    bool isBusbarSlotUsed(Handle busbar) const;
+    
+    // Mutators that keep the running totals and dirty set up to date.
+    // setLoadDemand sets the base demand; once profiles are applied, the
+    // load's demand is that scaled by its current profile factor.
+    void setLoadDemand(Handle load, double demand);
+    void setLoadConnected(Handle load, bool connected);
+    void setLoadServed(Handle load, bool served);
+    void setLoadCurtailable(Handle load, bool curtailable);
+    void setLoadProfileInputs(Handle load, double baseDemand, double scale);
+    void setSourceCapacity(Handle source, double capacity);
+    void setSourceOperational(Handle source, bool operational);
+    void setSourceCurrentLoad(Handle source, double currentLoad);
+    void setSourceMinOutput(Handle source, double minOutput);
+    void setSourceCostCurve(Handle source, const std::vector<CostSegment>& curve);
+    
+    // Dirty busbar tracking: a busbar is dirty when any of its loads or
+    // sources changed since it was last dispatched.
+    void markBusbarDirty(Handle busbar);
+    bool isBusbarDirty(Handle busbar) const;
+    void markAllBusbarsDirty();
+    const std::vector<Handle>& getDirtyBusbars();
+    void clearDirtyBusbars();
+    
+    // Running totals, maintained as deltas by the mutators and kernels
+    double getTotalDemand() const;
+    double getServedDemand() const;
+    double getTotalSupply() const;
+    void recomputeTotals();
+    // Power the load is actually supplied: its demand when served, the
+    // curtailed share when CURTAILED, and 0 when shed or disconnected
+    double loadServedPower(Handle load) const;
+
+    // Recomputes every load's demand from its profile inputs and the given
+    // per-LoadType factors. Written as straight loops over the columns so the
+    // compiler can vectorize them. Returns false when nothing could have
+    // changed since the previous call with the same factors.
+    bool applyDemandFactors(const double* typeFactors, std::size_t typeCount);
+    
+    // Dispatch kernels
+    void resetAll();
+    // Takes private copies of the columns dispatch writes, if still shared
+    // with a fork, so that busbars can then be solved concurrently
+    void claimDispatchColumns();
+    // Serves the busbar's loads first-fit in priority order in a single pass,
+    // appending every connected load that could not be served to shed.
+    // Returns true when nothing was shed. When the busbar's first operational
+    // source can carry its whole demand, every load is placed on that source
+    // without probing or shedding (the allocation first-fit would make).
+    bool dispatchBusbar(Handle busbar, std::vector<Handle>& shed);
+    // The same kernel split in two for concurrent use: solveBusbar only
+    // writes the busbar's own loads and sources and returns the served
+    // demand, which commitBusbarServed then folds into the running totals.
+    // Concurrent calls need claimDispatchColumns first.
+    double solveBusbar(Handle busbar, std::vector<Handle>& shed);
+    void commitBusbarServed(Handle busbar, double served);
+    // Serves a connected, unserved load from the first source of another
+    // busbar with room for it (a transfer across bus ties), keeping the
+    // totals. The load's served demand still counts towards its own busbar.
+    bool serveFromBusbar(Handle load, Handle busbar);
+    // Packing strategy used by solveBusbar (nullptr is the built-in first-fit)
+    void setAllocationStrategy(const AllocationStrategy* strategy);
+    // Fractional curtailment, in place of the packing strategy: within each
+    // priority tier, loads that are not curtailable are packed whole first
+    // fit, then the curtailable ones share the busbar's remaining headroom
+    // by water-filling (each gets min(demand, level), the level set so the
+    // headroom is used up). A tier that fits is served in full as before.
+    // While it is on, the allocation strategy is not used.
+    void setCurtailment(bool enabled);
+    bool isCurtailmentEnabled() const;
+    // Economic dispatch: once a busbar's loads are placed, its sources'
+    // outputs are re-set to carry the same total at least cost, in merit
+    // order (see MeritOrder), so what is served does not change. The merit
+    // order is only kept while this is on.
+    void setEconomicDispatch(bool enabled);
+    bool isEconomicDispatchEnabled() const;
+    // Re-sets the busbar's source outputs that way; returns false, keeping
+    // the outputs dispatch gave them, when their minimum outputs cannot be
+    // honoured. Called by Grid after transfers, as transfers load sources.
+    bool redispatchEconomically(Handle busbar);
+    // Cost per hour of the sources' current outputs (as of the last
+    // economic dispatch while it is on), and a busbar's incremental cost
+    double getOperatingCost() const;
+    double busbarIncrementalCost(Handle busbar) const;
+    // The busbar's connected loads (priority order) and operational sources
+    // (full capacity) as a standalone packing problem
+    void buildAllocationProblem(Handle busbar, AllocationProblem& problem,
+                                std::vector<Handle>& loads, std::vector<Handle>& sources) const;
+    // Read-only variant for what-if studies: solves the busbar as if the
+    // listed sources were offline, using caller-provided scratch for source
+    // loading, and leaves the live allocation untouched.
+    double evaluateBusbar(Handle busbar, const Handle* outagedSources, std::size_t outagedCount,
+                          std::vector<double>& sourceLoadScratch, std::vector<Handle>& shed) const;
+
+    // Per-busbar aggregates, kept up to date by the mutators (and refreshed
+    // exactly whenever the busbar is solved), so reading them is O(1)
+    double busbarConnectedLoad(Handle busbar) const;
+    double busbarConnectedLoad(Handle busbar, Priority priority) const;
+    // Power served to the busbar's loads, including by transfer
+    double busbarServedPower(Handle busbar) const;
+    double busbarOperationalCapacity(Handle busbar) const;
+    bool isBusbarEnergized(Handle busbar) const;  // Any operational source
+    double busbarAvailablePower(Handle busbar) const;  // Walks the sources
+
+private:
+    // Views are never shared between states. In a fork these start empty
+    // and grow as views are bound, so they may be shorter than the columns.
+    std::vector<Load*> loadViews;
+    std::vector<PowerSource*> sourceViews;
+    std::vector<Busbar*> busbarViews;
+
+    // IDs to slots; the index keeps the ID columns it was built from
+    // alive, since its keys point into them
+    struct IdLookup {
+        IdColumn loadIds;
+        IdColumn sourceIds;
+        IdColumn busbarIds;
+        std::unordered_map<std::string_view, Handle> loads;
+        std::unordered_map<std::string_view, Handle> sources;
+        std::unordered_map<std::string_view, Handle> busbars;
+    };
+    mutable std::shared_ptr<const IdLookup> idLookup;
+    const IdLookup& lookup() const;
+
+    std::vector<Handle> freeLoads;
+    std::vector<Handle> freeSources;
+    std::vector<Handle> freeBusbars;
+    std::vector<std::uint8_t> busbarUsed;
+    std::vector<std::uint8_t> busbarDirty;
+    std::vector<Handle> dirtyBusbars;
+    std::vector<double> busbarServedDemand;
+    std::vector<double> busbarDemand;
+    std::vector<double> busbarPriorityDemand;  // PRIORITY_COUNT per busbar
+    std::vector<double> busbarCapacity;
+    std::vector<std::size_t> busbarOperationalSources;
+    
+    double totalDemand = 0.0;
+    double servedDemand = 0.0;
+    double totalSupply = 0.0;
+    
+    const AllocationStrategy* allocationStrategy = nullptr;
+    bool curtailment = false;
+    
+    bool economicDispatch = false;
+    MeritOrder meritOrder;
+    std::vector<double> busbarCost;
+    std::vector<double> busbarLambda;
+    double totalCost = 0.0;
+    
+    std::vector<double> lastTypeFactors;
+    bool profileInputsChanged = true;
+
+    double demandContribution(Handle load) const;
+    double servedContribution(Handle load) const;
+    double supplyContribution(Handle source) const;
+    // Busbars with appended loads not yet merged into priority order, and
+    // where each one's appended run starts (INVALID_HANDLE when none)
+    std::vector<Handle> appendedBusbars;
+    std::vector<std::size_t> appendedFrom;
+
+    // Fills a slot from the view and binds it, leaving the busbar member list
+    Handle allocateLoad(Load* view, Handle busbar);
+    // Detach an entity and free its slot, leaving the busbar member list
+    void releaseLoad(Handle load);
+    void releaseSource(Handle source);
+    // Copy the live values back into a bound view and unbind it
+    void unbindLoadView(Handle load);
+    void unbindSourceView(Handle source);
+    void beginLoadEdit(Handle load);
+    void endLoadEdit(Handle load);
+    void beginSourceEdit(Handle source);
+    void endSourceEdit(Handle source);
+    void recomputeBusbarDemand();
+    void storeBusbarDemand(Handle busbar, double connected, const double* tiers);
+    
+    // Counts probes if instrumented; writes through the given column data
+    bool firstFit(Handle load, Handle busbar, std::uint8_t* servedFlags, double* sourceLoading,
+                  std::uint64_t& probes);
+    // Zeroes the busbar's source loading, refreshing its capacity aggregates
+    void resetBusbarSources(Handle busbar);
+    // Source that would take every load of the busbar, or INVALID_HANDLE
+    Handle coveringSource(Handle busbar) const;
+    // Places every connected load on the source; false (with the busbar's
+    // loads half done) if they turn out not to fit after all
+    bool serveAllFrom(Handle busbar, Handle source, double& served);
+    double solveBusbarWithStrategy(Handle busbar, std::vector<Handle>& shed);
+    double solveBusbarCurtailed(Handle busbar, std::vector<Handle>& shed);
+    // Water-fills one tier's curtailable loads into what the busbar's
+    // operational sources have left; returns the power served
+    double curtailTier(Handle busbar, const std::vector<Handle>& loads, double wanted,
+                       std::uint8_t* servedFlags, double* sourceLoading, std::vector<Handle>& shed);
+};
+
+#endif // GRID_STATE_H
@@ -0,0 +1,158 @@
+// IdIndex.h
+#ifndef ID_INDEX_H
+#define ID_INDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Hash index of entities by their ID. The key is read from the entity
+// itself (T::getId()), so IDs are not copied. Entities are kept in a dense
+// array; the table is open-addressed (linear probing, backward-shift
+// deletion) and holds only 8-byte slots, so a lookup usually costs one
+// cache line in the table plus the entity.
+template <typename T>
+class IdIndex {
+private:
+    // A slot packs the upper 32 bits of the ID's hash with the entity's
+    // position in the dense array plus one; zero marks an empty slot
+    std::vector<std::uint64_t> slots;  // Size is zero or a power of two
+    std::vector<std::shared_ptr<T>> entities;
+
+    static std::uint64_t hashOf(const std::string& id) {
+        std::uint64_t hash = std::hash<std::string>()(id);
+        return hash ^ (hash >> 29);  // Mix the high bits into the probe start
+    }
+
+    static std::uint64_t makeSlot(std::uint64_t hash, std::size_t entry) {
+        return (hash & 0xFFFFFFFF00000000ull) | static_cast<std::uint64_t>(entry + 1);
+    }
+
+    static std::size_t entryOf(std::uint64_t slot) {
+        return static_cast<std::size_t>(slot & 0xFFFFFFFFull) - 1;
+    }
+
+    std::size_t mask() const {
+        return slots.size() - 1;
+    }
+
+    // Slot holding the ID, or the empty slot where it would go
+    std::size_t probe(const std::string& id, std::uint64_t hash) const {
+        std::uint64_t tag = hash & 0xFFFFFFFF00000000ull;
+        std::size_t slot = static_cast<std::size_t>(hash) & mask();
+        while (slots[slot] != 0 &&
+               ((slots[slot] & 0xFFFFFFFF00000000ull) != tag ||
+                entities[entryOf(slots[slot])]->getId() != id)) {
+            slot = (slot + 1) & mask();
+        }
+        return slot;
+    }
+
+    void rehash(std::size_t slotCount) {
+        slots.assign(slotCount, 0);
+        for (std::size_t entry = 0; entry < entities.size(); ++entry) {
+            std::uint64_t hash = hashOf(entities[entry]->getId());
+            std::size_t slot = static_cast<std::size_t>(hash) & mask();
+            while (slots[slot] != 0) {
+                slot = (slot + 1) & mask();
+            }
+            slots[slot] = makeSlot(hash, entry);
+        }
+    }
+
+public:
+    std::size_t size() const {
+        return entities.size();
+    }
+
+    // Sizes the table for a number of entities (kept at most 3/4 full)
+    void reserve(std::size_t entityCount) {
+        entities.reserve(entityCount);
+        std::size_t slotCount = 16;
+        while (slotCount * 3 < entityCount * 4) {
+            slotCount *= 2;
+        }
+        if (slotCount > slots.size()) {
+            rehash(slotCount);
+        }
+    }
+
+    std::shared_ptr<T> find(const std::string& id) const {
+        if (entities.empty()) {
+            return nullptr;
+        }
+        std::uint64_t slot = slots[probe(id, hashOf(id))];
+        return slot ? entities[entryOf(slot)] : nullptr;
+    }
+
+    // Adds the entity, replacing any other entity with the same ID
+    void insert(std::shared_ptr<T> entity) {
+        if ((entities.size() + 1) * 4 > slots.size() * 3) {
+            rehash(slots.empty() ? 16 : slots.size() * 2);
+        }
+        std::uint64_t hash = hashOf(entity->getId());
+        std::size_t slot = probe(entity->getId(), hash);
+        if (slots[slot]) {
+            entities[entryOf(slots[slot])] = std::move(entity);
+        } else {
+            slots[slot] = makeSlot(hash, entities.size());
+            entities.push_back(std::move(entity));
+        }
+    }
+
+    // Returns false if no entity has the ID
+    bool erase(const std::string& id) {
+        if (entities.empty()) {
+            return false;
+        }
+        std::size_t hole = probe(id, hashOf(id));
+        if (!slots[hole]) {
+            return false;
+        }
+
+        // Keep the entity array dense: the last entity takes the freed
+        // position, and its slot is pointed there
+        std::size_t entry = entryOf(slots[hole]);
+        if (entry + 1 != entities.size()) {
+            const std::string& movedId = entities.back()->getId();
+            std::uint64_t movedHash = hashOf(movedId);
+            slots[probe(movedId, movedHash)] = makeSlot(movedHash, entry);
+            entities[entry] = std::move(entities.back());
+        }
+        entities.pop_back();
+        slots[hole] = 0;
+
+        // Shift later slots of the probe run back into the hole, unless
+        // that would move them before their home slot
+        std::size_t next = (hole + 1) & mask();
+        while (slots[next] != 0) {
+            std::size_t home = static_cast<std::size_t>(hashOf(entities[entryOf(slots[next])]->getId())) & mask();
+            if (((next - home) & mask()) >= ((next - hole) & mask())) {
+                slots[hole] = slots[next];
+                slots[next] = 0;
+                hole = next;
+            }
+            next = (next + 1) & mask();
+        }
+        return true;
+    }
+
+    void clear() {
+        slots.clear();
+        entities.clear();
+    }
+
+    // Visits every entity, in no particular order
+    template <typename Visitor>
+    void forEach(Visitor&& visit) const {
+        for (const auto& entity : entities) {
+            visit(entity);
+        }
+    }
+};
+
+#endif // ID_INDEX_H
@@ -0,0 +1,144 @@
+// Instrumentation.h
+#ifndef INSTRUMENTATION_H
+#define INSTRUMENTATION_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+// Per-phase timers and event counters for the dispatch hot paths.
+//
+// Compiled in only when POWERGRID_INSTRUMENTATION is defined (the CMake
+// option ENABLE_INSTRUMENTATION); otherwise the timers and counters are
+// empty inline functions and cost nothing. Recording is thread-safe, so
+// busbars dispatched concurrently all contribute.
+namespace instrumentation {
+
+#ifdef POWERGRID_INSTRUMENTATION
+constexpr bool ENABLED = true;
+#else
+constexpr bool ENABLED = false;
+#endif
+
+enum class Phase {
+    DISPATCH,  // A whole Grid::distributeLoadOptimally or system-wide pass
+    RESET,     // Clearing source loading and served flags
+    SORT,      // Ordering loads by priority
+    ALLOCATE,  // Placing loads on sources (one busbar, or the whole system)
+    SHED,      // Recording and reporting shed loads
+    STATS,     // Folding results into the grid totals
+    TRANSFER,  // Serving shed loads across bus ties
+    ECONOMIC,  // Setting source outputs in merit order
+    POWER_FLOW,  // DC power flow over the bus ties
+    COUNT
+};
+
+enum class Counter {
+    SOURCE_PROBES,   // Capacity checks of a source against a load
+    ALLOCATIONS,     // Loads placed on a source
+    LOADS_SHED,
+    BUSBARS_SOLVED,
+    COVERED_BUSBARS, // Solved by the feasibility shortcut, without allocation
+    TRANSFERS,       // Loads served from another busbar across ties
+    FACTORIZATIONS,  // Power flow susceptance matrices factorized
+    COUNT
+};
+
+// Durations in power-of-two nanosecond buckets: bucket b holds durations in
+// [2^(b-1), 2^b) ns, bucket 0 only zero
+class Histogram {
+public:
+    static constexpr std::size_t BUCKETS = 48;
+
+private:
+    std::array<std::atomic<std::uint64_t>, BUCKETS> buckets{};
+    std::atomic<std::uint64_t> count{0};
+    std::atomic<std::uint64_t> totalNs{0};
+    std::atomic<std::uint64_t> maxNs{0};
+
+public:
+    void record(std::uint64_t ns);
+    void reset();
+
+    std::uint64_t getCount() const;
+    std::uint64_t getTotalNs() const;
+    std::uint64_t getMaxNs() const;
+    std::uint64_t getBucket(std::size_t bucket) const;
+    // Upper bound of the bucket holding the given fraction of samples
+    std::uint64_t percentileNs(double fraction) const;
+};
+
+void recordPhase(Phase phase, std::uint64_t ns);
+void addCount(Counter counter, std::uint64_t amount);
+
+const Histogram& getPhaseHistogram(Phase phase);
+std::uint64_t getCount(Counter counter);
+const char* phaseName(Phase phase);
+const char* counterName(Counter counter);
+
+void reset();
+
+// Counter totals, then per phase a summary line and the non-empty buckets
+void writeReport(std::ostream& out);
+
+inline void count(Counter counter, std::uint64_t amount = 1) {
+    if constexpr (ENABLED) {
+        addCount(counter, amount);
+    }
+}
+
+// Times a phase from construction to destruction or stop(); next() ends
+// the current phase and starts another with a single clock read
+class PhaseTimer {
+private:
+    Phase phase;
+    bool running;
+    std::chrono::steady_clock::time_point start;
+
+    void finish(std::chrono::steady_clock::time_point end) {
+        recordPhase(phase, static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count()));
+    }
+
+public:
+    explicit PhaseTimer(Phase phase) : phase(phase), running(true) {
+        if constexpr (ENABLED) {
+            start = std::chrono::steady_clock::now();
+        }
+    }
+
+    ~PhaseTimer() {
+        stop();
+    }
+
+    PhaseTimer(const PhaseTimer&) = delete;
+    PhaseTimer& operator=(const PhaseTimer&) = delete;
+
+    void next(Phase nextPhase) {
+        if constexpr (ENABLED) {
+            auto now = std::chrono::steady_clock::now();
+            if (running) {
+                finish(now);
+            }
+            start = now;
+        }
+        phase = nextPhase;
+        running = true;
+    }
+
+    void stop() {
+        if constexpr (ENABLED) {
+            if (running) {
+                finish(std::chrono::steady_clock::now());
+            }
+        }
+        running = false;
+    }
+};
+
+} // namespace instrumentation
+
+#endif // INSTRUMENTATION_H
@@ -3,6 +3,8 @@
 #define LOAD_H
 
 #include <string>
+#include <string_view>
+#include <cstddef>
 
 // Enum for different load types
 enum class LoadType {
@@ -21,6 +23,20 @@ enum class Priority {
     MINIMAL = 5    // First to be shed (e.g., decorative lighting)
 };
 
+// Parse the names used in scenario and import files, ignoring case: types
+// RESIDENTIAL, COMMERCIAL, INDUSTRIAL or CRITICAL; priorities CRITICAL, HIGH,
+// MEDIUM, LOW or MINIMAL (or 1-5). Return false for anything else.
+bool parseLoadType(std::string_view text, LoadType& type);
+bool parsePriority(std::string_view text, Priority& priority);
+
+// Names as parseLoadType reads them ("RESIDENTIAL"), and as reports show
+// them ("Residential", "Critical (1)")
+const char* loadTypeName(LoadType type);
+const char* loadTypeDisplayName(LoadType type);
+const char* priorityDisplayName(Priority priority);
+
+class GridState;
+
 class Load {
 private:
     std::string id;
@@ -29,24 +45,52 @@ private:
     Priority priority;
     bool isConnected;    // Whether the load is currently connected
     bool isServed;       // Whether the load is currently being supplied power
+    double baseDemand;   // Nominal demand the load profile is applied to, in kW
+    double profileScale; // Per-load multiplier on the load type's profile
+    bool curtailable;    // Whether curtailment may serve part of the demand
+    double servedPower;  // Power actually supplied, in kW
+    
+    // Once attached to a grid, the fields above are only used while detached;
+    // the live values are held in the grid's state arrays.
+    GridState* state;
+    std::size_t handle;
+    
+    std::size_t busbarSlot;  // Position in the owning busbar's connection list
+    
+    friend class GridState;
+    friend class GridSnapshot;
+    friend class Busbar;
 
 public:
     // Constructor
     Load(const std::string& id, double powerDemand, LoadType type, Priority priority);
     
     // Getters
-    std::string getId() const;
+    const std::string& getId() const;
     double getPowerDemand() const;
     LoadType getType() const;
     Priority getPriority() const;
     bool isLoadConnected() const;
     bool isLoadServed() const;
+    double getBaseDemand() const;
+    double getProfileScale() const;
+    bool isCurtailable() const;
+    // Demand when served, less when curtailed, 0 when shed or disconnected
+    double getServedPower() const;
     
     // Setters
+    // Sets the base demand, which load profiles (if any) then scale
     void setPowerDemand(double demand);
     void connect();
     void disconnect();
     void setServed(bool served);
+    void setBaseDemand(double demand);
+    void setProfileScale(double scale);
+    void setCurtailable(bool curtailable);
+    
+    // Grid state binding
+    bool isAttached() const;
+    std::size_t getHandle() const;
     
     // Utility functions
     std::string getTypeString() const;
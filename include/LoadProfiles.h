@@ -0,0 +1,36 @@
+// LoadProfiles.h
+#ifndef LOAD_PROFILES_H
+#define LOAD_PROFILES_H
+
+#include <cstddef>
+#include <vector>
+#include "Load.h"
+
+// Demand multipliers per LoadType over a repeating cycle of intervals
+// (by default one day of 15-minute intervals). All curves share one
+// contiguous table, laid out type-major.
+class LoadProfiles {
+public:
+    static constexpr std::size_t LOAD_TYPE_COUNT = 4;
+    static constexpr std::size_t DEFAULT_INTERVALS = 96;
+
+private:
+    std::size_t intervals;
+    std::vector<double> factors;  // LOAD_TYPE_COUNT * intervals
+
+public:
+    // Constructor (all curves start flat at 1.0)
+    explicit LoadProfiles(std::size_t intervals = DEFAULT_INTERVALS);
+    
+    // Getters
+    std::size_t getIntervalCount() const;
+    double getFactor(LoadType type, std::size_t interval) const;
+    
+    // Setters (returns false if the curve length does not match)
+    bool setCurve(LoadType type, const std::vector<double>& curve);
+    
+    // Fills one factor per LoadType for the interval a step falls into
+    void getFactorsForStep(long long step, double (&out)[LOAD_TYPE_COUNT]) const;
+};
+
+#endif // LOAD_PROFILES_H
@@ -0,0 +1,81 @@
+// MeritOrder.h
+#ifndef MERIT_ORDER_H
+#define MERIT_ORDER_H
+
+#include <cstddef>
+#include <vector>
+
+class GridState;
+
+// Economic dispatch of each busbar's sources. An operational source runs at
+// least at its minimum stable output; its capacity above that is cut into
+// the segments of its piecewise-linear cost curve, and each busbar keeps its
+// segments sorted by incremental cost (its merit order) with running sums of
+// their widths and costs. Meeting a demand at least cost is then a search
+// for the incremental cost (lambda) at which the cumulative width covers it:
+// a binary search over the sums, then a walk over the segments below it to
+// set the outputs.
+//
+// The order is maintained in place: a change to one source moves only that
+// source's segments, and the sums are refreshed lazily from the first
+// position that moved. When the demand is below the busbar's total minimum
+// output, sources are committed cheapest first instead (a priority list,
+// not an optimal unit commitment) and the rest are left off.
+class MeritOrder {
+public:
+    using Handle = std::size_t;
+
+    struct Dispatch {
+        double costPerHour;
+        double lambda;  // Incremental cost of the last kW dispatched
+    };
+
+private:
+    struct Segment {
+        double cost;  // Per kWh
+        double widthKw;
+        Handle source;
+        std::size_t piece;  // Position in the source's curve, to break cost ties
+    };
+
+    struct BusbarOrder {
+        std::vector<Segment> segments;  // In merit order
+        std::vector<double> widthSums;  // Inclusive prefix sums, valid below sumsValid
+        std::vector<double> costSums;
+        std::size_t sumsValid = 0;
+    };
+
+    std::vector<BusbarOrder> busbars;
+    // Minimum output of each source as placed (0 when not operational), and
+    // its cost; summed per dispatch rather than kept as running totals
+    std::vector<double> sourceMinOutput;
+    std::vector<double> sourceMinCost;
+    std::vector<Segment> placed;  // Scratch for updateSource
+
+    static bool before(const Segment& a, const Segment& b);
+    BusbarOrder& orderOf(Handle busbar);
+    // Appends the source's segments (none when it is not operational) and
+    // records its minimum output and the cost of it
+    void place(const GridState& state, Handle source, std::vector<Segment>& segments);
+    void refreshSums(BusbarOrder& order);
+    // Runs below the total minimum output: commits sources by their cost at
+    // minimum output while their minimums still fit under the demand
+    bool commitAndDispatch(const GridState& state, Handle busbar, double demand, double* outputs,
+                           Dispatch& result) const;
+
+public:
+    void clear();
+    // Every source in the state, from scratch
+    void rebuild(const GridState& state);
+    // Re-places the source after a change to its capacity, status, minimum
+    // output or curve (or its arrival on the busbar)
+    void updateSource(const GridState& state, Handle source);
+    void removeSource(Handle busbar, Handle source);
+
+    // Sets the outputs of the busbar's sources (indexed by source handle) to
+    // meet the demand at least cost. Returns false, leaving the outputs
+    // untouched, if no set of running sources can meet it.
+    bool dispatch(const GridState& state, Handle busbar, double demand, double* outputs, Dispatch& result);
+};
+
+#endif // MERIT_ORDER_H
@@ -0,0 +1,99 @@
+// ModelImporter.h
+#ifndef MODEL_IMPORTER_H
+#define MODEL_IMPORTER_H
+
+#include <array>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+#include "Grid.h"
+
+// Streams load and source records from asset exports into a grid.
+//
+// Two formats are read, one record per line:
+//   CSV         a header line names the columns, e.g.
+//                 id,kw,type,priority,busbar      (loads)
+//                 id,capacity,busbar              (sources)
+//   JSON lines  one flat object per line, keyed by the same column names,
+//               e.g. {"id":"L1","kw":12.5,"type":"RESIDENTIAL","priority":3,"busbar":"B1"}
+// Files ending in .jsonl or .ndjson, or whose first record starts with '{',
+// are read as JSON lines. Recognized columns (in any case) are id, kind
+// (load or source), kw or demand_kw, capacity or capacity_kw, type,
+// priority and busbar; others are ignored. Without a kind, records with a
+// capacity are sources and the rest loads. Busbars are created on first
+// use. Blank lines and lines starting with '#' are skipped; quoted CSV
+// fields may not span lines. A negative kw or capacity, or an id already
+// given to a load (or source) earlier in the file, is an error.
+//
+// The file is read in fixed-size chunks and fields are parsed in place, so
+// only the entities themselves are allocated. Records are committed to the
+// grid in batches through its bulk insert API.
+class ModelImporter {
+public:
+    static constexpr std::size_t DEFAULT_BATCH_SIZE = 65536;
+
+private:
+    enum Column {
+        ID,
+        KIND,
+        DEMAND,
+        CAPACITY,
+        TYPE,
+        PRIORITY,
+        BUSBAR,
+        COLUMN_COUNT,
+        IGNORED = COLUMN_COUNT
+    };
+
+    using Record = std::array<std::string_view, COLUMN_COUNT>;
+
+    Grid& grid;
+    std::size_t batchSize;
+    std::string lastError;
+    std::size_t loadCount;
+    std::size_t sourceCount;
+    std::size_t busbarCount;
+
+    // Per-file parsing state
+    bool jsonLines;
+    bool started;                    // Whether the format and header are known
+    std::vector<Column> csvColumns;  // Column of each CSV field position
+    // Unescaped copies of quoted fields, reused from record to record
+    std::array<std::string, COLUMN_COUNT> unescaped;
+    std::string scratch;             // Same, for keys and ignored fields
+    // IDs imported from the file so far, viewing the entities' own IDs
+    std::unordered_set<std::string_view> loadIds;
+    std::unordered_set<std::string_view> sourceIds;
+
+    std::vector<Grid::LoadPlacement> pendingLoads;
+    std::vector<Grid::SourcePlacement> pendingSources;
+    Busbar* lastBusbar;  // Exports are usually grouped by busbar
+
+    static Column columnFor(std::string_view name);
+
+    bool parseLine(std::string_view line);
+    bool parseCsvHeader(std::string_view line);
+    bool parseCsvRecord(std::string_view line, Record& record);
+    bool parseJsonRecord(std::string_view line, Record& record);
+    bool addRecord(const Record& record);
+    Busbar* busbarFor(std::string_view busbarId);
+    void commit();
+
+public:
+    explicit ModelImporter(Grid& grid, std::size_t batchSize = DEFAULT_BATCH_SIZE);
+
+    // Adds every record of the file to the grid. On failure, the records
+    // before the offending line have been added.
+    bool importFile(const std::string& path);
+
+    const std::string& getLastError() const;
+
+    // Totals over every file imported so far
+    std::size_t getLoadCount() const;
+    std::size_t getSourceCount() const;
+    std::size_t getBusbarCount() const;  // Busbars created by the importer
+};
+
+#endif // MODEL_IMPORTER_H
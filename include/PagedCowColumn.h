@@ -0,0 +1,68 @@
+// PagedCowColumn.h
+#ifndef PAGED_COW_COLUMN_H
+#define PAGED_COW_COLUMN_H
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+// A copy-on-write column split into fixed-size pages, for columns whose
+// entries are costly to copy (strings, member lists). Copies of a state
+// share every page; writing an entry through edit() first takes a private
+// copy of just the page holding it, so a branch that adds or removes one
+// entity copies PAGE_SIZE entries rather than the whole column.
+//
+// Entries are not contiguous, so kernels that need a data pointer use
+// CowColumn instead. As with CowColumn, edit() is not safe to call
+// concurrently on a shared page.
+template <typename T, std::size_t PAGE_SIZE>
+class PagedCowColumn {
+private:
+    using Page = std::vector<T>;
+    std::vector<std::shared_ptr<Page>> pages;
+    std::size_t count = 0;
+
+    Page& ownPage(std::size_t page) {
+        std::shared_ptr<Page>& values = pages[page];
+        if (values.use_count() > 1) {
+            auto copy = std::make_shared<Page>();
+            copy->reserve(PAGE_SIZE);
+            copy->assign(values->begin(), values->end());
+            values = std::move(copy);
+        }
+        return *values;
+    }
+
+public:
+    const T& operator[](std::size_t i) const {
+        return (*pages[i / PAGE_SIZE])[i % PAGE_SIZE];
+    }
+
+    std::size_t size() const {
+        return count;
+    }
+
+    bool empty() const {
+        return count == 0;
+    }
+
+    T& edit(std::size_t i) {
+        return ownPage(i / PAGE_SIZE)[i % PAGE_SIZE];
+    }
+
+    // Pages are reserved in full, so appending never moves earlier entries
+    T& emplace_back() {
+        if (count % PAGE_SIZE == 0) {
+            pages.push_back(std::make_shared<Page>());
+            pages.back()->reserve(PAGE_SIZE);
+        }
+        ++count;
+        return ownPage(pages.size() - 1).emplace_back();
+    }
+
+    void reserve(std::size_t n) {
+        pages.reserve((n + PAGE_SIZE - 1) / PAGE_SIZE);
+    }
+};
+
+#endif // PAGED_COW_COLUMN_H
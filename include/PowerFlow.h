@@ -0,0 +1,71 @@
+// PowerFlow.h
+#ifndef POWER_FLOW_H
+#define POWER_FLOW_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "GridState.h"
+#include "Topology.h"
+
+// DC power flow over the closed bus ties. Dispatch decides what each busbar
+// injects (its sources' output less the power its loads are served); how
+// that power then divides over a meshed tie network follows from the ties'
+// reactances, and may load a tie past its limit even when every transfer
+// routed by dispatch fitted.
+//
+// With B the susceptance matrix of the closed ties (1 / reactance per tie)
+// and one reference busbar per tie-connected group fixed at angle 0, the
+// busbar angles solve B * angles = P and each tie carries
+// (angle of 'from' - angle of 'to') / reactance.
+// B only depends on which ties are closed, so it is factorized once (a
+// sparse Cholesky factor, rows in minimum degree order to keep fill low)
+// and each solve is a forward and a backward substitution over the factor;
+// it is refactorized only when the topology's revision changes. The factor
+// is never changed in place, so forks share it until one of them
+// refactorizes.
+class PowerFlow {
+public:
+    using Handle = GridState::Handle;
+    static constexpr std::size_t NONE = static_cast<std::size_t>(-1);
+    // Flow beyond a tie's limit by less than this is rounding (kW)
+    static constexpr double OVERLOAD_TOLERANCE = 1e-6;
+
+private:
+    struct Factor {
+        std::uint64_t revision;
+        std::vector<std::size_t> rowOf;  // Per busbar slot; NONE if a reference or untied
+        std::vector<Handle> busbarOf;    // Per row
+        // Lower triangle by column, diagonal first, then rows ascending
+        std::vector<std::size_t> columnStart;
+        std::vector<std::size_t> rowIndex;
+        std::vector<double> values;
+    };
+
+    std::shared_ptr<const Factor> factor;
+    std::vector<double> angles;  // Per row
+    std::vector<double> flows;   // Per tie slot
+    std::size_t overloads;
+    double maxLoadingPercent;
+
+    static std::shared_ptr<const Factor> factorize(const Topology& topology, std::size_t busbarSlots);
+
+public:
+    PowerFlow();
+
+    // Solves for the busbars' current injections and stores every tie's
+    // flow in the topology, refactorizing first if the ties changed
+    void solve(const GridState& state, Topology& topology);
+    // Drops the factor and the results
+    void clear();
+
+    // Closed ties whose flow exceeds their limit, as of the last solve
+    std::size_t getOverloadCount() const;
+    // Highest flow on any closed tie as a percentage of its limit
+    double getMaxLoadingPercent() const;
+    // Non-zeros in the factor (0 before the first solve)
+    std::size_t getFactorSize() const;
+};
+
+#endif // POWER_FLOW_H
@@ -4,35 +4,78 @@
 
 #include <string>
 #include <vector>
+#include <cstddef>
 #include "Load.h"
 
+class GridState;
+
+// One piece of a piecewise-linear cost curve: output up to upToKw (from the
+// previous segment's end, or 0) costs costPerKwh per kWh. The last segment
+// extends to the source's capacity, and an empty curve costs nothing.
+struct CostSegment {
+    double upToKw;
+    double costPerKwh;
+};
+
+// Cost per hour of running at the output, and the cost of the next kW from
+// it (the incremental cost), under the curve
+double operatingCost(const std::vector<CostSegment>& curve, double outputKw);
+double incrementalCost(const std::vector<CostSegment>& curve, double outputKw);
+// Whether the breakpoints increase and the costs never fall, as merit order
+// needs convex costs
+bool isConvexCostCurve(const std::vector<CostSegment>& curve);
+
 class PowerSource {
 private:
     std::string id;
     double capacity;         // Maximum power in kW
     double currentLoad;      // Current load in kW
     bool operational;        // Whether the source is operational
+    double minOutput;        // Minimum stable output while running, in kW
+    std::vector<CostSegment> costCurve;  // Breakpoints increasing, costs non-decreasing
+    
+    // Live values are held in the grid's state arrays once attached
+    GridState* state;
+    std::size_t handle;
+    
+    std::size_t busbarSlot;  // Position in the owning busbar's connection list
+    
+    friend class GridState;
+    friend class GridSnapshot;
+    friend class Busbar;
 
 public:
     // Constructor
     PowerSource(const std::string& id, double capacity);
     
     // Getters
-    std::string getId() const;
+    const std::string& getId() const;
     double getCapacity() const;
     double getCurrentLoad() const;
     double getAvailableCapacity() const;
     bool isOperational() const;
+    double getMinOutput() const;
+    const std::vector<CostSegment>& getCostCurve() const;
+    double getMarginalCost() const;   // Incremental cost at the current output
+    double getOperatingCost() const;  // Per hour, at the current output
     
     // Setters
     void setCapacity(double newCapacity);
     void setOperational(bool isOperational);
+    void setMinOutput(double kw);
+    void setMarginalCost(double costPerKwh);  // A flat curve
+    // Returns false (and changes nothing) unless the curve is convex
+    bool setCostCurve(const std::vector<CostSegment>& curve);
     
     // Operation functions
     bool canSupplyPower(double requestedPower) const;
     bool addLoad(double power);
     void removeLoad(double power);
     void resetLoading();
+    
+    // Grid state binding
+    bool isAttached() const;
+    std::size_t getHandle() const;
 };
 
 #endif // POWER_SOURCE_H
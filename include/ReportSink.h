@@ -0,0 +1,203 @@
+// ReportSink.h
+#ifndef REPORT_SINK_H
+#define REPORT_SINK_H
+
+#include <cstddef>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include "Load.h"
+
+// Rows of a grid report. Strings point into the grid and are only valid for
+// the duration of the call that receives them.
+struct BusbarReportRow {
+    std::string_view id;
+    bool energized;
+    double connectedLoadKw;
+    double availablePowerKw;
+};
+
+struct TieReportRow {
+    std::string_view id;
+    std::string_view fromBusbarId;
+    std::string_view toBusbarId;
+    bool closed;
+    double limitKw;
+    double flowKw;  // Positive from the first busbar to the second
+};
+
+// A closed tie's flow from the DC power flow
+struct PowerFlowReportRow {
+    std::string_view tieId;
+    std::string_view fromBusbarId;
+    std::string_view toBusbarId;
+    double flowKw;  // Positive from the first busbar to the second
+    double limitKw;
+    double loadingPercent;  // Of the limit
+    bool overloaded;
+};
+
+struct SourceReportRow {
+    std::string_view id;
+    std::string_view busbarId;
+    bool operational;
+    double capacityKw;
+    double currentLoadKw;
+    double availableKw;
+};
+
+struct LoadReportRow {
+    std::string_view id;
+    std::string_view busbarId;
+    LoadType type;
+    Priority priority;
+    double demandKw;
+    bool connected;
+    bool served;
+    double servedKw;  // Less than the demand when curtailed
+};
+
+struct ReportSummary {
+    std::string_view gridName;
+    double totalSupplyKw;
+    double totalDemandKw;
+    double servedKw;
+    double shedKw;
+};
+
+// A load shed by a dispatch
+struct ShedReportRow {
+    long long step;
+    std::string_view loadId;
+    std::string_view busbarId;  // Empty when shed by system-wide shedding
+    LoadType type;
+    Priority priority;
+    double demandKw;
+};
+
+enum class ReportSection {
+    BUSBARS,
+    TIES,        // Only for grids with bus ties
+    POWER_FLOW,  // Only with the power flow enabled and closed ties
+    SOURCES,
+    LOADS
+};
+
+// Destination for grid reports and shed events. Output is formatted into an
+// in-memory buffer and handed to the stream in large writes: when the
+// buffer fills, on flush() and on destruction. A report arrives as
+// beginReport, then each section's beginSection and rows, then endReport.
+class ReportSink {
+public:
+    static constexpr std::size_t DEFAULT_BUFFER_SIZE = 1 << 16;
+
+private:
+    std::ostream& out;
+    std::string buffer;
+    std::size_t bufferSize;
+
+protected:
+    void write(std::string_view text);
+    void write(char c);
+    // Shortest text that reads back as the same value
+    void writeNumber(double value);
+    // As an ostream prints it by default (6 significant digits)
+    void writeDefaultNumber(double value);
+    void writeInteger(long long value);
+    // Left-aligned in a field, like std::left with std::setw
+    void writePadded(std::string_view text, std::size_t width);
+    void writePaddedNumber(double value, std::size_t width);
+
+public:
+    explicit ReportSink(std::ostream& out, std::size_t bufferSize = DEFAULT_BUFFER_SIZE);
+    virtual ~ReportSink();
+
+    ReportSink(const ReportSink&) = delete;
+    ReportSink& operator=(const ReportSink&) = delete;
+
+    virtual void beginReport(std::string_view gridName) = 0;
+    virtual void beginSection(ReportSection section) = 0;
+    virtual void busbar(const BusbarReportRow& row) = 0;
+    virtual void tie(const TieReportRow& row) = 0;
+    virtual void powerFlow(const PowerFlowReportRow& row) = 0;
+    virtual void source(const SourceReportRow& row) = 0;
+    virtual void load(const LoadReportRow& row) = 0;
+    virtual void endReport(const ReportSummary& summary) = 0;
+    virtual void shed(const ShedReportRow& row) = 0;
+
+    void flush();
+
+    // Builds a sink from a format name: "table", "csv" or "jsonl". Returns
+    // nullptr for unknown names.
+    static std::unique_ptr<ReportSink> create(const std::string& format, std::ostream& out);
+    // Format for an output file: "csv" for .csv, "jsonl" for .jsonl or
+    // .ndjson, otherwise "table"
+    static std::string formatForPath(const std::string& path);
+};
+
+// The console layout: fixed-width tables and one line per shed load
+class TableReportSink : public ReportSink {
+public:
+    using ReportSink::ReportSink;
+
+    void beginReport(std::string_view gridName) override;
+    void beginSection(ReportSection section) override;
+    void busbar(const BusbarReportRow& row) override;
+    void tie(const TieReportRow& row) override;
+    void powerFlow(const PowerFlowReportRow& row) override;
+    void source(const SourceReportRow& row) override;
+    void load(const LoadReportRow& row) override;
+    void endReport(const ReportSummary& summary) override;
+    void shed(const ShedReportRow& row) override;
+};
+
+// One CSV row per record, all under a single header:
+//   record,step,id,busbar,status,type,priority,capacity_kw,demand_kw,served_kw,available_kw
+// where record is busbar, tie, flow, source, load, summary or shed; fields
+// that do not apply to a record are left empty. A tie's busbar is
+// "<from>><to>", its capacity the transfer limit and its served kW the flow
+// in that direction; a flow record gives the same for the power flow, with
+// status ok or overloaded.
+class CsvReportSink : public ReportSink {
+private:
+    bool headerWritten;
+
+    void writeField(std::string_view text);
+    void beginRow(std::string_view record);
+
+public:
+    explicit CsvReportSink(std::ostream& out, std::size_t bufferSize = DEFAULT_BUFFER_SIZE);
+
+    void beginReport(std::string_view gridName) override;
+    void beginSection(ReportSection section) override;
+    void busbar(const BusbarReportRow& row) override;
+    void tie(const TieReportRow& row) override;
+    void powerFlow(const PowerFlowReportRow& row) override;
+    void source(const SourceReportRow& row) override;
+    void load(const LoadReportRow& row) override;
+    void endReport(const ReportSummary& summary) override;
+    void shed(const ShedReportRow& row) override;
+};
+
+// One JSON object per line, with a "record" key naming its kind
+class JsonLinesReportSink : public ReportSink {
+private:
+    void writeString(std::string_view text);
+    void writeKey(std::string_view key);  // Also writes the separator
+
+public:
+    using ReportSink::ReportSink;
+
+    void beginReport(std::string_view gridName) override;
+    void beginSection(ReportSection section) override;
+    void busbar(const BusbarReportRow& row) override;
+    void tie(const TieReportRow& row) override;
+    void powerFlow(const PowerFlowReportRow& row) override;
+    void source(const SourceReportRow& row) override;
+    void load(const LoadReportRow& row) override;
+    void endReport(const ReportSummary& summary) override;
+    void shed(const ShedReportRow& row) override;
+};
+
+#endif // REPORT_SINK_H
@@ -0,0 +1,108 @@
+// Scenario.h
+#ifndef SCENARIO_H
+#define SCENARIO_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include "Grid.h"
+#include "EventQueue.h"
+#include "Load.h"
+#include "LoadProfiles.h"
+
+// A grid definition plus a script of timed events, read from a plain text file.
+//
+// Each non-empty line that does not start with '#' is one record:
+//   grid <name>
+//   busbar <id>
+//   tie <id> <busbar id> <busbar id> <transfer limit kW> [open] [reactance <per unit>]
+//   source <id> <capacity kW> <busbar id> [min <kW>] [cost <per kWh>]
+//   curve <source id> <up to kW> <cost per kWh> ...   (a piecewise-linear cost)
+//   load <id> <demand kW> <type> <priority> <busbar id> [curtailable]
+//   profile <type> <factor> <factor> ...   (one factor per interval)
+//   scale <load id> <factor>
+//   at <step> demand <load id> <kW>
+//   at <step> capacity <source id> <kW>
+//   at <step> trip <source id>
+//   at <step> restore <source id>
+//   at <step> connect <load id>
+//   at <step> disconnect <load id>
+//   at <step> open <tie id>
+//   at <step> close <tie id>
+// Types are RESIDENTIAL, COMMERCIAL, INDUSTRIAL or CRITICAL; priorities are
+// CRITICAL, HIGH, MEDIUM, LOW or MINIMAL (or 1-5), in any case. All profiles must
+// have the same number of intervals; each simulation step advances one interval.
+// A source's min is its minimum stable output and cost a flat cost per kWh;
+// a curve's costs must not fall as its breakpoints rise. A tie's reactance
+// (1 unless given) only matters to the power flow.
+class Scenario {
+public:
+    using EventType = GridEvent::Type;
+    using Event = GridEvent;  // The step is the event's time
+
+private:
+    struct BusbarSpec {
+        std::string id;
+    };
+
+    struct TieSpec {
+        std::string id;
+        std::string fromBusbarId;
+        std::string toBusbarId;
+        double limit;
+        bool closed;
+        double reactance;
+    };
+
+    struct SourceSpec {
+        std::string id;
+        double capacity;
+        std::string busbarId;
+        double minOutput;
+        std::vector<CostSegment> costCurve;
+    };
+
+    struct LoadSpec {
+        std::string id;
+        double demand;
+        LoadType type;
+        Priority priority;
+        std::string busbarId;
+        bool curtailable;
+    };
+
+    std::string gridName;
+    std::vector<BusbarSpec> busbars;
+    std::vector<TieSpec> ties;
+    std::vector<SourceSpec> sources;
+    std::vector<LoadSpec> loads;
+    std::map<LoadType, std::vector<double>> profiles;
+    std::map<std::string, double> profileScales;
+    std::map<std::string, std::vector<CostSegment>> costCurves;
+    std::vector<Event> events;    // Sorted by step once loaded
+    std::size_t nextEvent;
+    std::string lastError;
+
+    bool parseLine(const std::string& line);
+
+public:
+    // Constructor
+    Scenario();
+
+    // Loading
+    bool loadFromFile(const std::string& path);
+    const std::string& getLastError() const;
+
+    // Getters
+    std::string getGridName() const;
+    std::size_t getEventCount() const;
+
+    // Grid construction and event playback
+    void buildGrid(Grid& grid) const;
+    int applyEvents(Grid& grid, int step);  // Returns the number of events applied
+    void rewind();
+    // Hands every event to a discrete-event queue instead
+    void scheduleEvents(EventQueue& queue) const;
+};
+
+#endif // SCENARIO_H
@@ -2,15 +2,29 @@
 #ifndef SIMULATOR_H
 #define SIMULATOR_H
 
+#include <functional>
 #include <memory>
 #include <string>
+#include <vector>
 #include "Grid.h"
+#include "Scenario.h"
+#include "EventQueue.h"
 
 class Simulator {
 private:
     std::shared_ptr<Grid> grid;
     int currentTimeStep;
     bool running;
+    std::shared_ptr<ThreadPool> dispatchPool;                // nullptr dispatches serially
+    std::shared_ptr<AllocationStrategy> allocationStrategy;  // nullptr is first-fit
+    bool curtailment;                      // Partial service of curtailable loads
+    bool economicDispatch;                 // Least-cost source outputs
+    bool powerFlow;                        // DC power flow over the ties
+    std::vector<std::string> importPaths;  // Asset exports added to every loaded grid
+    std::string reportPath;                // Batch event and final report, if any
+    EventQueue events;
+    EventQueue::Time currentTime;          // Clock of the event-driven engine
+    bool eventDriven;                      // Batch runs re-solve only when events fire
     
     // Helper methods for CLI
     void displayMenu() const;
@@ -19,20 +33,72 @@ private:
     void addSourceInteractive();
     void modifySourceInteractive();
     void simulationStep();
+    void advanceStep();  // Advances time and re-dispatches without any output
+    void configureGrid();  // Applies the dispatch settings to the current grid
+    // Replaces the grid with one read from a scenario or snapshot file (a
+    // snapshot leaves the scenario without events), then adds the import
+    // files; with no path the grid holds just the imports. Prints errors.
+    bool loadGrid(const std::string& path, Scenario& scenario);
 
 public:
     // Constructor
     Simulator();
     
     // Simulation control
+    void setDispatchThreads(std::size_t threads);  // 1 is serial, 0 uses every core
+    void setAllocationStrategy(std::shared_ptr<AllocationStrategy> strategy);
+    void setCurtailment(bool enabled);  // See Grid::setCurtailment
+    // See Grid::setEconomicDispatch; batch CSV rows then add the cost per hour
+    void setEconomicDispatch(bool enabled);
+    // See Grid::setPowerFlow; batch CSV rows then add the overloaded ties
+    // and the highest tie loading
+    void setPowerFlow(bool enabled);
+    void setImportFiles(const std::vector<std::string>& paths);  // CSV or JSON-lines exports
+    // Batch runs also write each step's shed loads and a final grid report
+    // here, as a table, CSV (.csv) or JSON lines (.jsonl)
+    void setReportFile(const std::string& path);
+    // Batch runs normally re-dispatch every step; event-driven runs apply
+    // the scenario's events through the event queue instead and write a
+    // CSV row only for the steps where something happened
+    void setEventDriven(bool enabled);
     void setupDefaultScenario();
     void run();
     void pause();
     void stop();
     
+    // Discrete-event engine. Scheduled events are applied in time order and
+    // the grid is re-dispatched once per distinct event time, so quiet
+    // stretches cost nothing. Events scheduled in the past fire at the
+    // current time.
+    void schedule(GridEvent event);
+    // Applies every event due up to and including 'time', then moves the
+    // clock there. afterDispatch(time), if given, runs after each re-solve.
+    // Returns the number of re-solves.
+    std::size_t runUntil(EventQueue::Time time, 
+                         const std::function<void(EventQueue::Time)>& afterDispatch = nullptr);
+    EventQueue::Time getCurrentTime() const;
+    
     // User interaction through CLI
     void processUserInput();
     void runInteractiveSimulation();
+    
+    // Headless batch and study modes take either a scenario file or a grid
+    // snapshot written by saveSnapshot, plus any import files (the path may
+    // be empty when there are imports).
+    //
+    // Headless batch mode: loads a scenario, runs the given number of steps
+    // and writes per-step statistics as CSV. Returns a process exit code.
+    int runBatchSimulation(const std::string& scenarioPath, int steps, 
+                           const std::string& outputPath);
+    
+    // Headless N-k contingency study of a scenario's grid (samples = 0
+    // enumerates every outage set). Writes one CSV row per contingency.
+    int runContingencyAnalysis(const std::string& scenarioPath, std::size_t outageSize,
+                               std::size_t samples, const std::string& outputPath);
+    
+    // Builds and dispatches a scenario's grid, then saves it as a binary
+    // snapshot for fast start-up of later runs
+    int saveSnapshot(const std::string& scenarioPath, const std::string& snapshotPath);
 };
 
 #endif // SIMULATOR_H
@@ -0,0 +1,59 @@
+// ThreadPool.h
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Fixed-size pool running index loops with work stealing. Each participant
+// (the workers plus the calling thread) owns a queue of index ranges; it
+// takes work from the back of its own queue and, once that is empty, steals
+// from the front of the others, so uneven items still balance out.
+class ThreadPool {
+private:
+    using Range = std::pair<std::size_t, std::size_t>;
+
+    struct WorkQueue {
+        std::mutex mutex;
+        std::deque<Range> ranges;
+    };
+
+    std::vector<std::thread> workers;
+    std::vector<std::unique_ptr<WorkQueue>> queues;  // Index 0 is the calling thread
+
+    std::mutex stateMutex;
+    std::condition_variable workAvailable;
+    std::condition_variable workFinished;
+    const std::function<void(std::size_t)>* job;
+    std::size_t generation;
+    std::atomic<std::size_t> remaining;
+    bool stopping;
+
+    bool takeRange(std::size_t self, Range& range);
+    bool runOneRange(std::size_t self);
+    void workerLoop(std::size_t self);
+
+public:
+    // Constructor (threadCount includes the calling thread; 0 picks one per core)
+    explicit ThreadPool(std::size_t threadCount = 0);
+    ~ThreadPool();
+    
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+    
+    std::size_t getThreadCount() const;
+    
+    // Calls body(i) for every i in [0, count) and returns once all calls have
+    // finished. Not reentrant: body must not call parallelFor on the same pool.
+    void parallelFor(std::size_t count, const std::function<void(std::size_t)>& body);
+};
+
+#endif // THREAD_POOL_H
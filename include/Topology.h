@@ -0,0 +1,115 @@
+// Topology.h
+#ifndef TOPOLOGY_H
+#define TOPOLOGY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "GridState.h"
+
+// Bus ties (or feeders) between busbars. A closed tie lets spare source
+// capacity on one busbar serve loads on another, up to the tie's transfer
+// limit in either direction; open ties carry nothing.
+//
+// Dispatch first solves every busbar on its own sources, then serves what
+// is left across the ties: loads of each tie-connected group of busbars are
+// taken by priority and each is routed as one augmenting path through the
+// ties' residual capacity (breadth-first, so the nearest busbar with a
+// source that can take the whole load wins). Flow already on a tie can be
+// cancelled by a transfer the other way. Closed ties are kept as a
+// compressed sparse adjacency, so the search stays cheap on grids with
+// thousands of busbars; busbars without closed ties never enter it.
+//
+// Each tie also has a reactance, for the DC power flow (see PowerFlow) that
+// works out how power actually divides over the ties once dispatch is done.
+class Topology {
+public:
+    using Handle = GridState::Handle;
+    static constexpr std::size_t NONE = static_cast<std::size_t>(-1);
+
+    struct Tie {
+        std::string id;
+        Handle from;
+        Handle to;
+        double limitKw;
+        bool closed;
+        double flowKw;  // From the last dispatch; positive from 'from' to 'to'
+        double reactance;    // Per unit; only the ratios between ties matter
+        double powerFlowKw;  // From the last power flow solve, same sign
+    };
+
+private:
+    std::vector<Tie> ties;
+    std::unordered_map<std::string, std::size_t> tieIndex;
+    std::size_t closedTies;
+
+    // Closed ties per busbar slot: adjacency[adjacencyStart[b], adjacencyStart[b + 1])
+    std::vector<std::size_t> adjacencyStart;
+    std::vector<std::size_t> adjacency;
+    // Groups of busbars joined by closed ties (busbars without any are in
+    // none): members[componentStart[c], componentStart[c + 1]), in handle order
+    std::vector<std::size_t> componentOf;
+    std::vector<std::size_t> componentStart;
+    std::vector<Handle> componentMembers;
+    bool structureValid;
+    std::uint64_t revision;
+
+    // Search scratch, per busbar slot
+    std::vector<std::uint32_t> visited;
+    std::uint32_t visitStamp;
+    std::vector<std::size_t> parentTie;
+    std::vector<Handle> queue;
+    std::vector<double> maxHeadroom;
+    std::vector<std::uint8_t> componentSeen;
+    std::vector<std::size_t> pendingComponents;
+    std::vector<Handle> candidates;
+    std::vector<Handle> ordered;
+
+    void rebuild(std::size_t busbarSlots);
+    void refresh(const GridState& state);
+    double headroomOf(const GridState& state, Handle busbar) const;
+    // Whether 'kw' more can flow across the tie into 'towards'
+    bool canCarry(const Tie& tie, Handle towards, double kw) const;
+    // Serves the load from the nearest busbar that can take it; returns
+    // that busbar, or INVALID_HANDLE
+    Handle route(GridState& state, Handle load);
+    std::size_t transferComponent(GridState& state, std::size_t component);
+
+public:
+    Topology();
+
+    // Return false (and change nothing) for a duplicate ID, an unknown ID,
+    // a tie from a busbar to itself, or a reactance that is not positive
+    bool addTie(const std::string& id, Handle from, Handle to, double limitKw, bool closed,
+                double reactance);
+    bool removeTie(const std::string& id);
+    bool setClosed(const std::string& id, bool closed);
+    bool setLimit(const std::string& id, double limitKw);
+    // Restores a saved flow; dispatch otherwise sets flows itself
+    bool setFlow(const std::string& id, double flowKw);
+    // Drops every tie touching the busbar; returns the busbars at their
+    // other ends, which lose a neighbour
+    std::vector<Handle> removeBusbar(Handle busbar);
+
+    const Tie* findTie(const std::string& id) const;
+    const std::vector<Tie>& getTies() const;
+    bool hasClosedTies() const;
+    // Changes whenever the closed ties (or their busbars) do, so a power flow
+    // knows when its factorization is stale
+    std::uint64_t getRevision() const;
+    void clearFlows();
+    // Power flows by tie slot (the order of getTies)
+    void setPowerFlows(const std::vector<double>& flows);
+
+    // Dirty busbars drag every busbar tied to them into the next dispatch,
+    // since transfers couple their allocations
+    void expandDirty(GridState& state);
+    // Serves loads the given (just solved) busbars left unserved from spare
+    // capacity elsewhere in their tie groups, and sets the tie flows.
+    // Returns the number of loads served by transfer.
+    std::size_t transfer(GridState& state, const std::vector<Handle>& solved);
+};
+
+#endif // TOPOLOGY_H
@@ -0,0 +1,659 @@
+// AllocationStrategy.cpp
+#include "../include/AllocationStrategy.h"
+#include "../include/GridState.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <numeric>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using Tiers = std::vector<std::pair<std::size_t, std::size_t>>;
+
+// Buffers reused by every allocate() call on a thread, so a dispatch that
+// packs the same busbars again does not allocate
+struct Scratch {
+    std::vector<double> used;
+    Tiers tiers;
+    std::vector<std::size_t> tierOrder;
+    std::vector<double> firstFitUsed;
+    std::vector<double> bestFitUsed;
+    std::vector<std::size_t> bestFitAssignment;
+    std::vector<std::size_t> order;
+    std::vector<std::size_t> tierOf;
+    std::vector<double> weightAt;
+    std::vector<std::size_t> sourceOrder;
+};
+
+Scratch& scratch() {
+    thread_local Scratch buffers;
+    return buffers;
+}
+
+// Index ranges [begin, end) of loads sharing a priority
+void priorityTiers(const AllocationProblem& problem, Tiers& tiers) {
+    tiers.clear();
+    std::size_t begin = 0;
+    for (std::size_t i = 1; i <= problem.demands.size(); ++i) {
+        if (i == problem.demands.size() || problem.priorities[i] != problem.priorities[begin]) {
+            tiers.emplace_back(begin, i);
+            begin = i;
+        }
+    }
+}
+
+// Loads of a tier, largest first; equal loads keep their order (ties are
+// broken by index rather than with a stable sort, which would allocate)
+void largestFirst(const AllocationProblem& problem, std::size_t begin, std::size_t end,
+                  std::vector<std::size_t>& order) {
+    order.resize(end - begin);
+    std::iota(order.begin(), order.end(), begin);
+    std::sort(order.begin(), order.end(), [&problem](std::size_t a, std::size_t b) {
+        if (problem.demands[a] != problem.demands[b]) {
+            return problem.demands[a] > problem.demands[b];
+        }
+        return a < b;
+    });
+}
+
+double firstFitTier(const AllocationProblem& problem, std::size_t begin, std::size_t end,
+                    std::vector<double>& used, std::vector<std::size_t>& assignment) {
+    double served = 0.0;
+    for (std::size_t i = begin; i < end; ++i) {
+        double demand = problem.demands[i];
+        assignment[i] = AllocationStrategy::UNSERVED;
+        for (std::size_t j = 0; j < problem.capacities.size(); ++j) {
+            if (used[j] + demand <= problem.capacities[j]) {
+                used[j] += demand;
+                assignment[i] = j;
+                served += demand;
+                break;
+            }
+        }
+    }
+    return served;
+}
+
+double bestFitDecreasingTier(const AllocationProblem& problem, std::size_t begin, std::size_t end,
+                             std::vector<double>& used, std::vector<std::size_t>& assignment) {
+    double served = 0.0;
+    std::vector<std::size_t>& order = scratch().tierOrder;
+    largestFirst(problem, begin, end, order);
+    for (std::size_t i : order) {
+        double demand = problem.demands[i];
+        std::size_t best = AllocationStrategy::UNSERVED;
+        double bestSlack = 0.0;
+        for (std::size_t j = 0; j < problem.capacities.size(); ++j) {
+            if (used[j] + demand <= problem.capacities[j]) {
+                double slack = problem.capacities[j] - used[j] - demand;
+                if (best == AllocationStrategy::UNSERVED || slack < bestSlack) {
+                    best = j;
+                    bestSlack = slack;
+                }
+            }
+        }
+        assignment[i] = best;
+        if (best != AllocationStrategy::UNSERVED) {
+            used[best] += demand;
+            served += demand;
+        }
+    }
+    return served;
+}
+
+// Packs a tier with whichever of first-fit and best-fit-decreasing serves
+// more of it
+void greedyTier(const AllocationProblem& problem, std::size_t begin, std::size_t end,
+                std::vector<double>& used, std::vector<std::size_t>& assignment) {
+    Scratch& buffers = scratch();
+    std::vector<double>& firstFitUsed = buffers.firstFitUsed;
+    std::vector<double>& bestFitUsed = buffers.bestFitUsed;
+    std::vector<std::size_t>& bestFitAssignment = buffers.bestFitAssignment;
+    bestFitAssignment.resize(assignment.size());
+    firstFitUsed = used;
+    bestFitUsed = used;
+    double firstFitServed = firstFitTier(problem, begin, end, firstFitUsed, assignment);
+    double bestFitServed = bestFitDecreasingTier(problem, begin, end, bestFitUsed, bestFitAssignment);
+    if (bestFitServed > firstFitServed) {
+        std::copy(bestFitAssignment.begin() + begin, bestFitAssignment.begin() + end,
+                  assignment.begin() + begin);
+        used = bestFitUsed;
+    } else {
+        used = firstFitUsed;
+    }
+}
+
+// Depth-first search over all loads, tier by tier (largest first within a
+// tier): each load is tried on every source it fits, then left unserved.
+// Packings are compared by served kW per tier, lexicographically, so higher
+// tiers always win. A branch is cut when even its optimistic outcome (every
+// remaining load of the current tier served, or all headroom filled, and the
+// same for later tiers) could not beat the best packing found so far.
+class PackingSearch {
+private:
+    const AllocationProblem& problem;
+    const std::vector<std::size_t>& order;
+    const std::vector<std::size_t>& tierOf;       // Tier of order[k]
+    std::vector<double> remainingInTier;          // Suffix sums within a tier
+    std::vector<double> tierDemand;
+    std::vector<double> used;
+    std::vector<double> served;                   // Per tier
+    std::vector<std::size_t> current;
+    Clock::time_point deadline;
+    std::size_t nodes;
+    double freeCapacity;
+
+    // Whether the best outcome reachable from position k beats the incumbent
+    bool canImprove(std::size_t k) const {
+        std::size_t tier = tierOf[k];
+        for (std::size_t t = 0; t < served.size(); ++t) {
+            double bound = served[t];
+            if (t == tier) bound += std::min(remainingInTier[k], freeCapacity);
+            else if (t > tier) bound = std::min(tierDemand[t], freeCapacity);
+            if (bound != bestServed[t]) return bound > bestServed[t];
+        }
+        return false;
+    }
+
+    bool beatsIncumbent() const {
+        for (std::size_t t = 0; t < served.size(); ++t) {
+            if (served[t] != bestServed[t]) return served[t] > bestServed[t];
+        }
+        return false;
+    }
+
+public:
+    std::vector<std::size_t> best;
+    std::vector<double> bestServed;
+    bool timedOut;
+
+    PackingSearch(const AllocationProblem& problem, const std::vector<std::size_t>& order,
+                  const std::vector<std::size_t>& tierOf, std::size_t tierCount,
+                  const std::vector<std::size_t>& incumbent, Clock::time_point deadline)
+        : problem(problem), order(order), tierOf(tierOf), remainingInTier(order.size(), 0.0),
+          tierDemand(tierCount, 0.0), used(problem.capacities.size(), 0.0), 
+          served(tierCount, 0.0), current(order.size(), AllocationStrategy::UNSERVED), 
+          deadline(deadline), nodes(0), freeCapacity(0.0), best(incumbent),
+          bestServed(tierCount, 0.0), timedOut(false) {
+        for (std::size_t k = order.size(); k > 0; --k) {
+            double demand = problem.demands[order[k - 1]];
+            bool sameTierNext = k < order.size() && tierOf[k] == tierOf[k - 1];
+            remainingInTier[k - 1] = demand + (sameTierNext ? remainingInTier[k] : 0.0);
+            tierDemand[tierOf[k - 1]] += demand;
+            if (incumbent[order[k - 1]] != AllocationStrategy::UNSERVED) {
+                bestServed[tierOf[k - 1]] += demand;
+            }
+        }
+        for (double capacity : problem.capacities) {
+            freeCapacity += std::max(0.0, capacity);
+        }
+    }
+
+    void search(std::size_t k) {
+        if (timedOut) return;
+        if ((++nodes & 1023) == 0 && Clock::now() > deadline) {
+            timedOut = true;
+            return;
+        }
+        if (k == order.size()) {
+            if (beatsIncumbent()) {
+                bestServed = served;
+                for (std::size_t i = 0; i < order.size(); ++i) best[order[i]] = current[i];
+            }
+            return;
+        }
+        if (!canImprove(k)) return;
+
+        std::size_t load = order[k];
+        double demand = problem.demands[load];
+        for (std::size_t j = 0; j < problem.capacities.size(); ++j) {
+            if (used[j] + demand > problem.capacities[j]) continue;
+
+            // Sources with identical headroom lead to identical subtrees
+            bool duplicate = false;
+            for (std::size_t prior = 0; prior < j && !duplicate; ++prior) {
+                duplicate = problem.capacities[prior] - used[prior] == problem.capacities[j] - used[j];
+            }
+            if (duplicate) continue;
+
+            used[j] += demand;
+            freeCapacity -= demand;
+            served[tierOf[k]] += demand;
+            current[k] = j;
+            search(k + 1);
+            current[k] = AllocationStrategy::UNSERVED;
+            served[tierOf[k]] -= demand;
+            freeCapacity += demand;
+            used[j] -= demand;
+            if (timedOut) return;
+        }
+        search(k + 1);
+    }
+};
+
+constexpr std::uint8_t CRITICAL_PRIORITY = 1;
+
+// Priority-weighted kW the assignment serves among order's loads
+double weightedServed(const AllocationProblem& problem, const std::vector<std::size_t>& order,
+                      const std::vector<double>& weightAt, const std::vector<std::size_t>& assignment) {
+    double value = 0.0;
+    for (std::size_t k = 0; k < order.size(); ++k) {
+        if (assignment[order[k]] != AllocationStrategy::UNSERVED) {
+            value += weightAt[k] * problem.demands[order[k]];
+        }
+    }
+    return value;
+}
+
+// Sources, from most headroom to least, each take every remaining load that
+// fits in weighted order, unless a single remaining load that fits is worth
+// more on its own. That gives each source at least half the weighted kW it
+// could best serve from what is left (the greedy set plus the first load it
+// skips is worth more than any packing), so the whole packing is worth at
+// least a third of the optimum. Loads still unserved then take whatever
+// headroom is left, first fit.
+void successiveGreedy(const AllocationProblem& problem, const std::vector<std::size_t>& order,
+                      const std::vector<double>& weightAt, std::vector<double>& used,
+                      std::vector<std::size_t>& assignment) {
+    const std::vector<double>& capacities = problem.capacities;
+    std::vector<std::size_t>& sources = scratch().sourceOrder;
+    sources.resize(capacities.size());
+    std::iota(sources.begin(), sources.end(), 0);
+    std::sort(sources.begin(), sources.end(), [&](std::size_t a, std::size_t b) {
+        double headroomA = capacities[a] - used[a];
+        double headroomB = capacities[b] - used[b];
+        if (headroomA != headroomB) return headroomA > headroomB;
+        return a < b;
+    });
+
+    for (std::size_t j : sources) {
+        // Worth of the greedy set and of the best single load, before committing either
+        double loading = used[j];
+        double setValue = 0.0;
+        double singleValue = -1.0;
+        std::size_t single = order.size();
+        for (std::size_t k = 0; k < order.size(); ++k) {
+            std::size_t load = order[k];
+            if (assignment[load] != AllocationStrategy::UNSERVED) continue;
+            double demand = problem.demands[load];
+            double value = weightAt[k] * demand;
+            if (used[j] + demand <= capacities[j] && value > singleValue) {
+                single = k;
+                singleValue = value;
+            }
+            if (loading + demand <= capacities[j]) {
+                loading += demand;
+                setValue += value;
+            }
+        }
+        if (single == order.size()) continue;
+
+        if (singleValue > setValue) {
+            assignment[order[single]] = j;
+            used[j] += problem.demands[order[single]];
+            continue;
+        }
+        for (std::size_t load : order) {
+            if (assignment[load] == AllocationStrategy::UNSERVED && 
+                used[j] + problem.demands[load] <= capacities[j]) {
+                used[j] += problem.demands[load];
+                assignment[load] = j;
+            }
+        }
+    }
+
+    for (std::size_t load : order) {
+        if (assignment[load] != AllocationStrategy::UNSERVED) continue;
+        for (std::size_t j = 0; j < capacities.size(); ++j) {
+            if (used[j] + problem.demands[load] <= capacities[j]) {
+                used[j] += problem.demands[load];
+                assignment[load] = j;
+                break;
+            }
+        }
+    }
+}
+
+// Depth-first search for the packing of the given loads that serves the most
+// priority-weighted kW: each load is tried on every source it fits, then
+// left unserved. Loads come in weighted order, so a branch's optimistic
+// outcome (the free headroom filled with the next loads, the last one in
+// part) is a binary search over prefix sums.
+class WeightedSearch {
+private:
+    const AllocationProblem& problem;
+    const std::vector<std::size_t>& order;
+    const std::vector<double>& weightAt;
+    std::vector<double> prefixDemand;
+    std::vector<double> prefixValue;
+    std::vector<double> used;
+    std::vector<std::size_t> current;
+    Clock::time_point deadline;
+    std::size_t nodes;
+    double freeCapacity;
+    double value;
+
+    double bound(std::size_t k) const {
+        double limit = prefixDemand[k] + freeCapacity;
+        std::size_t m = std::upper_bound(prefixDemand.begin() + k, prefixDemand.end(), limit) - 
+                        prefixDemand.begin() - 1;
+        double optimistic = value + prefixValue[m] - prefixValue[k];
+        if (m < order.size()) {
+            optimistic += weightAt[m] * (limit - prefixDemand[m]);
+        }
+        return optimistic;
+    }
+
+public:
+    std::vector<std::size_t> best;
+    double bestValue;
+    bool timedOut;
+
+    // 'used' is the loading the searched loads come on top of; 'incumbent'
+    // is the packing to beat
+    WeightedSearch(const AllocationProblem& problem, const std::vector<std::size_t>& order,
+                   const std::vector<double>& weightAt, const std::vector<double>& used,
+                   const std::vector<std::size_t>& incumbent, Clock::time_point deadline)
+        : problem(problem), order(order), weightAt(weightAt), prefixDemand(order.size() + 1, 0.0),
+          prefixValue(order.size() + 1, 0.0), used(used),
+          current(order.size(), AllocationStrategy::UNSERVED), deadline(deadline), nodes(0),
+          freeCapacity(0.0), value(0.0), best(incumbent),
+          bestValue(weightedServed(problem, order, weightAt, incumbent)), timedOut(false) {
+        for (std::size_t k = 0; k < order.size(); ++k) {
+            double demand = problem.demands[order[k]];
+            prefixDemand[k + 1] = prefixDemand[k] + demand;
+            prefixValue[k + 1] = prefixValue[k] + weightAt[k] * demand;
+        }
+        for (std::size_t j = 0; j < used.size(); ++j) {
+            freeCapacity += std::max(0.0, problem.capacities[j] - used[j]);
+        }
+    }
+
+    void search(std::size_t k) {
+        if (timedOut) return;
+        if ((++nodes & 1023) == 0 && Clock::now() > deadline) {
+            timedOut = true;
+            return;
+        }
+        if (k == order.size()) {
+            if (value > bestValue) {
+                bestValue = value;
+                for (std::size_t i = 0; i < order.size(); ++i) best[order[i]] = current[i];
+            }
+            return;
+        }
+        if (bound(k) <= bestValue) return;
+
+        std::size_t load = order[k];
+        double demand = problem.demands[load];
+        for (std::size_t j = 0; j < used.size(); ++j) {
+            if (used[j] + demand > problem.capacities[j]) continue;
+
+            // Sources with identical headroom lead to identical subtrees
+            bool duplicate = false;
+            for (std::size_t prior = 0; prior < j && !duplicate; ++prior) {
+                duplicate = problem.capacities[prior] - used[prior] == problem.capacities[j] - used[j];
+            }
+            if (duplicate) continue;
+
+            used[j] += demand;
+            freeCapacity -= demand;
+            value += weightAt[k] * demand;
+            current[k] = j;
+            search(k + 1);
+            current[k] = AllocationStrategy::UNSERVED;
+            value -= weightAt[k] * demand;
+            freeCapacity += demand;
+            used[j] -= demand;
+            if (timedOut) return;
+        }
+        search(k + 1);
+    }
+};
+
+// Matches "<prefix>" and "<prefix>:<budget>"; the budget is left as it is
+// without one. A budget that is not entirely a finite, non-negative number
+// does not match.
+bool matchBudgeted(const std::string& name, const std::string& prefix, double& budget) {
+    if (name.compare(0, prefix.size(), prefix) != 0) {
+        return false;
+    }
+    if (name.size() == prefix.size()) {
+        return true;
+    }
+    if (name[prefix.size()] != ':') {
+        return false;
+    }
+    const char* text = name.c_str() + prefix.size() + 1;
+    char* end = nullptr;
+    double value = std::strtod(text, &end);
+    if (end == text || *end != '\0' || !std::isfinite(value) || value < 0.0) {
+        return false;
+    }
+    budget = value;
+    return true;
+}
+
+} // namespace
+
+std::shared_ptr<AllocationStrategy> AllocationStrategy::create(const std::string& name) {
+    if (name == "first-fit") {
+        return std::make_shared<FirstFitStrategy>();
+    }
+    if (name == "best-fit") {
+        return std::make_shared<BestFitDecreasingStrategy>();
+    }
+    double budget = 500.0;
+    if (matchBudgeted(name, "branch-and-bound", budget)) {
+        return std::make_shared<BranchAndBoundStrategy>(budget);
+    }
+    budget = 200.0;
+    if (matchBudgeted(name, "knapsack", budget)) {
+        return std::make_shared<KnapsackStrategy>(budget);
+    }
+    return nullptr;
+}
+
+std::string FirstFitStrategy::getName() const {
+    return "first-fit";
+}
+
+void FirstFitStrategy::allocate(const AllocationProblem& problem,
+                                std::vector<std::size_t>& assignment) const {
+    std::vector<double>& used = scratch().used;
+    used.assign(problem.capacities.size(), 0.0);
+    assignment.resize(problem.demands.size());
+    firstFitTier(problem, 0, problem.demands.size(), used, assignment);
+}
+
+std::string BestFitDecreasingStrategy::getName() const {
+    return "best-fit-decreasing";
+}
+
+void BestFitDecreasingStrategy::allocate(const AllocationProblem& problem,
+                                         std::vector<std::size_t>& assignment) const {
+    Scratch& buffers = scratch();
+    buffers.used.assign(problem.capacities.size(), 0.0);
+    assignment.resize(problem.demands.size());
+    priorityTiers(problem, buffers.tiers);
+    std::vector<double>& used = buffers.used;
+    for (const auto& tier : buffers.tiers) {
+        bestFitDecreasingTier(problem, tier.first, tier.second, used, assignment);
+    }
+}
+
+BranchAndBoundStrategy::BranchAndBoundStrategy(double timeBudgetMicroseconds)
+    : timeBudgetMicroseconds(timeBudgetMicroseconds) {}
+
+std::string BranchAndBoundStrategy::getName() const {
+    return "branch-and-bound";
+}
+
+void BranchAndBoundStrategy::allocate(const AllocationProblem& problem,
+                                      std::vector<std::size_t>& assignment) const {
+    auto deadline = Clock::now() + std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double, std::micro>(timeBudgetMicroseconds));
+    Scratch& buffers = scratch();
+    std::vector<double>& used = buffers.used;
+    used.assign(problem.capacities.size(), 0.0);
+    assignment.resize(problem.demands.size());
+    
+    // Incumbent: per tier, the better of the two greedy packings
+    Tiers& tiers = buffers.tiers;
+    priorityTiers(problem, tiers);
+    bool anyShed = false;
+    for (const auto& tier : tiers) {
+        greedyTier(problem, tier.first, tier.second, used, assignment);
+        for (std::size_t i = tier.first; i < tier.second; ++i) {
+            anyShed = anyShed || assignment[i] == UNSERVED;
+        }
+    }
+    
+    // Nothing to gain if everything already fits
+    if (!anyShed) return;
+    
+    std::vector<std::size_t>& order = buffers.order;
+    std::vector<std::size_t>& tierOf = buffers.tierOf;
+    order.clear();
+    tierOf.clear();
+    for (std::size_t t = 0; t < tiers.size(); ++t) {
+        largestFirst(problem, tiers[t].first, tiers[t].second, buffers.tierOrder);
+        order.insert(order.end(), buffers.tierOrder.begin(), buffers.tierOrder.end());
+        tierOf.insert(tierOf.end(), buffers.tierOrder.size(), t);
+    }
+    
+    PackingSearch search(problem, order, tierOf, tiers.size(), assignment, deadline);
+    search.search(0);
+    assignment = search.best;
+}
+
+KnapsackStrategy::KnapsackStrategy(double timeBudgetMicroseconds, std::size_t exactLoadLimit)
+    : timeBudgetMicroseconds(timeBudgetMicroseconds), exactLoadLimit(exactLoadLimit),
+      priorityWeights{std::numeric_limits<double>::infinity(), 8.0, 4.0, 2.0, 1.0} {}
+
+bool KnapsackStrategy::setPriorityWeight(std::uint8_t priority, double weight) {
+    if (priority <= CRITICAL_PRIORITY || priority > PRIORITY_LEVELS || !(weight > 0.0)) {
+        return false;
+    }
+    priorityWeights[priority - 1] = weight;
+    return true;
+}
+
+double KnapsackStrategy::getPriorityWeight(std::uint8_t priority) const {
+    if (priority < CRITICAL_PRIORITY || priority > PRIORITY_LEVELS) {
+        return 0.0;
+    }
+    return priorityWeights[priority - 1];
+}
+
+std::string KnapsackStrategy::getName() const {
+    return "knapsack";
+}
+
+void KnapsackStrategy::allocate(const AllocationProblem& problem,
+                                std::vector<std::size_t>& assignment) const {
+    auto deadline = Clock::now() + std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double, std::micro>(timeBudgetMicroseconds));
+    Scratch& buffers = scratch();
+    std::vector<double>& used = buffers.used;
+    used.assign(problem.capacities.size(), 0.0);
+    assignment.resize(problem.demands.size());
+    
+    // CRITICAL loads come first in the problem and keep what they get
+    std::size_t first = 0;
+    while (first < problem.priorities.size() && problem.priorities[first] == CRITICAL_PRIORITY) {
+        ++first;
+    }
+    if (first > 0) {
+        greedyTier(problem, 0, first, used, assignment);
+    }
+    if (first == problem.demands.size()) return;
+    
+    // The rest by weight, then largest first: tiers in weight order, each
+    // sorted on its own
+    Tiers& tiers = buffers.tiers;
+    priorityTiers(problem, tiers);
+    tiers.erase(tiers.begin(), tiers.begin() + (first > 0 ? 1 : 0));
+    std::stable_sort(tiers.begin(), tiers.end(), [&](const auto& a, const auto& b) {
+        return getPriorityWeight(problem.priorities[a.first]) > getPriorityWeight(problem.priorities[b.first]);
+    });
+    std::vector<std::size_t>& order = buffers.order;
+    std::vector<double>& weightAt = buffers.weightAt;
+    order.clear();
+    weightAt.clear();
+    for (const auto& tier : tiers) {
+        largestFirst(problem, tier.first, tier.second, buffers.tierOrder);
+        order.insert(order.end(), buffers.tierOrder.begin(), buffers.tierOrder.end());
+        weightAt.insert(weightAt.end(), buffers.tierOrder.size(), 
+                        getPriorityWeight(problem.priorities[tier.first]));
+    }
+    
+    // Incumbent: the better of first-fit in priority order (what the default
+    // packing would serve) and the successive greedy packing
+    std::vector<double>& firstFitUsed = buffers.firstFitUsed;
+    firstFitUsed = used;
+    firstFitTier(problem, first, problem.demands.size(), firstFitUsed, assignment);
+    std::vector<double>& greedyUsed = buffers.bestFitUsed;
+    std::vector<std::size_t>& greedyAssignment = buffers.bestFitAssignment;
+    greedyUsed = used;
+    greedyAssignment.assign(problem.demands.size(), UNSERVED);
+    successiveGreedy(problem, order, weightAt, greedyUsed, greedyAssignment);
+    if (weightedServed(problem, order, weightAt, greedyAssignment) > 
+        weightedServed(problem, order, weightAt, assignment)) {
+        std::copy(greedyAssignment.begin() + first, greedyAssignment.end(), assignment.begin() + first);
+    }
+    
+    bool anyShed = false;
+    for (std::size_t i = first; i < assignment.size() && !anyShed; ++i) {
+        anyShed = assignment[i] == UNSERVED;
+    }
+    if (!anyShed || order.size() > exactLoadLimit) return;
+    
+    WeightedSearch search(problem, order, weightAt, used, assignment, deadline);
+    search.search(0);
+    assignment = search.best;
+}
+
+AllocationComparison compareWithFirstFit(const GridState& state, const AllocationStrategy& strategy) {
+    AllocationComparison comparison;
+    comparison.strategy = strategy.getName();
+    FirstFitStrategy firstFit;
+    AllocationProblem problem;
+    std::vector<GridState::Handle> loads;
+    std::vector<GridState::Handle> sources;
+    std::vector<std::size_t> assignment;
+
+    auto servedBy = [&problem](const std::vector<std::size_t>& result) {
+        double served = 0.0;
+        for (std::size_t i = 0; i < result.size(); ++i) {
+            if (result[i] != AllocationStrategy::UNSERVED) served += problem.demands[i];
+        }
+        return served;
+    };
+
+    for (GridState::Handle busbar = 0; busbar < state.busbarSlotCount(); ++busbar) {
+        if (!state.isBusbarSlotUsed(busbar)) continue;
+        state.buildAllocationProblem(busbar, problem, loads, sources);
+        comparison.busbars++;
+
+        auto start = Clock::now();
+        firstFit.allocate(problem, assignment);
+        auto middle = Clock::now();
+        comparison.firstFitServedKw += servedBy(assignment);
+
+        strategy.allocate(problem, assignment);
+        auto end = Clock::now();
+        comparison.servedKw += servedBy(assignment);
+
+        double solveSeconds = std::chrono::duration<double>(end - middle).count();
+        comparison.firstFitSolveSeconds += std::chrono::duration<double>(middle - start).count();
+        comparison.solveSeconds += solveSeconds;
+        comparison.maxBusbarSolveSeconds = std::max(comparison.maxBusbarSolveSeconds, solveSeconds);
+    }
+
+    comparison.extraServedKw = comparison.servedKw - comparison.firstFitServedKw;
+    return comparison;
+}
@@ -1,19 +1,31 @@
 // Busbar.cpp
 #include "../include/Busbar.h"
 #include <algorithm>
-#include <iostream>
+#include <utility>
 
-Busbar::Busbar(const std::string& id) : id(id), energized(false) {}
+Busbar::Busbar(const std::string& id) 
+    : id(id), state(nullptr), index(GridState::INVALID_HANDLE) {}
 
-std::string Busbar::getId() const {
+const std::string& Busbar::getId() const {
     return id;
 }
 
 bool Busbar::isEnergized() const {
-    return energized;
+    if (state) {
+        return state->isBusbarEnergized(index);
+    }
+    for (const auto& source : connectedSources) {
+        if (source->isOperational()) {
+            return true;
+        }
+    }
+    return false;
 }
 
 double Busbar::getTotalConnectedLoad() const {
+    if (state) {
+        return state->busbarConnectedLoad(index);
+    }
     double totalLoad = 0.0;
     for (const auto& load : connectedLoads) {
         if (load->isLoadConnected()) {
@@ -23,7 +35,40 @@ double Busbar::getTotalConnectedLoad() const {
     return totalLoad;
 }
 
+double Busbar::getConnectedLoad(Priority priority) const {
+    if (state) {
+        return state->busbarConnectedLoad(index, priority);
+    }
+    double totalLoad = 0.0;
+    for (const auto& load : connectedLoads) {
+        if (load->isLoadConnected() && load->getPriority() == priority) {
+            totalLoad += load->getPowerDemand();
+        }
+    }
+    return totalLoad;
+}
+
+double Busbar::getIncrementalCost() const {
+    return state ? state->busbarIncrementalCost(index) : 0.0;
+}
+
+double Busbar::getOperationalCapacity() const {
+    if (state) {
+        return state->busbarOperationalCapacity(index);
+    }
+    double capacity = 0.0;
+    for (const auto& source : connectedSources) {
+        if (source->isOperational()) {
+            capacity += source->getCapacity();
+        }
+    }
+    return capacity;
+}
+
 double Busbar::getTotalAvailablePower() const {
+    if (state) {
+        return state->busbarAvailablePower(index);
+    }
     double totalPower = 0.0;
     for (const auto& source : connectedSources) {
         if (source->isOperational()) {
@@ -41,11 +86,42 @@ std::vector<std::shared_ptr<PowerSource>> Busbar::getConnectedSources() const {
     return connectedSources;
 }
 
+ConnectionView<Load> Busbar::getLoadView() const {
+    return ConnectionView<Load>(connectedLoads.data(), connectedLoads.size());
+}
+
+ConnectionView<PowerSource> Busbar::getSourceView() const {
+    return ConnectionView<PowerSource>(connectedSources.data(), connectedSources.size());
+}
+
+void Busbar::reserve(std::size_t loadCount, std::size_t sourceCount) {
+    connectedLoads.reserve(loadCount);
+    connectedSources.reserve(sourceCount);
+    if (state) {
+        state->busbarLoads.edit(index).reserve(loadCount);
+        state->busbarSources.edit(index).reserve(sourceCount);
+    }
+}
+
 void Busbar::connectLoad(std::shared_ptr<Load> load) {
+    load->busbarSlot = connectedLoads.size();
     connectedLoads.push_back(load);
+    if (state) {
+        state->addLoad(load.get(), index);
+    }
     load->connect();
 }
 
+void Busbar::appendLoad(std::shared_ptr<Load> load) {
+    // Connect while still detached, so the state takes the load as connected
+    load->connect();
+    load->busbarSlot = connectedLoads.size();
+    if (state) {
+        state->appendLoad(load.get(), index);
+    }
+    connectedLoads.push_back(std::move(load));
+}
+
 void Busbar::disconnectLoad(const std::string& loadId) {
     auto it = std::find_if(connectedLoads.begin(), connectedLoads.end(),
                          [&loadId](const std::shared_ptr<Load>& load) {
@@ -53,15 +129,39 @@ void Busbar::disconnectLoad(const std::string& loadId) {
                          });
     
     if (it != connectedLoads.end()) {
-        (*it)->disconnect();
-        connectedLoads.erase(it);
+        removeLoadAt(static_cast<std::size_t>(it - connectedLoads.begin()));
     }
 }
 
+void Busbar::disconnectLoad(Load& load) {
+    std::size_t slot = load.busbarSlot;
+    if (slot < connectedLoads.size() && connectedLoads[slot].get() == &load) {
+        removeLoadAt(slot);
+    }
+}
+
+void Busbar::removeLoadAt(std::size_t slot) {
+    // Keep the load alive until it is fully detached
+    std::shared_ptr<Load> removed = connectedLoads[slot];
+    removed->disconnect();
+    if (state) {
+        state->removeLoad(removed->getHandle());
+    }
+    
+    // Fill the gap with the last load
+    if (slot + 1 != connectedLoads.size()) {
+        connectedLoads[slot] = std::move(connectedLoads.back());
+        connectedLoads[slot]->busbarSlot = slot;
+    }
+    connectedLoads.pop_back();
+}
+
 void Busbar::connectSource(std::shared_ptr<PowerSource> source) {
+    source->busbarSlot = connectedSources.size();
     connectedSources.push_back(source);
-    // Check if busbar should be energized
-    energized = !connectedSources.empty();
+    if (state) {
+        state->addSource(source.get(), index);
+    }
 }
 
 void Busbar::disconnectSource(const std::string& sourceId) {
@@ -71,99 +171,99 @@ void Busbar::disconnectSource(const std::string& sourceId) {
                          });
     
     if (it != connectedSources.end()) {
-        connectedSources.erase(it);
-        // Check if busbar is still energized
-        energized = !connectedSources.empty();
+        removeSourceAt(static_cast<std::size_t>(it - connectedSources.begin()));
     }
 }
 
-bool Busbar::distributeLoadsToPowerSources() {
-    if (connectedSources.empty()) {
-        // No power sources, can't distribute
-        for (auto& load : connectedLoads) {
-            load->setServed(false);
-        }
-        return false;
+void Busbar::disconnectSource(PowerSource& source) {
+    std::size_t slot = source.busbarSlot;
+    if (slot < connectedSources.size() && connectedSources[slot].get() == &source) {
+        removeSourceAt(slot);
     }
-    
-    // Reset all power sources
-    for (auto& source : connectedSources) {
-        source->resetLoading();
+}
+
+void Busbar::removeSourceAt(std::size_t slot) {
+    std::shared_ptr<PowerSource> removed = connectedSources[slot];
+    if (state) {
+        state->removeSource(removed->getHandle());
     }
     
-    // Mark all loads as not served initially
-    for (auto& load : connectedLoads) {
-        load->setServed(false);
+    if (slot + 1 != connectedSources.size()) {
+        connectedSources[slot] = std::move(connectedSources.back());
+        connectedSources[slot]->busbarSlot = slot;
     }
-    
-    // Sort loads by priority (critical first)
-    std::vector<std::shared_ptr<Load>> sortedLoads = connectedLoads;
-    std::sort(sortedLoads.begin(), sortedLoads.end(), 
-              [](const std::shared_ptr<Load>& a, const std::shared_ptr<Load>& b) {
-                  return static_cast<int>(a->getPriority()) < static_cast<int>(b->getPriority());
-              });
-    
-    // Try to distribute loads
-    bool allLoadsServed = true;
-    for (auto& load : sortedLoads) {
-        if (!load->isLoadConnected()) continue;
-        
-        bool loadServed = false;
-        double demandPower = load->getPowerDemand();
-        
-        // Find a source that can handle this load
-        for (auto& source : connectedSources) {
-            if (source->canSupplyPower(demandPower)) {
-                source->addLoad(demandPower);
-                load->setServed(true);
-                loadServed = true;
-                break;
-            }
-        }
-        
-        if (!loadServed) {
-            allLoadsServed = false;
-        }
+    connectedSources.pop_back();
+}
+
+void Busbar::attach(GridState* gridState) {
+    state = gridState;
+    index = state->addBusbar(this);
+    // Move anything connected before the busbar joined the grid into the state
+    for (const auto& load : connectedLoads) {
+        state->addLoad(load.get(), index);
+    }
+    for (const auto& source : connectedSources) {
+        state->addSource(source.get(), index);
     }
-    
-    return allLoadsServed;
 }
 
-void Busbar::performLoadShedding() {
-    // Reset all power sources
-    for (auto& source : connectedSources) {
-        source->resetLoading();
+void Busbar::adopt(GridState* gridState, GridState::Handle handle,
+                   std::vector<std::shared_ptr<Load>> loads,
+                   std::vector<std::shared_ptr<PowerSource>> sources) {
+    state = gridState;
+    index = handle;
+    state->bindBusbarView(this, index);
+    connectedLoads = std::move(loads);
+    connectedSources = std::move(sources);
+    for (std::size_t slot = 0; slot < connectedLoads.size(); ++slot) {
+        connectedLoads[slot]->busbarSlot = slot;
     }
-    
-    // Sort loads by priority (critical first)
-    std::vector<std::shared_ptr<Load>> sortedLoads = connectedLoads;
-    std::sort(sortedLoads.begin(), sortedLoads.end(), 
-              [](const std::shared_ptr<Load>& a, const std::shared_ptr<Load>& b) {
-                  return static_cast<int>(a->getPriority()) < static_cast<int>(b->getPriority());
-              });
-    
-    // Try to distribute loads by priority
-    for (auto& load : sortedLoads) {
-        if (!load->isLoadConnected()) continue;
-        
-        double demandPower = load->getPowerDemand();
-        bool loadServed = false;
-        
-        // Find source with available capacity
-        for (auto& source : connectedSources) {
-            if (source->canSupplyPower(demandPower)) {
-                source->addLoad(demandPower);
-                load->setServed(true);
-                loadServed = true;
-                break;
-            }
-        }
-        
-        if (!loadServed) {
-            // This load cannot be served (it will be shed)
-            load->setServed(false);
-            std::cout << "Load shedding: " << load->getId() << " (" << load->getTypeString() 
-                      << ", " << load->getPowerDemand() << " kW) was shed.\n";
-        }
+    for (std::size_t slot = 0; slot < connectedSources.size(); ++slot) {
+        connectedSources[slot]->busbarSlot = slot;
+    }
+}
+
+void Busbar::detach() {
+    if (state) {
+        state->removeBusbar(index);
+        state = nullptr;
+        index = GridState::INVALID_HANDLE;
+    }
+}
+
+bool Busbar::isAttached() const {
+    return state != nullptr;
+}
+
+GridState::Handle Busbar::getIndex() const {
+    return index;
+}
+
+bool Busbar::needsDispatch() const {
+    return state ? state->isBusbarDirty(index) : false;
+}
+
+bool Busbar::distributeLoadsToPowerSources() {
+    shedLoads.clear();
+    if (!state) {
+        // Not part of a grid, nothing can be dispatched
+        return connectedLoads.empty();
     }
+    bool allServed = state->dispatchBusbar(index, shedLoads);
+    if (state->isEconomicDispatchEnabled()) {
+        state->redispatchEconomically(index);
+    }
+    return allServed;
+}
+
+double Busbar::solveLoads() {
+    // Only touches this busbar's loads and sources, so different busbars
+    // can be solved concurrently
+    shedLoads.clear();
+    if (!state) return 0.0;
+    return state->solveBusbar(index, shedLoads);
+}
+
+const std::vector<GridState::Handle>& Busbar::getShedLoads() const {
+    return shedLoads;
 }
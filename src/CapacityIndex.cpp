@@ -0,0 +1,63 @@
+// CapacityIndex.cpp
+#include "../include/CapacityIndex.h"
+#include <algorithm>
+#include <limits>
+
+CapacityIndex::CapacityIndex() : count(0), leaves(1) {}
+
+CapacityIndex::CapacityIndex(const std::vector<double>& headroom) : CapacityIndex() {
+    assign(headroom);
+}
+
+void CapacityIndex::assign(const std::vector<double>& headroom) {
+    count = headroom.size();
+    leaves = 1;
+    while (leaves < headroom.size()) {
+        leaves *= 2;
+    }
+    tree.assign(2 * leaves, -std::numeric_limits<double>::infinity());
+    std::copy(headroom.begin(), headroom.end(), tree.begin() + leaves);
+    for (std::size_t node = leaves - 1; node > 0; --node) {
+        tree[node] = std::max(tree[2 * node], tree[2 * node + 1]);
+    }
+}
+
+std::size_t CapacityIndex::size() const {
+    return count;
+}
+
+double CapacityIndex::getHeadroom(std::size_t index) const {
+    return tree[leaves + index];
+}
+
+void CapacityIndex::setHeadroom(std::size_t index, double headroom) {
+    std::size_t node = leaves + index;
+    tree[node] = headroom;
+    for (node /= 2; node > 0; node /= 2) {
+        tree[node] = std::max(tree[2 * node], tree[2 * node + 1]);
+    }
+}
+
+std::size_t CapacityIndex::findFirst(double demand, std::size_t from) const {
+    if (from >= count || tree[1] < demand) {
+        return NONE;
+    }
+    return findFirst(1, 0, leaves, from, demand);
+}
+
+std::size_t CapacityIndex::findFirst(std::size_t node, std::size_t begin, std::size_t end,
+                                     std::size_t from, double demand) const {
+    // Skip subtrees entirely before 'from' or without enough headroom
+    if (end <= from || tree[node] < demand) {
+        return NONE;
+    }
+    if (end - begin == 1) {
+        return begin;
+    }
+    std::size_t middle = begin + (end - begin) / 2;
+    std::size_t found = findFirst(2 * node, begin, middle, from, demand);
+    if (found != NONE) {
+        return found;
+    }
+    return findFirst(2 * node + 1, middle, end, from, demand);
+}
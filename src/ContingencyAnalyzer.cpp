@@ -0,0 +1,268 @@
+// ContingencyAnalyzer.cpp
+#include "../include/ContingencyAnalyzer.h"
+#include <algorithm>
+#include <numeric>
+#include <random>
+
+ContingencyAnalyzer::ContingencyAnalyzer(const Grid& grid, std::shared_ptr<ThreadPool> pool)
+    : state(grid.getState()), pool(pool), baseTotalShedKw(0.0) {
+    if (grid.getTopology().hasClosedTies()) {
+        computeTiedBaseCase(grid);
+    } else {
+        computeBaseCase();
+    }
+}
+
+double ContingencyAnalyzer::getBaseShedKw() const {
+    return baseTotalShedKw;
+}
+
+std::size_t ContingencyAnalyzer::getCandidateCount() const {
+    return candidates.size();
+}
+
+void ContingencyAnalyzer::computeBaseCase() {
+    // Solve the base case with the same kernel the contingencies use, so
+    // differences come from the outage alone
+    std::vector<double> scratch;
+    baseShed.assign(state.busbarSlotCount(), {});
+    baseShedKw.assign(state.busbarSlotCount(), 0.0);
+    baseTotalShedKw = 0.0;
+
+    for (GridState::Handle busbar = 0; busbar < state.busbarSlotCount(); ++busbar) {
+        if (!state.isBusbarSlotUsed(busbar)) continue;
+        double served = state.evaluateBusbar(busbar, nullptr, 0, scratch, baseShed[busbar]);
+        std::sort(baseShed[busbar].begin(), baseShed[busbar].end());
+        baseShedKw[busbar] = state.busbarConnectedLoad(busbar) - served;
+        baseTotalShedKw += baseShedKw[busbar];
+    }
+
+    candidates.clear();
+    for (GridState::Handle source = 0; source < state.sourceSlotCount(); ++source) {
+        if (state.isSourceSlotUsed(source) && state.sourceOperational[source]) {
+            candidates.push_back(source);
+        }
+    }
+}
+
+void ContingencyAnalyzer::computeTiedBaseCase(const Grid& grid) {
+    // The base case is a full dispatch with transfers. Cases dispatch on
+    // their own threads, so the copy has no pool, and it skips what cannot
+    // change which loads are served.
+    base = grid.fork();
+    base->setShedReporting(false);
+    base->setThreadPool(nullptr);
+    base->setEconomicDispatch(false);
+    base->setPowerFlow(false);
+    base->getState().markAllBusbarsDirty();
+    base->distributeLoadOptimally();
+    base->fork();  // Builds the ID index the cases' forks share
+    const GridState& solved = base->getState();
+
+    baseShed.assign(solved.busbarSlotCount(), {});
+    baseShedKw.assign(solved.busbarSlotCount(), 0.0);
+    baseTotalShedKw = 0.0;
+    for (GridState::Handle busbar = 0; busbar < solved.busbarSlotCount(); ++busbar) {
+        if (!solved.isBusbarSlotUsed(busbar)) continue;
+        for (GridState::Handle load : solved.busbarLoads[busbar]) {
+            if (solved.loadConnected[load] && !solved.loadServed[load]) {
+                baseShed[busbar].push_back(load);
+            }
+        }
+        std::sort(baseShed[busbar].begin(), baseShed[busbar].end());
+        baseShedKw[busbar] = solved.busbarConnectedLoad(busbar) - solved.busbarServedPower(busbar);
+        baseTotalShedKw += baseShedKw[busbar];
+    }
+
+    // Tie groups, by union-find over the closed ties
+    std::vector<std::size_t> root(solved.busbarSlotCount());
+    std::iota(root.begin(), root.end(), 0);
+    auto find = [&root](std::size_t busbar) {
+        while (root[busbar] != busbar) {
+            root[busbar] = root[root[busbar]];
+            busbar = root[busbar];
+        }
+        return busbar;
+    };
+    groupOf.assign(solved.busbarSlotCount(), NONE);
+    for (const Topology::Tie& tie : base->getTopology().getTies()) {
+        if (!tie.closed) continue;
+        groupOf[tie.from] = groupOf[tie.to] = 0;
+        root[find(tie.from)] = find(tie.to);
+    }
+    std::vector<std::size_t> groupOfRoot(solved.busbarSlotCount(), NONE);
+    groups.clear();
+    for (GridState::Handle busbar = 0; busbar < solved.busbarSlotCount(); ++busbar) {
+        if (groupOf[busbar] == NONE) continue;
+        std::size_t& group = groupOfRoot[find(busbar)];
+        if (group == NONE) {
+            group = groups.size();
+            groups.emplace_back();
+        }
+        groupOf[busbar] = group;
+        groups[group].push_back(busbar);
+    }
+
+    candidates.clear();
+    for (GridState::Handle source = 0; source < solved.sourceSlotCount(); ++source) {
+        if (solved.isSourceSlotUsed(source) && solved.sourceOperational[source]) {
+            candidates.push_back(source);
+        }
+    }
+}
+
+void ContingencyAnalyzer::compareShed(const GridState& solved, const std::vector<GridState::Handle>& busbars,
+                                      const Options& options, Result& result) const {
+    for (GridState::Handle busbar : busbars) {
+        double shed = solved.busbarConnectedLoad(busbar) - solved.busbarServedPower(busbar);
+        result.additionalShedKw += shed - baseShedKw[busbar];
+
+        const auto& before = baseShed[busbar];
+        for (GridState::Handle load : solved.busbarLoads[busbar]) {
+            if (!solved.loadConnected[load] || solved.loadServed[load]) continue;
+            if (std::binary_search(before.begin(), before.end(), load)) continue;
+            std::size_t tier = solved.loadPriority[load] - 1;
+            result.additionalShedKwByPriority[tier] += solved.loadDemand[load];
+            result.additionalLoadsShedByPriority[tier]++;
+            if (options.collectLoadIds) {
+                result.affectedLoads.push_back(solved.loadIds[load]);
+            }
+        }
+    }
+}
+
+bool ContingencyAnalyzer::evaluate(const GridState::Handle* outage, std::size_t count,
+                                   const Options& options, Result& result) const {
+    // Per-thread scratch, reused across cases
+    thread_local std::vector<double> sourceLoadScratch;
+    thread_local std::vector<GridState::Handle> shedScratch;
+    thread_local std::vector<GridState::Handle> busbarScratch;
+
+    busbarScratch.clear();
+    for (std::size_t i = 0; i < count; ++i) {
+        busbarScratch.push_back(state.sourceBusbar[outage[i]]);
+    }
+    std::sort(busbarScratch.begin(), busbarScratch.end());
+    busbarScratch.erase(std::unique(busbarScratch.begin(), busbarScratch.end()), busbarScratch.end());
+
+    result = Result();
+    if (base) {
+        // Transfers reach across the whole tie group
+        std::size_t outaged = busbarScratch.size();
+        for (std::size_t i = 0; i < outaged; ++i) {
+            std::size_t group = groupOf[busbarScratch[i]];
+            if (group != NONE) {
+                busbarScratch.insert(busbarScratch.end(), groups[group].begin(), groups[group].end());
+            }
+        }
+        std::sort(busbarScratch.begin(), busbarScratch.end());
+        busbarScratch.erase(std::unique(busbarScratch.begin(), busbarScratch.end()), busbarScratch.end());
+
+        std::shared_ptr<Grid> branch = base->fork();
+        for (std::size_t i = 0; i < count; ++i) {
+            branch->getState().setSourceOperational(outage[i], false);
+        }
+        branch->distributeLoadOptimally();
+        compareShed(branch->getState(), busbarScratch, options, result);
+    } else {
+        for (GridState::Handle busbar : busbarScratch) {
+            shedScratch.clear();
+            double served = state.evaluateBusbar(busbar, outage, count, sourceLoadScratch, shedScratch);
+            result.additionalShedKw += (state.busbarConnectedLoad(busbar) - served) - baseShedKw[busbar];
+
+            const auto& before = baseShed[busbar];
+            for (GridState::Handle load : shedScratch) {
+                if (std::binary_search(before.begin(), before.end(), load)) continue;
+                std::size_t tier = state.loadPriority[load] - 1;
+                result.additionalShedKwByPriority[tier] += state.loadDemand[load];
+                result.additionalLoadsShedByPriority[tier]++;
+                if (options.collectLoadIds) {
+                    result.affectedLoads.push_back(state.loadIds[load]);
+                }
+            }
+        }
+    }
+
+    if (result.additionalShedKw < options.minAdditionalShed) {
+        return false;
+    }
+
+    result.shedKw = baseTotalShedKw + result.additionalShedKw;
+    for (std::size_t i = 0; i < count; ++i) {
+        result.outagedSources.push_back(state.sourceIds[outage[i]]);
+    }
+    return true;
+}
+
+std::vector<ContingencyAnalyzer::Result> ContingencyAnalyzer::run(const Options& options) {
+    std::size_t k = options.outageSize;
+    std::vector<Result> results;
+    if (k == 0 || k > candidates.size()) {
+        return results;
+    }
+
+    auto forEach = [this](std::size_t count, const std::function<void(std::size_t)>& body) {
+        if (pool) {
+            pool->parallelFor(count, body);
+        } else {
+            for (std::size_t i = 0; i < count; ++i) body(i);
+        }
+    };
+
+    if (options.samples > 0) {
+        // Monte Carlo: draw the outage sets up front so the study is
+        // reproducible for a given seed whatever the thread count
+        std::mt19937 rng(options.seed);
+        std::vector<GridState::Handle> draws(options.samples * k);
+        std::vector<std::size_t> order(candidates.size());
+        for (std::size_t sample = 0; sample < options.samples; ++sample) {
+            std::iota(order.begin(), order.end(), 0);
+            for (std::size_t i = 0; i < k; ++i) {
+                std::uniform_int_distribution<std::size_t> pick(i, order.size() - 1);
+                std::swap(order[i], order[pick(rng)]);
+                draws[sample * k + i] = candidates[order[i]];
+            }
+        }
+
+        std::vector<Result> sampled(options.samples);
+        std::vector<std::uint8_t> kept(options.samples, 0);
+        forEach(options.samples, [&](std::size_t sample) {
+            kept[sample] = evaluate(&draws[sample * k], k, options, sampled[sample]) ? 1 : 0;
+        });
+        for (std::size_t sample = 0; sample < options.samples; ++sample) {
+            if (kept[sample]) results.push_back(std::move(sampled[sample]));
+        }
+    } else {
+        // Exhaustive: one task per first source of the combination, each
+        // enumerating the remaining k-1 sources in lexicographic order
+        std::vector<std::vector<Result>> perTask(candidates.size() - k + 1);
+        forEach(perTask.size(), [&](std::size_t first) {
+            std::vector<std::size_t> index(k);
+            std::vector<GridState::Handle> outage(k);
+            for (std::size_t i = 0; i < k; ++i) index[i] = first + i;
+
+            while (index[0] == first) {
+                for (std::size_t i = 0; i < k; ++i) outage[i] = candidates[index[i]];
+                Result result;
+                if (evaluate(outage.data(), k, options, result)) {
+                    perTask[first].push_back(std::move(result));
+                }
+
+                // Advance to the next combination
+                std::size_t pos = k;
+                while (pos > 1 && index[pos - 1] == candidates.size() - k + pos - 1) --pos;
+                if (pos == 1) break;
+                ++index[pos - 1];
+                for (std::size_t i = pos; i < k; ++i) index[i] = index[i - 1] + 1;
+            }
+        });
+        for (auto& task : perTask) {
+            for (auto& result : task) results.push_back(std::move(result));
+        }
+    }
+
+    std::stable_sort(results.begin(), results.end(), [](const Result& a, const Result& b) {
+        return a.additionalShedKw > b.additionalShedKw;
+    });
+    return results;
+}
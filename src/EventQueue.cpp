@@ -0,0 +1,90 @@
+// EventQueue.cpp
+#include "../include/EventQueue.h"
+#include "../include/Grid.h"
+#include <algorithm>
+#include <utility>
+
+bool GridEvent::apply(Grid& grid) const {
+    switch (type) {
+        case Type::SET_DEMAND:
+        case Type::CONNECT_LOAD:
+        case Type::DISCONNECT_LOAD: {
+            auto load = grid.getLoad(targetId);
+            if (!load) return false;
+            if (type == Type::SET_DEMAND) load->setPowerDemand(value);
+            else if (type == Type::CONNECT_LOAD) load->connect();
+            else load->disconnect();
+            return true;
+        }
+        case Type::SET_CAPACITY:
+        case Type::TRIP_SOURCE:
+        case Type::RESTORE_SOURCE: {
+            auto source = grid.getSource(targetId);
+            if (!source) return false;
+            if (type == Type::SET_CAPACITY) source->setCapacity(value);
+            else source->setOperational(type == Type::RESTORE_SOURCE);
+            return true;
+        }
+        case Type::OPEN_TIE:
+        case Type::CLOSE_TIE:
+            if (!grid.getTopology().findTie(targetId)) return false;
+            grid.setTieClosed(targetId, type == Type::CLOSE_TIE);
+            return true;
+        case Type::PROFILE_INTERVAL:
+            grid.applyLoadProfiles(time);
+            return true;
+        case Type::DISPATCH:
+            return true;
+    }
+    return false;
+}
+
+EventQueue::EventQueue() : nextSequence(0) {}
+
+bool EventQueue::later(const Entry& a, const Entry& b) {
+    // std heaps keep the largest element on top, so "larger" is later
+    if (a.event.time != b.event.time) {
+        return a.event.time > b.event.time;
+    }
+    return a.sequence > b.sequence;
+}
+
+void EventQueue::schedule(GridEvent event) {
+    heap.push_back({std::move(event), nextSequence++});
+    std::push_heap(heap.begin(), heap.end(), later);
+}
+
+void EventQueue::clear() {
+    heap.clear();
+}
+
+bool EventQueue::empty() const {
+    return heap.empty();
+}
+
+std::size_t EventQueue::size() const {
+    return heap.size();
+}
+
+EventQueue::Time EventQueue::nextTime() const {
+    return heap.front().event.time;
+}
+
+EventQueue::Time EventQueue::applyNext(Grid& grid, std::size_t& applied) {
+    Time now = nextTime();
+    applied = 0;
+    while (!heap.empty() && heap.front().event.time == now) {
+        std::pop_heap(heap.begin(), heap.end(), later);
+        GridEvent event = std::move(heap.back().event);
+        heap.pop_back();
+
+        if (event.apply(grid)) {
+            ++applied;
+        }
+        if (event.type == GridEvent::Type::PROFILE_INTERVAL) {
+            event.time = now + 1;
+            schedule(std::move(event));
+        }
+    }
+    return now;
+}
@@ -1,208 +1,694 @@
 // Grid.cpp
 #include "../include/Grid.h"
+#include "../include/CapacityIndex.h"
+#include "../include/Instrumentation.h"
 #include <iostream>
-#include <iomanip>
 #include <algorithm>
+#include <cmath>
+#include <limits>
 
-Grid::Grid(const std::string& name) : name(name), totalDemand(0.0), totalSupply(0.0), 
-                                      servedDemand(0.0), shedLoad(0.0) {}
+namespace {
+
+// Slack for rounding in the headroom index (kW)
+constexpr double HEADROOM_TOLERANCE = 1e-6;
+
+// Used slots of an ID column, sorted by ID for reports and reproducible
+// packing. Reads the state alone, so it needs no entity views.
+template <typename Used>
+void sortById(const GridState::IdColumn& ids, Used used, std::vector<GridState::Handle>& sorted) {
+    sorted.clear();
+    for (GridState::Handle handle = 0; handle < ids.size(); ++handle) {
+        if (used(handle)) {
+            sorted.push_back(handle);
+        }
+    }
+    std::sort(sorted.begin(), sorted.end(), [&ids](GridState::Handle a, GridState::Handle b) {
+        return ids[a] < ids[b];
+    });
+}
+
+} // namespace
+
+Grid::Grid(const std::string& name) : name(name), arena(std::make_shared<EntityArena>()),
+                                      lazyViews(false), state(std::make_unique<GridState>()),
+                                      powerFlowEnabled(false),
+                                      totalDemand(0.0), totalSupply(0.0), 
+                                      servedDemand(0.0), shedLoad(0.0), shedReporting(true),
+                                      idOrderValid(false) {}
+
+std::string Grid::getName() const {
+    return name;
+}
+
+const std::vector<std::shared_ptr<Busbar>>& Grid::getBusbars() {
+    createAllViews();
+    return busbars;
+}
+
+const std::vector<GridState::Handle>& Grid::getBusbarHandles() const {
+    return busbarHandles;
+}
+
+std::shared_ptr<Grid> Grid::fork() const {
+    auto branch = std::make_shared<Grid>(name);
+    branch->busbarHandles = busbarHandles;
+    branch->lazyViews = true;
+    branch->state = state->fork();
+    branch->topology = topology;
+    branch->powerFlow = powerFlow;
+    branch->powerFlowEnabled = powerFlowEnabled;
+    branch->loadProfiles = loadProfiles;
+    branch->dispatchPool = dispatchPool;
+    branch->allocationStrategy = allocationStrategy;
+    branch->totalDemand = totalDemand;
+    branch->totalSupply = totalSupply;
+    branch->servedDemand = servedDemand;
+    branch->shedLoad = shedLoad;
+    branch->shedEvents = shedEvents;
+    branch->shedReporting = shedReporting;
+    branch->loadsById = loadsById;
+    branch->sourcesById = sourcesById;
+    branch->idOrderValid = idOrderValid;
+    return branch;
+}
+
+std::shared_ptr<Load> Grid::loadView(GridState::Handle load) {
+    // Views made on demand are indexed like any other, so each is made once
+    if (Load* view = state->getLoadView(load)) {
+        return allLoads.find(view->getId());
+    }
+    auto view = arena->make<Load>(state->loadIds[load], state->loadDemand[load],
+                                  static_cast<LoadType>(state->loadType[load]),
+                                  static_cast<Priority>(state->loadPriority[load]));
+    state->bindLoadView(view.get(), load);
+    allLoads.insert(view);
+    return view;
+}
+
+std::shared_ptr<PowerSource> Grid::sourceView(GridState::Handle source) {
+    if (PowerSource* view = state->getSourceView(source)) {
+        return allSources.find(view->getId());
+    }
+    auto view = arena->make<PowerSource>(state->sourceIds[source], state->sourceCapacity[source]);
+    state->bindSourceView(view.get(), source);
+    allSources.insert(view);
+    return view;
+}
+
+std::shared_ptr<Busbar> Grid::busbarView(GridState::Handle busbar) {
+    if (Busbar* view = state->getBusbarView(busbar)) {
+        return busbarIndex.find(view->getId());
+    }
+    // A busbar's view comes with views of everything connected to it
+    std::vector<std::shared_ptr<Load>> loads;
+    std::vector<std::shared_ptr<PowerSource>> sources;
+    loads.reserve(state->busbarLoads[busbar].size());
+    for (GridState::Handle load : state->busbarLoads[busbar]) {
+        loads.push_back(loadView(load));
+    }
+    for (GridState::Handle source : state->busbarSources[busbar]) {
+        sources.push_back(sourceView(source));
+    }
+    auto view = arena->make<Busbar>(state->busbarIds[busbar]);
+    view->adopt(state.get(), busbar, std::move(loads), std::move(sources));
+    busbarIndex.insert(view);
+    return view;
+}
+
+void Grid::createAllViews() {
+    if (!lazyViews) {
+        return;
+    }
+    busbars.clear();
+    for (GridState::Handle busbar : busbarHandles) {
+        busbars.push_back(busbarView(busbar));
+    }
+    lazyViews = false;
+}
+
+std::shared_ptr<Busbar> Grid::createBusbar(const std::string& id) {
+    return arena->make<Busbar>(id);
+}
+
+std::shared_ptr<Load> Grid::createLoad(const std::string& id, double powerDemand, LoadType type, Priority priority) {
+    return arena->make<Load>(id, powerDemand, type, priority);
+}
+
+std::shared_ptr<PowerSource> Grid::createSource(const std::string& id, double capacity) {
+    return arena->make<PowerSource>(id, capacity);
+}
+
+void Grid::reserve(std::size_t busbarCount, std::size_t sourceCount, std::size_t loadCount) {
+    busbars.reserve(busbarCount);
+    busbarIndex.reserve(busbarCount);
+    allSources.reserve(sourceCount);
+    allLoads.reserve(loadCount);
+    state->reserve(busbarCount, sourceCount, loadCount);
+}
 
 void Grid::addBusbar(std::shared_ptr<Busbar> busbar) {
-    busbars.push_back(busbar);
+    busbar->attach(state.get());
+    if (!lazyViews) {
+        busbars.push_back(busbar);
+    }
+    busbarHandles.push_back(busbar->getIndex());
+    busbarIndex.insert(busbar);
 }
 
 void Grid::removeBusbar(const std::string& busbarId) {
-    auto it = std::find_if(busbars.begin(), busbars.end(),
-                          [&busbarId](const std::shared_ptr<Busbar>& busbar) {
-                              return busbar->getId() == busbarId;
-                          });
-    
-    if (it != busbars.end()) {
+    auto busbar = getBusbar(busbarId);
+    if (busbar) {
+        busbarIndex.erase(busbarId);
+        
         // Remove all loads and sources from the busbar
-        auto loads = (*it)->getConnectedLoads();
-        for (const auto& load : loads) {
-            allLoads.erase(load->getId());
+        // The busbar still holds its connections, so the views stay valid
+        // while the indexes drop theirs
+        for (const Load& load : busbar->getLoadView()) {
+            allLoads.erase(load.getId());
+        }
+        for (const PowerSource& source : busbar->getSourceView()) {
+            allSources.erase(source.getId());
         }
         
-        auto sources = (*it)->getConnectedSources();
-        for (const auto& source : sources) {
-            allSources.erase(source->getId());
+        // Ties to the busbar go with it, and its neighbours lose their transfers
+        for (GridState::Handle neighbour : topology.removeBusbar(busbar->getIndex())) {
+            state->markBusbarDirty(neighbour);
         }
         
-        busbars.erase(it);
+        busbarHandles.erase(std::find(busbarHandles.begin(), busbarHandles.end(), busbar->getIndex()));
+        busbar->detach();
+        if (!lazyViews) {
+            busbars.erase(std::find(busbars.begin(), busbars.end(), busbar));
+        }
+        idOrderValid = false;
     }
 }
 
 std::shared_ptr<Busbar> Grid::getBusbar(const std::string& busbarId) {
-    auto it = std::find_if(busbars.begin(), busbars.end(),
-                          [&busbarId](const std::shared_ptr<Busbar>& busbar) {
-                              return busbar->getId() == busbarId;
-                          });
-    
-    return (it != busbars.end()) ? *it : nullptr;
+    auto busbar = busbarIndex.find(busbarId);
+    if (!busbar && lazyViews) {
+        GridState::Handle handle = state->findBusbar(busbarId);
+        if (handle != GridState::INVALID_HANDLE && !state->getBusbarView(handle)) {
+            busbar = busbarView(handle);
+        }
+    }
+    return busbar;
+}
+
+void Grid::addTie(const std::string& tieId, const std::string& fromBusbarId, const std::string& toBusbarId,
+                  double limitKw, bool closed, double reactance) {
+    auto from = getBusbar(fromBusbarId);
+    auto to = getBusbar(toBusbarId);
+    if (!from || !to) {
+        std::cout << "Error: Busbar " << (from ? toBusbarId : fromBusbarId) << " not found.\n";
+        return;
+    }
+    if (!(reactance > 0.0)) {
+        std::cout << "Error: Bus tie " << tieId << " needs a positive reactance.\n";
+        return;
+    }
+    if (!topology.addTie(tieId, from->getIndex(), to->getIndex(), limitKw, closed, reactance)) {
+        std::cout << "Error: Bus tie " << tieId << " already exists or joins a busbar to itself.\n";
+        return;
+    }
+    state->markBusbarDirty(from->getIndex());
+    state->markBusbarDirty(to->getIndex());
+}
+
+void Grid::removeTie(const std::string& tieId) {
+    const Topology::Tie* tie = topology.findTie(tieId);
+    if (!tie) {
+        std::cout << "Error: Bus tie " << tieId << " not found.\n";
+        return;
+    }
+    state->markBusbarDirty(tie->from);
+    state->markBusbarDirty(tie->to);
+    topology.removeTie(tieId);
+}
+
+void Grid::setTieClosed(const std::string& tieId, bool closed) {
+    const Topology::Tie* tie = topology.findTie(tieId);
+    if (!tie) {
+        std::cout << "Error: Bus tie " << tieId << " not found.\n";
+        return;
+    }
+    state->markBusbarDirty(tie->from);
+    state->markBusbarDirty(tie->to);
+    topology.setClosed(tieId, closed);
+}
+
+void Grid::setTieLimit(const std::string& tieId, double limitKw) {
+    const Topology::Tie* tie = topology.findTie(tieId);
+    if (!tie) {
+        std::cout << "Error: Bus tie " << tieId << " not found.\n";
+        return;
+    }
+    state->markBusbarDirty(tie->from);
+    state->markBusbarDirty(tie->to);
+    topology.setLimit(tieId, limitKw);
+}
+
+const Topology& Grid::getTopology() const {
+    return topology;
+}
+
+Topology& Grid::getTopology() {
+    return topology;
+}
+
+Busbar* Grid::getOwningBusbar(const Load& load) {
+    // The grid state records the busbar of every attached load
+    if (state->getLoadView(load.getHandle()) != &load) {
+        return nullptr;
+    }
+    GridState::Handle busbar = state->loadBusbar[load.getHandle()];
+    Busbar* view = state->getBusbarView(busbar);
+    return view ? view : busbarView(busbar).get();
+}
+
+Busbar* Grid::getOwningBusbar(const PowerSource& source) {
+    if (state->getSourceView(source.getHandle()) != &source) {
+        return nullptr;
+    }
+    GridState::Handle busbar = state->sourceBusbar[source.getHandle()];
+    Busbar* view = state->getBusbarView(busbar);
+    return view ? view : busbarView(busbar).get();
 }
 
 void Grid::addLoad(std::shared_ptr<Load> load, const std::string& busbarId) {
     auto busbar = getBusbar(busbarId);
     if (busbar) {
         busbar->connectLoad(load);
-        allLoads[load->getId()] = load;
+        allLoads.insert(load);
+        idOrderValid = false;
     } else {
         std::cout << "Error: Busbar " << busbarId << " not found.\n";
     }
 }
 
 void Grid::removeLoad(const std::string& loadId) {
-    auto loadIt = allLoads.find(loadId);
-    if (loadIt != allLoads.end()) {
-        // Find busbar that contains this load
-        for (auto& busbar : busbars) {
-            busbar->disconnectLoad(loadId);
+    auto load = getLoad(loadId);
+    if (load) {
+        Busbar* busbar = getOwningBusbar(*load);
+        if (busbar) {
+            busbar->disconnectLoad(*load);
         }
         allLoads.erase(loadId);
+        idOrderValid = false;
     } else {
         std::cout << "Error: Load " << loadId << " not found.\n";
     }
 }
 
 std::shared_ptr<Load> Grid::getLoad(const std::string& loadId) {
-    auto it = allLoads.find(loadId);
-    return (it != allLoads.end()) ? it->second : nullptr;
+    auto load = allLoads.find(loadId);
+    if (!load && lazyViews) {
+        GridState::Handle handle = state->findLoad(loadId);
+        if (handle != GridState::INVALID_HANDLE && !state->getLoadView(handle)) {
+            load = loadView(handle);
+        }
+    }
+    return load;
+}
+
+void Grid::addLoads(const std::vector<LoadPlacement>& loads) {
+    // Exact reservations only pay off when the batch dominates; for a small
+    // batch on a large grid they would defeat the vectors' geometric growth
+    if (loads.size() >= allLoads.size()) {
+        reserve(busbars.size(), allSources.size(), allLoads.size() + loads.size());
+    }
+    for (const auto& placement : loads) {
+        placement.busbar->appendLoad(placement.load);
+        allLoads.insert(placement.load);
+    }
+    state->commitAppendedLoads();
+    idOrderValid = false;
 }
 
 void Grid::addSource(std::shared_ptr<PowerSource> source, const std::string& busbarId) {
     auto busbar = getBusbar(busbarId);
     if (busbar) {
         busbar->connectSource(source);
-        allSources[source->getId()] = source;
+        allSources.insert(source);
+        idOrderValid = false;
     } else {
         std::cout << "Error: Busbar " << busbarId << " not found.\n";
     }
 }
 
+void Grid::addSources(const std::vector<SourcePlacement>& sources) {
+    // Sources keep connection order, so they need no deferred sorting
+    if (sources.size() >= allSources.size()) {
+        reserve(busbars.size(), allSources.size() + sources.size(), allLoads.size());
+    }
+    for (const auto& placement : sources) {
+        placement.busbar->connectSource(placement.source);
+        allSources.insert(placement.source);
+    }
+    idOrderValid = false;
+}
+
 void Grid::removeSource(const std::string& sourceId) {
-    auto sourceIt = allSources.find(sourceId);
-    if (sourceIt != allSources.end()) {
-        // Find busbar that contains this source
-        for (auto& busbar : busbars) {
-            busbar->disconnectSource(sourceId);
+    auto source = getSource(sourceId);
+    if (source) {
+        Busbar* busbar = getOwningBusbar(*source);
+        if (busbar) {
+            busbar->disconnectSource(*source);
         }
         allSources.erase(sourceId);
+        idOrderValid = false;
     } else {
         std::cout << "Error: Power Source " << sourceId << " not found.\n";
     }
 }
 
 std::shared_ptr<PowerSource> Grid::getSource(const std::string& sourceId) {
-    auto it = allSources.find(sourceId);
-    return (it != allSources.end()) ? it->second : nullptr;
+    auto source = allSources.find(sourceId);
+    if (!source && lazyViews) {
+        GridState::Handle handle = state->findSource(sourceId);
+        if (handle != GridState::INVALID_HANDLE && !state->getSourceView(handle)) {
+            source = sourceView(handle);
+        }
+    }
+    return source;
+}
+
+void Grid::setLoadProfiles(std::shared_ptr<LoadProfiles> profiles) {
+    loadProfiles = profiles;
+}
+
+std::shared_ptr<LoadProfiles> Grid::getLoadProfiles() const {
+    return loadProfiles;
+}
+
+bool Grid::applyLoadProfiles(long long step) {
+    if (!loadProfiles) {
+        return false;
+    }
+    
+    double factors[LoadProfiles::LOAD_TYPE_COUNT];
+    loadProfiles->getFactorsForStep(step, factors);
+    return state->applyDemandFactors(factors, LoadProfiles::LOAD_TYPE_COUNT);
+}
+
+void Grid::setShedReporting(bool enabled) {
+    shedReporting = enabled;
+}
+
+void Grid::setAllocationStrategy(std::shared_ptr<AllocationStrategy> strategy) {
+    allocationStrategy = strategy;
+    state->setAllocationStrategy(strategy.get());
+}
+
+std::shared_ptr<AllocationStrategy> Grid::getAllocationStrategy() const {
+    return allocationStrategy;
+}
+
+void Grid::setCurtailment(bool enabled) {
+    state->setCurtailment(enabled);
+}
+
+bool Grid::isCurtailmentEnabled() const {
+    return state->isCurtailmentEnabled();
+}
+
+void Grid::setEconomicDispatch(bool enabled) {
+    state->setEconomicDispatch(enabled);
+}
+
+bool Grid::isEconomicDispatchEnabled() const {
+    return state->isEconomicDispatchEnabled();
+}
+
+void Grid::setPowerFlow(bool enabled) {
+    powerFlowEnabled = enabled;
+    if (!enabled) {
+        powerFlow.clear();
+    }
+}
+
+bool Grid::isPowerFlowEnabled() const {
+    return powerFlowEnabled;
+}
+
+void Grid::setThreadPool(std::shared_ptr<ThreadPool> pool) {
+    dispatchPool = pool;
 }
 
 void Grid::distributeLoadOptimally() {
-    // Reset all power sources
-    for (auto& sourcePair : allSources) {
-        sourcePair.second->resetLoading();
+    // Only busbars whose loads or sources changed since the last dispatch
+    // need to be solved again; the rest keep their current allocation
+    instrumentation::PhaseTimer dispatchTimer(instrumentation::Phase::DISPATCH);
+    // Tied busbars share transfers, so they are always solved together
+    topology.expandDirty(*state);
+    const auto& dirty = state->getDirtyBusbars();
+    shedEvents.clear();
+    // Shed lists per position in the dirty list, kept between dispatches
+    if (busbarShedScratch.size() < dirty.size()) {
+        busbarShedScratch.resize(dirty.size());
     }
     
-    // Reset load service status
-    for (auto& loadPair : allLoads) {
-        loadPair.second->setServed(false);
+    if (dispatchPool && dirty.size() > 1) {
+        // Busbars share no loads or sources, so they can be solved
+        // concurrently. Totals are then folded in busbar order, exactly as
+        // the serial path does, so the result is bit-for-bit identical.
+        busbarServedScratch.resize(dirty.size());
+        state->claimDispatchColumns();
+        dispatchPool->parallelFor(dirty.size(), [&](std::size_t i) {
+            busbarShedScratch[i].clear();
+            busbarServedScratch[i] = state->solveBusbar(dirty[i], busbarShedScratch[i]);
+        });
+        for (std::size_t i = 0; i < dirty.size(); ++i) {
+            state->commitBusbarServed(dirty[i], busbarServedScratch[i]);
+        }
+    } else {
+        for (std::size_t i = 0; i < dirty.size(); ++i) {
+            busbarShedScratch[i].clear();
+            state->dispatchBusbar(dirty[i], busbarShedScratch[i]);
+        }
     }
     
-    // First, try to distribute loads on each busbar
-    for (auto& busbar : busbars) {
-        if (!busbar->distributeLoadsToPowerSources()) {
-            // If not all loads could be served, perform load shedding
-            busbar->performLoadShedding();
+    // Then what the busbars could not serve alone, across closed ties
+    if (topology.hasClosedTies()) {
+        instrumentation::PhaseTimer timer(instrumentation::Phase::TRANSFER);
+        instrumentation::count(instrumentation::Counter::TRANSFERS, topology.transfer(*state, dirty));
+    }
+    // Outputs are only re-set once transfers have loaded the sources
+    if (state->isEconomicDispatchEnabled()) {
+        instrumentation::PhaseTimer timer(instrumentation::Phase::ECONOMIC);
+        for (GridState::Handle busbar : dirty) {
+            state->redispatchEconomically(busbar);
         }
     }
+    for (std::size_t i = 0; i < dirty.size(); ++i) {
+        recordBusbarShedLoads(dirty[i], busbarShedScratch[i]);
+    }
+    state->clearDirtyBusbars();
+    
+    if (powerFlowEnabled) {
+        instrumentation::PhaseTimer timer(instrumentation::Phase::POWER_FLOW);
+        powerFlow.solve(*state, topology);
+    }
+    
+    if (shedReporting && !shedEvents.empty()) {
+        instrumentation::PhaseTimer timer(instrumentation::Phase::SHED);
+        reportShedEvents();
+    }
     
     // Update statistics
     updateStatistics();
 }
 
-void Grid::performSystemWideLoadShedding() {
-    // Reset all power sources
-    for (auto& sourcePair : allSources) {
-        sourcePair.second->resetLoading();
+void Grid::recordBusbarShedLoads(GridState::Handle busbar, const std::vector<GridState::Handle>& shed) {
+    if (shed.empty()) {
+        return;
     }
-    
-    // Reset load service status
-    for (auto& loadPair : allLoads) {
-        loadPair.second->setServed(false);
+    instrumentation::PhaseTimer timer(instrumentation::Phase::SHED);
+    for (GridState::Handle load : shed) {
+        // Skip loads a transfer served after all
+        if (!state->loadServed[load]) {
+            shedEvents.push_back({load, busbar, state->loadDemand[load]});
+        }
     }
+}
+
+void Grid::reportShedEvents() const {
+    TableReportSink sink(std::cout);
+    writeShedEvents(sink, 0);
+}
+
+const std::vector<Grid::ShedEvent>& Grid::getShedEvents() const {
+    return shedEvents;
+}
+
+void Grid::performSystemWideLoadShedding() {
+    instrumentation::PhaseTimer dispatchTimer(instrumentation::Phase::DISPATCH);
     
-    // Collect all loads across the system
-    std::vector<std::shared_ptr<Load>> allLoadsList;
-    for (auto& loadPair : allLoads) {
-        if (loadPair.second->isLoadConnected()) {
-            allLoadsList.push_back(loadPair.second);
+    // Reset all power sources and load service status
+    instrumentation::PhaseTimer timer(instrumentation::Phase::RESET);
+    state->resetAll();
+    topology.clearFlows();
+    shedEvents.clear();
+    
+    // Collect all connected loads across the system by priority (critical
+    // first), in ID order within a priority so ties are reproducible. The
+    // ID order is cached, so a counting pass over the priorities is enough.
+    timer.next(instrumentation::Phase::SORT);
+    refreshIdOrder();
+    constexpr std::size_t PRIORITY_LIMIT = static_cast<std::size_t>(Priority::MINIMAL) + 1;
+    std::size_t tierStart[PRIORITY_LIMIT + 1] = {};
+    for (GridState::Handle load : loadsById) {
+        if (state->loadConnected[load]) {
+            ++tierStart[state->loadPriority[load] + 1];
         }
     }
+    for (std::size_t priority = 1; priority <= PRIORITY_LIMIT; ++priority) {
+        tierStart[priority] += tierStart[priority - 1];
+    }
+    std::vector<GridState::Handle>& allLoadsList = systemLoadsScratch;
+    allLoadsList.resize(tierStart[PRIORITY_LIMIT]);
+    for (GridState::Handle load : loadsById) {
+        if (state->loadConnected[load]) {
+            allLoadsList[tierStart[state->loadPriority[load]]++] = load;
+        }
+    }
+    const CowColumn<GridState::Handle>& sourceList = sourcesById;
     
-    // Sort loads by priority (critical first)
-    std::sort(allLoadsList.begin(), allLoadsList.end(), 
-              [](const std::shared_ptr<Load>& a, const std::shared_ptr<Load>& b) {
-                  return static_cast<int>(a->getPriority()) < static_cast<int>(b->getPriority());
-              });
-    
-    // Try to serve loads by priority
-    for (auto& load : allLoadsList) {
-        double demandPower = load->getPowerDemand();
-        bool loadServed = false;
+    timer.next(instrumentation::Phase::ALLOCATE);
+    std::vector<double>& sourceLoading = state->sourceCurrentLoad.edit();
+    std::vector<std::uint8_t>& servedFlags = state->loadServed.edit();
+    if (allocationStrategy) {
+        // Pack the whole system as one problem
+        AllocationProblem& problem = systemProblemScratch;
+        std::vector<GridState::Handle>& availableSources = availableSourcesScratch;
+        std::vector<std::size_t>& assignment = assignmentScratch;
+        problem.demands.clear();
+        problem.priorities.clear();
+        problem.capacities.clear();
+        availableSources.clear();
+        for (GridState::Handle load : allLoadsList) {
+            problem.demands.push_back(state->loadDemand[load]);
+            problem.priorities.push_back(state->loadPriority[load]);
+        }
+        for (GridState::Handle source : sourceList) {
+            if (state->sourceOperational[source]) {
+                availableSources.push_back(source);
+                problem.capacities.push_back(state->sourceCapacity[source]);
+            }
+        }
+        allocationStrategy->allocate(problem, assignment);
         
-        // Find any source in the system that can handle this load
-        for (auto& sourcePair : allSources) {
-            auto& source = sourcePair.second;
-            if (source->isOperational() && source->canSupplyPower(demandPower)) {
-                source->addLoad(demandPower);
-                load->setServed(true);
-                loadServed = true;
-                break;
+        for (std::size_t i = 0; i < allLoadsList.size(); ++i) {
+            GridState::Handle load = allLoadsList[i];
+            if (assignment[i] != AllocationStrategy::UNSERVED) {
+                sourceLoading[availableSources[assignment[i]]] += problem.demands[i];
+                servedFlags[load] = 1;
+            } else {
+                shedEvents.push_back({load, GridState::INVALID_HANDLE, problem.demands[i]});
+            }
+        }
+    } else {
+        // Index the headroom of operational sources so each load finds the
+        // first source (in ID order) that can take it without a full scan
+        headroomScratch.assign(sourceList.size(), -std::numeric_limits<double>::infinity());
+        for (std::size_t i = 0; i < sourceList.size(); ++i) {
+            GridState::Handle source = sourceList[i];
+            if (state->sourceOperational[source]) {
+                headroomScratch[i] = state->sourceCapacity[source] - sourceLoading[source];
             }
         }
+        CapacityIndex& index = capacityScratch;
+        index.assign(headroomScratch);
         
-        if (!loadServed) {
-            // This load cannot be served (it will be shed)
-            load->setServed(false);
-            std::cout << "System-wide load shedding: " << load->getId() << " (" 
-                      << load->getTypeString() << ", " << load->getPowerDemand() 
-                      << " kW) was shed.\n";
+        // Try to serve loads by priority
+        std::uint64_t probes = 0;
+        for (GridState::Handle load : allLoadsList) {
+            double demandPower = state->loadDemand[load];
+            bool loadServed = false;
+            
+            // The index works on rounded headroom, so candidates are confirmed
+            // with the exact capacity check before taking the load
+            std::size_t candidate = index.findFirst(demandPower - HEADROOM_TOLERANCE);
+            while (candidate != CapacityIndex::NONE) {
+                if constexpr (instrumentation::ENABLED) {
+                    ++probes;
+                }
+                GridState::Handle source = sourceList[candidate];
+                if (sourceLoading[source] + demandPower <= state->sourceCapacity[source]) {
+                    sourceLoading[source] += demandPower;
+                    servedFlags[load] = 1;
+                    index.setHeadroom(candidate, state->sourceCapacity[source] - sourceLoading[source]);
+                    loadServed = true;
+                    break;
+                }
+                candidate = index.findFirst(demandPower - HEADROOM_TOLERANCE, candidate + 1);
+            }
+            
+            if (!loadServed) {
+                // This load cannot be served (it will be shed)
+                shedEvents.push_back({load, GridState::INVALID_HANDLE, demandPower});
+            }
+        }
+        instrumentation::count(instrumentation::Counter::SOURCE_PROBES, probes);
+    }
+    instrumentation::count(instrumentation::Counter::ALLOCATIONS, allLoadsList.size() - shedEvents.size());
+    instrumentation::count(instrumentation::Counter::LOADS_SHED, shedEvents.size());
+    
+    if (state->isEconomicDispatchEnabled()) {
+        timer.next(instrumentation::Phase::ECONOMIC);
+        for (GridState::Handle busbar : getBusbarHandles()) {
+            state->redispatchEconomically(busbar);
         }
     }
     
+    // The per-busbar allocation was bypassed, so rebuild the running totals
+    timer.next(instrumentation::Phase::STATS);
+    state->recomputeTotals();
+    
+    if (powerFlowEnabled) {
+        timer.next(instrumentation::Phase::POWER_FLOW);
+        powerFlow.solve(*state, topology);
+    }
+    
+    if (shedReporting && !shedEvents.empty()) {
+        timer.next(instrumentation::Phase::SHED);
+        reportShedEvents();
+    }
+    timer.stop();
+    
     // Update statistics
     updateStatistics();
 }
 
-void Grid::updateStatistics() {
-    totalDemand = 0.0;
-    servedDemand = 0.0;
-    totalSupply = 0.0;
-    
-    // Calculate total demand and served demand
-    for (auto& loadPair : allLoads) {
-        if (loadPair.second->isLoadConnected()) {
-            double demand = loadPair.second->getPowerDemand();
-            totalDemand += demand;
-            
-            if (loadPair.second->isLoadServed()) {
-                servedDemand += demand;
-            }
-        }
+void Grid::refreshIdOrder() {
+    if (idOrderValid) {
+        return;
     }
+    sortById(state->loadIds, [this](GridState::Handle load) { return state->isLoadSlotUsed(load); },
+             loadsById.edit());
+    sortById(state->sourceIds, [this](GridState::Handle source) { return state->isSourceSlotUsed(source); },
+             sourcesById.edit());
+    idOrderValid = true;
+}
+
+void Grid::updateStatistics() {
+    instrumentation::PhaseTimer timer(instrumentation::Phase::STATS);
     
-    // Calculate total supply
-    for (auto& sourcePair : allSources) {
-        if (sourcePair.second->isOperational()) {
-            totalSupply += sourcePair.second->getCapacity();
-        }
-    }
+    // Totals are maintained incrementally by the grid state as loads,
+    // sources and allocations change
+    totalDemand = state->getTotalDemand();
+    servedDemand = state->getServedDemand();
+    totalSupply = state->getTotalSupply();
     
     // Calculate shed load
     shedLoad = totalDemand - servedDemand;
 }
 
+void Grid::recomputeStatistics() {
+    state->recomputeTotals();
+    updateStatistics();
+}
+
 double Grid::getTotalDemand() const {
     return totalDemand;
 }
@@ -215,10 +701,22 @@ double Grid::getServedDemand() const {
     return servedDemand;
 }
 
+double Grid::getOperatingCost() const {
+    return state->getOperatingCost();
+}
+
 double Grid::getShedLoad() const {
     return shedLoad;
 }
 
+std::size_t Grid::getTieOverloadCount() const {
+    return powerFlow.getOverloadCount();
+}
+
+double Grid::getMaxTieLoadingPercent() const {
+    return powerFlow.getMaxLoadingPercent();
+}
+
 double Grid::getSupplyUtilizationPercent() const {
     if (totalSupply > 0.0) {
         return (servedDemand / totalSupply) * 100.0;
@@ -226,78 +724,81 @@ double Grid::getSupplyUtilizationPercent() const {
     return 0.0;
 }
 
+const GridState& Grid::getState() const {
+    return *state;
+}
+
+GridState& Grid::getState() {
+    return *state;
+}
+
 void Grid::printSystemReport() const {
-    std::cout << "\n======= " << name << " SYSTEM REPORT =======\n";
-    
-    // Print busbars and their status
-    std::cout << "\nBUSBARS:\n";
-    std::cout << std::left << std::setw(15) << "ID" 
-              << std::setw(10) << "Status" 
-              << std::setw(15) << "Connected Load" 
-              << std::setw(20) << "Available Power" << "\n";
-    std::cout << std::string(60, '-') << "\n";
+    TableReportSink sink(std::cout);
+    writeReport(sink);
+}
+
+void Grid::writeReport(ReportSink& sink) const {
+    sink.beginReport(name);
     
-    for (const auto& busbar : busbars) {
-        std::cout << std::left << std::setw(15) << busbar->getId() 
-                  << std::setw(10) << (busbar->isEnergized() ? "Energized" : "De-energized") 
-                  << std::setw(15) << busbar->getTotalConnectedLoad() << " kW" 
-                  << std::setw(20) << busbar->getTotalAvailablePower() << " kW" << "\n";
+    // Everything is read from the state, so a fork reports without
+    // creating views
+    sink.beginSection(ReportSection::BUSBARS);
+    for (GridState::Handle busbar : busbarHandles) {
+        sink.busbar({state->busbarIds[busbar], state->isBusbarEnergized(busbar), 
+                     state->busbarConnectedLoad(busbar), state->busbarAvailablePower(busbar)});
     }
     
-    // Print power sources
-    std::cout << "\nPOWER SOURCES:\n";
-    std::cout << std::left << std::setw(15) << "ID" 
-              << std::setw(10) << "Status" 
-              << std::setw(15) << "Capacity" 
-              << std::setw(15) << "Current Load" 
-              << std::setw(20) << "Available Capacity" << "\n";
-    std::cout << std::string(75, '-') << "\n";
-    
-    for (const auto& sourcePair : allSources) {
-        const auto& source = sourcePair.second;
-        std::cout << std::left << std::setw(15) << source->getId() 
-                  << std::setw(10) << (source->isOperational() ? "Online" : "Offline") 
-                  << std::setw(15) << source->getCapacity() << " kW" 
-                  << std::setw(15) << source->getCurrentLoad() << " kW"
-                  << std::setw(20) << source->getAvailableCapacity() << " kW" << "\n";
+    if (!topology.getTies().empty()) {
+        sink.beginSection(ReportSection::TIES);
+        for (const Topology::Tie& tie : topology.getTies()) {
+            sink.tie({tie.id, state->busbarIds[tie.from], state->busbarIds[tie.to],
+                      tie.closed, tie.limitKw, tie.flowKw});
+        }
     }
     
-    // Print loads
-    std::cout << "\nLOADS:\n";
-    std::cout << std::left << std::setw(15) << "ID" 
-              << std::setw(15) << "Type" 
-              << std::setw(15) << "Priority" 
-              << std::setw(15) << "Demand" 
-              << std::setw(10) << "Connected" 
-              << std::setw(10) << "Served" << "\n";
-    std::cout << std::string(80, '-') << "\n";
-    
-    for (const auto& loadPair : allLoads) {
-        const auto& load = loadPair.second;
-        std::cout << std::left << std::setw(15) << load->getId() 
-                  << std::setw(15) << load->getTypeString() 
-                  << std::setw(15) << load->getPriorityString() 
-                  << std::setw(15) << load->getPowerDemand() << " kW"
-                  << std::setw(10) << (load->isLoadConnected() ? "Yes" : "No") 
-                  << std::setw(10) << (load->isLoadServed() ? "Yes" : "No") << "\n";
+    if (powerFlowEnabled && topology.hasClosedTies()) {
+        sink.beginSection(ReportSection::POWER_FLOW);
+        for (const Topology::Tie& tie : topology.getTies()) {
+            if (!tie.closed) continue;
+            double flow = std::abs(tie.powerFlowKw);
+            sink.powerFlow({tie.id, state->busbarIds[tie.from], state->busbarIds[tie.to], tie.powerFlowKw,
+                            tie.limitKw, tie.limitKw > 0.0 ? flow / tie.limitKw * 100.0 : 0.0,
+                            flow > tie.limitKw + PowerFlow::OVERLOAD_TOLERANCE});
+        }
     }
     
-    // Print system statistics
-    std::cout << "\nSYSTEM STATISTICS:\n";
-    std::cout << "Total Supply Capacity: " << totalSupply << " kW\n";
-    std::cout << "Total Connected Load: " << totalDemand << " kW\n";
-    std::cout << "Total Served Load: " << servedDemand << " kW\n";
-    std::cout << "Total Shed Load: " << shedLoad << " kW\n";
-    
-    double supplyUtilization = getSupplyUtilizationPercent();
-    std::cout << "Supply Utilization: " << supplyUtilization << "%\n";
+    std::vector<GridState::Handle> sorted;
+    sink.beginSection(ReportSection::SOURCES);
+    sortById(state->sourceIds, [this](GridState::Handle source) { return state->isSourceSlotUsed(source); },
+             sorted);
+    for (GridState::Handle source : sorted) {
+        bool operational = state->sourceOperational[source] != 0;
+        double capacity = state->sourceCapacity[source];
+        double currentLoad = state->sourceCurrentLoad[source];
+        sink.source({state->sourceIds[source], state->busbarIds[state->sourceBusbar[source]],
+                     operational, capacity, currentLoad, operational ? capacity - currentLoad : 0.0});
+    }
     
-    if (totalDemand > 0.0) {
-        double serviceLevel = (servedDemand / totalDemand) * 100.0;
-        std::cout << "Service Level: " << serviceLevel << "%\n";
-    } else {
-        std::cout << "Service Level: N/A (no demand)\n";
+    sink.beginSection(ReportSection::LOADS);
+    sortById(state->loadIds, [this](GridState::Handle load) { return state->isLoadSlotUsed(load); },
+             sorted);
+    for (GridState::Handle load : sorted) {
+        sink.load({state->loadIds[load], state->busbarIds[state->loadBusbar[load]],
+                   static_cast<LoadType>(state->loadType[load]), static_cast<Priority>(state->loadPriority[load]),
+                   state->loadDemand[load], state->loadConnected[load] != 0, state->loadServed[load] != 0,
+                   state->loadServedPower(load)});
     }
     
-    std::cout << "=================================\n\n";
+    sink.endReport({name, totalSupply, totalDemand, servedDemand, shedLoad});
+}
+
+void Grid::writeShedEvents(ReportSink& sink, long long step) const {
+    for (const ShedEvent& event : shedEvents) {
+        std::string_view busbarId;
+        if (event.busbar != GridState::INVALID_HANDLE) {
+            busbarId = state->busbarIds[event.busbar];
+        }
+        sink.shed({step, state->loadIds[event.load], busbarId, static_cast<LoadType>(state->loadType[event.load]),
+                   static_cast<Priority>(state->loadPriority[event.load]), event.demandKw});
+    }
 }
\ No newline at end of file
@@ -0,0 +1,506 @@
+// GridSnapshot.cpp
+#include "../include/GridSnapshot.h"
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <type_traits>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define GRID_SNAPSHOT_MMAP 1
+#endif
+
+namespace {
+
+const char MAGIC[8] = {'P', 'G', 'S', 'N', 'A', 'P', '\r', '\n'};
+const std::uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+// On-disk layout. Every record is a multiple of 8 bytes so the arrays stay
+// aligned when the file is mapped.
+struct StringRef {
+    std::uint64_t offset;  // Into the string pool
+    std::uint64_t length;
+};
+
+struct Header {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t byteOrder;
+    std::uint64_t busbarCount;
+    std::uint64_t sourceCount;
+    std::uint64_t loadCount;
+    std::uint64_t profileIntervals;  // 0 when the grid has no load profiles
+    std::uint64_t stringBytes;
+    StringRef name;
+    std::uint64_t tieCount;          // Since version 2
+    std::uint64_t costSegmentCount;  // Since version 4
+};
+
+// Older headers end before the fields added since
+const std::size_t VERSION_1_HEADER_SIZE = offsetof(Header, tieCount);
+const std::size_t VERSION_3_HEADER_SIZE = offsetof(Header, costSegmentCount);
+
+struct BusbarRecord {
+    StringRef id;
+    std::uint64_t sourceCount;  // Records that follow for this busbar
+    std::uint64_t loadCount;
+    std::uint8_t needsDispatch;
+    std::uint8_t padding[7];
+};
+
+struct SourceRecord {
+    StringRef id;
+    double capacity;
+    double currentLoad;
+    std::uint8_t operational;
+    std::uint8_t padding[7];
+    double minOutput;            // Since version 4
+    std::uint64_t costSegments;  // Since version 4: cost records of its curve
+};
+
+// Source records before version 4 end before minOutput
+const std::size_t VERSION_3_SOURCE_RECORD_SIZE = offsetof(SourceRecord, minOutput);
+
+struct LoadRecord {
+    StringRef id;
+    double demand;
+    double baseDemand;
+    double profileScale;
+    std::uint8_t type;
+    std::uint8_t priority;
+    std::uint8_t connected;
+    std::uint8_t served;       // GridState::CURTAILED since version 3
+    std::uint8_t curtailable;  // Since version 3
+    std::uint8_t padding[3];
+    double servedKw;           // Since version 3; used when curtailed
+};
+
+// Load records before version 3 end before servedKw
+const std::size_t VERSION_2_LOAD_RECORD_SIZE = offsetof(LoadRecord, servedKw);
+
+struct TieRecord {
+    StringRef id;
+    std::uint64_t from;  // Busbar record indexes
+    std::uint64_t to;
+    double limit;
+    double flow;
+    std::uint8_t closed;
+    std::uint8_t padding[7];
+    double reactance;  // Since version 5
+};
+
+// Tie records before version 5 end before reactance
+const std::size_t VERSION_4_TIE_RECORD_SIZE = offsetof(TieRecord, reactance);
+
+// Cost curve pieces, each source's in turn in source record order
+struct CostRecord {
+    double upToKw;
+    double costPerKwh;
+};
+
+static_assert(sizeof(Header) % 8 == 0 && sizeof(BusbarRecord) % 8 == 0 &&
+              sizeof(SourceRecord) % 8 == 0 && sizeof(LoadRecord) % 8 == 0 &&
+              sizeof(TieRecord) % 8 == 0 && sizeof(CostRecord) % 8 == 0,
+              "snapshot records must keep 8-byte alignment");
+static_assert(std::is_trivially_copyable<Header>::value &&
+              std::is_trivially_copyable<LoadRecord>::value,
+              "snapshot records are copied as raw bytes");
+
+// Read-only view of a whole file: mapped where the platform allows,
+// otherwise read into memory
+class MappedFile {
+private:
+    const char* data;
+    std::size_t size;
+    std::vector<char> buffer;
+#ifdef GRID_SNAPSHOT_MMAP
+    void* mapping;
+#endif
+
+public:
+    MappedFile() : data(nullptr), size(0) {
+#ifdef GRID_SNAPSHOT_MMAP
+        mapping = nullptr;
+#endif
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile() {
+#ifdef GRID_SNAPSHOT_MMAP
+        if (mapping) {
+            munmap(mapping, size);
+        }
+#endif
+    }
+
+    bool open(const std::string& path) {
+#ifdef GRID_SNAPSHOT_MMAP
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat info;
+        if (fstat(fd, &info) != 0) {
+            ::close(fd);
+            return false;
+        }
+        size = static_cast<std::size_t>(info.st_size);
+        if (size > 0) {
+            int flags = MAP_PRIVATE;
+#ifdef MAP_POPULATE
+            flags |= MAP_POPULATE;  // Fault the pages in up front
+#endif
+            void* address = mmap(nullptr, size, PROT_READ, flags, fd, 0);
+            if (address == MAP_FAILED) {
+                ::close(fd);
+                return false;
+            }
+            mapping = address;
+            data = static_cast<const char*>(address);
+        }
+        ::close(fd);
+        return true;
+#else
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        if (!file) {
+            return false;
+        }
+        size = static_cast<std::size_t>(file.tellg());
+        buffer.resize(size);
+        file.seekg(0);
+        file.read(buffer.data(), static_cast<std::streamsize>(size));
+        data = buffer.data();
+        return static_cast<bool>(file);
+#endif
+    }
+
+    const char* getData() const { return data; }
+    std::size_t getSize() const { return size; }
+};
+
+// Records of older versions may be shorter; their missing fields read as 0
+template <typename T>
+T readRecord(const char* base, std::size_t index, std::size_t recordSize = sizeof(T)) {
+    T record = {};
+    std::memcpy(&record, base + index * recordSize, recordSize);
+    return record;
+}
+
+StringRef appendString(std::string& pool, const std::string& text) {
+    StringRef ref{pool.size(), text.size()};
+    pool += text;
+    return ref;
+}
+
+template <typename T>
+void writeArray(std::ofstream& file, const std::vector<T>& records) {
+    file.write(reinterpret_cast<const char*>(records.data()),
+               static_cast<std::streamsize>(records.size() * sizeof(T)));
+}
+
+} // namespace
+
+bool GridSnapshot::save(const Grid& grid, const std::string& path) {
+    const GridState& state = grid.getState();
+    const auto& busbars = grid.getBusbarHandles();
+
+    std::vector<BusbarRecord> busbarRecords;
+    std::vector<SourceRecord> sourceRecords;
+    std::vector<LoadRecord> loadRecords;
+    std::vector<TieRecord> tieRecords;
+    std::vector<CostRecord> costRecords;
+    std::vector<double> profileFactors;
+    std::string strings;
+    busbarRecords.reserve(busbars.size());
+
+    Header header = {};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.byteOrder = BYTE_ORDER_MARK;
+    header.name = appendString(strings, grid.getName());
+
+    std::vector<std::uint64_t> recordOfBusbar(state.busbarSlotCount());
+    for (GridState::Handle index : busbars) {
+        recordOfBusbar[index] = busbarRecords.size();
+        const auto& sources = state.busbarSources[index];
+        const auto& loads = state.busbarLoads[index];
+
+        BusbarRecord busbarRecord = {};
+        busbarRecord.id = appendString(strings, state.busbarIds[index]);
+        busbarRecord.sourceCount = sources.size();
+        busbarRecord.loadCount = loads.size();
+        busbarRecord.needsDispatch = state.isBusbarDirty(index) ? 1 : 0;
+        busbarRecords.push_back(busbarRecord);
+
+        for (GridState::Handle source : sources) {
+            SourceRecord record = {};
+            record.id = appendString(strings, state.sourceIds[source]);
+            record.capacity = state.sourceCapacity[source];
+            record.currentLoad = state.sourceCurrentLoad[source];
+            record.operational = state.sourceOperational[source];
+            record.minOutput = state.sourceMinOutput[source];
+            record.costSegments = state.sourceCostCurve[source].size();
+            for (const CostSegment& segment : state.sourceCostCurve[source]) {
+                costRecords.push_back({segment.upToKw, segment.costPerKwh});
+            }
+            sourceRecords.push_back(record);
+        }
+        // Priority order, ties in connection order, as the busbar dispatches
+        for (GridState::Handle load : loads) {
+            LoadRecord record = {};
+            record.id = appendString(strings, state.loadIds[load]);
+            record.demand = state.loadDemand[load];
+            record.baseDemand = state.loadBaseDemand[load];
+            record.profileScale = state.loadProfileScale[load];
+            record.type = state.loadType[load];
+            record.priority = state.loadPriority[load];
+            record.connected = state.loadConnected[load];
+            record.served = state.loadServed[load];
+            record.curtailable = state.loadCurtailable[load];
+            record.servedKw = state.loadServedPower(load);
+            loadRecords.push_back(record);
+        }
+    }
+
+    for (const Topology::Tie& tie : grid.getTopology().getTies()) {
+        TieRecord record = {};
+        record.id = appendString(strings, tie.id);
+        record.from = recordOfBusbar[tie.from];
+        record.to = recordOfBusbar[tie.to];
+        record.limit = tie.limitKw;
+        record.flow = tie.flowKw;
+        record.closed = tie.closed ? 1 : 0;
+        record.reactance = tie.reactance;
+        tieRecords.push_back(record);
+    }
+
+    auto profiles = grid.getLoadProfiles();
+    if (profiles) {
+        header.profileIntervals = profiles->getIntervalCount();
+        for (std::size_t type = 0; type < LoadProfiles::LOAD_TYPE_COUNT; ++type) {
+            for (std::size_t interval = 0; interval < header.profileIntervals; ++interval) {
+                profileFactors.push_back(profiles->getFactor(static_cast<LoadType>(type), interval));
+            }
+        }
+    }
+
+    header.busbarCount = busbarRecords.size();
+    header.sourceCount = sourceRecords.size();
+    header.loadCount = loadRecords.size();
+    header.tieCount = tieRecords.size();
+    header.costSegmentCount = costRecords.size();
+    header.stringBytes = strings.size();
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        lastError = "cannot write " + path;
+        return false;
+    }
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    writeArray(file, busbarRecords);
+    writeArray(file, sourceRecords);
+    writeArray(file, loadRecords);
+    writeArray(file, tieRecords);
+    writeArray(file, costRecords);
+    writeArray(file, profileFactors);
+    file.write(strings.data(), static_cast<std::streamsize>(strings.size()));
+    file.close();
+    if (!file) {
+        lastError = "error writing " + path;
+        return false;
+    }
+    return true;
+}
+
+std::shared_ptr<Grid> GridSnapshot::load(const std::string& path) {
+    MappedFile file;
+    if (!file.open(path)) {
+        lastError = "cannot open " + path;
+        return nullptr;
+    }
+
+    const char* data = file.getData();
+    std::size_t size = file.getSize();
+    if (size < VERSION_1_HEADER_SIZE || std::memcmp(data, MAGIC, sizeof(MAGIC)) != 0) {
+        lastError = path + ": not a grid snapshot";
+        return nullptr;
+    }
+    Header header = {};
+    std::memcpy(&header, data, VERSION_1_HEADER_SIZE);
+    if (header.byteOrder != BYTE_ORDER_MARK) {
+        lastError = path + ": snapshot was written with a different byte order";
+        return nullptr;
+    }
+    if (header.version < 1 || header.version > VERSION) {
+        lastError = path + ": unsupported snapshot version " + std::to_string(header.version);
+        return nullptr;
+    }
+    std::size_t headerSize = header.version == 1 ? VERSION_1_HEADER_SIZE
+                           : header.version < 4 ? VERSION_3_HEADER_SIZE : sizeof(Header);
+    if (size < headerSize) {
+        lastError = path + ": snapshot is truncated or damaged";
+        return nullptr;
+    }
+    std::memcpy(&header, data, headerSize);
+    std::size_t sourceRecordSize = header.version < 4 ? VERSION_3_SOURCE_RECORD_SIZE : sizeof(SourceRecord);
+    std::size_t loadRecordSize = header.version < 3 ? VERSION_2_LOAD_RECORD_SIZE : sizeof(LoadRecord);
+    std::size_t tieRecordSize = header.version < 5 ? VERSION_4_TIE_RECORD_SIZE : sizeof(TieRecord);
+
+    // Every section must fit in what is left of the file
+    std::size_t remaining = size - headerSize;
+    auto takeSection = [&remaining](std::uint64_t count, std::size_t recordSize) {
+        if (count > remaining / recordSize) return false;
+        remaining -= static_cast<std::size_t>(count) * recordSize;
+        return true;
+    };
+    if (!takeSection(header.busbarCount, sizeof(BusbarRecord)) ||
+        !takeSection(header.sourceCount, sourceRecordSize) ||
+        !takeSection(header.loadCount, loadRecordSize) ||
+        !takeSection(header.tieCount, tieRecordSize) ||
+        !takeSection(header.costSegmentCount, sizeof(CostRecord)) ||
+        header.profileIntervals > remaining / (sizeof(double) * LoadProfiles::LOAD_TYPE_COUNT) ||
+        !takeSection(header.profileIntervals * LoadProfiles::LOAD_TYPE_COUNT, sizeof(double)) ||
+        remaining != header.stringBytes) {
+        lastError = path + ": snapshot is truncated or damaged";
+        return nullptr;
+    }
+
+    const char* busbarData = data + headerSize;
+    const char* sourceData = busbarData + header.busbarCount * sizeof(BusbarRecord);
+    const char* loadData = sourceData + header.sourceCount * sourceRecordSize;
+    const char* tieData = loadData + header.loadCount * loadRecordSize;
+    const char* costData = tieData + header.tieCount * tieRecordSize;
+    const char* profileData = costData + header.costSegmentCount * sizeof(CostRecord);
+    const char* strings = profileData + header.profileIntervals * LoadProfiles::LOAD_TYPE_COUNT * sizeof(double);
+
+    bool damaged = false;
+    auto readString = [&](const StringRef& ref) {
+        if (ref.offset > header.stringBytes || ref.length > header.stringBytes - ref.offset) {
+            damaged = true;
+            return std::string();
+        }
+        return std::string(strings + ref.offset, static_cast<std::size_t>(ref.length));
+    };
+
+    auto grid = std::make_shared<Grid>(readString(header.name));
+    grid->reserve(header.busbarCount, header.sourceCount, header.loadCount);
+
+    std::uint64_t nextSource = 0;
+    std::uint64_t nextLoad = 0;
+    std::uint64_t nextCost = 0;
+    std::vector<GridState::Handle> pendingDispatch;
+    for (std::uint64_t i = 0; i < header.busbarCount && !damaged; ++i) {
+        BusbarRecord busbarRecord = readRecord<BusbarRecord>(busbarData, i);
+        if (busbarRecord.sourceCount > header.sourceCount - nextSource ||
+            busbarRecord.loadCount > header.loadCount - nextLoad) {
+            damaged = true;
+            break;
+        }
+
+        auto busbar = grid->createBusbar(readString(busbarRecord.id));
+        grid->addBusbar(busbar);
+        busbar->reserve(busbarRecord.loadCount, busbarRecord.sourceCount);
+        if (busbarRecord.needsDispatch) {
+            pendingDispatch.push_back(busbar->getIndex());
+        }
+
+        for (std::uint64_t end = nextSource + busbarRecord.sourceCount; nextSource < end; ++nextSource) {
+            SourceRecord record = readRecord<SourceRecord>(sourceData, nextSource, sourceRecordSize);
+            if (record.costSegments > header.costSegmentCount - nextCost) {
+                damaged = true;
+                break;
+            }
+            auto source = grid->createSource(readString(record.id), record.capacity);
+            source->currentLoad = record.currentLoad;
+            source->operational = record.operational != 0;
+            source->minOutput = record.minOutput;
+            for (std::uint64_t end = nextCost + record.costSegments; nextCost < end; ++nextCost) {
+                CostRecord cost = readRecord<CostRecord>(costData, nextCost);
+                source->costCurve.push_back({cost.upToKw, cost.costPerKwh});
+            }
+            if (!isConvexCostCurve(source->costCurve)) {
+                damaged = true;
+                break;
+            }
+            grid->addSource(source, busbar->getId());
+        }
+
+        for (std::uint64_t end = nextLoad + busbarRecord.loadCount; nextLoad < end; ++nextLoad) {
+            LoadRecord record = readRecord<LoadRecord>(loadData, nextLoad, loadRecordSize);
+            if (record.type >= LoadProfiles::LOAD_TYPE_COUNT || record.priority < 1 || record.priority > 5) {
+                damaged = true;
+                break;
+            }
+            auto load = grid->createLoad(readString(record.id), record.demand,
+                                         static_cast<LoadType>(record.type),
+                                         static_cast<Priority>(record.priority));
+            load->baseDemand = record.baseDemand;
+            load->profileScale = record.profileScale;
+            load->isServed = record.served != 0;
+            load->curtailable = record.curtailable != 0;
+            load->servedPower = record.served == GridState::CURTAILED ? record.servedKw : record.demand;
+            grid->addLoad(load, busbar->getId());
+            if (!record.connected) {
+                load->disconnect();
+            }
+        }
+    }
+    for (std::uint64_t i = 0; i < header.tieCount && !damaged; ++i) {
+        TieRecord record = readRecord<TieRecord>(tieData, i, tieRecordSize);
+        if (header.version < 5) {
+            record.reactance = 1.0;
+        }
+        std::string id = readString(record.id);
+        if (record.from >= header.busbarCount || record.to >= header.busbarCount ||
+            record.from == record.to || grid->getTopology().findTie(id) || !(record.reactance > 0.0)) {
+            damaged = true;
+            break;
+        }
+        const auto& busbars = grid->getBusbars();
+        grid->addTie(id, busbars[record.from]->getId(), busbars[record.to]->getId(),
+                     record.limit, record.closed != 0, record.reactance);
+        grid->getTopology().setFlow(id, record.flow);
+    }
+    if (damaged || nextSource != header.sourceCount || nextLoad != header.loadCount ||
+        nextCost != header.costSegmentCount) {
+        lastError = path + ": snapshot is truncated or damaged";
+        return nullptr;
+    }
+
+    if (header.profileIntervals > 0) {
+        auto profiles = std::make_shared<LoadProfiles>(static_cast<std::size_t>(header.profileIntervals));
+        std::vector<double> curve(static_cast<std::size_t>(header.profileIntervals));
+        for (std::size_t type = 0; type < LoadProfiles::LOAD_TYPE_COUNT; ++type) {
+            std::memcpy(curve.data(), profileData + type * curve.size() * sizeof(double),
+                        curve.size() * sizeof(double));
+            profiles->setCurve(static_cast<LoadType>(type), curve);
+        }
+        grid->setLoadProfiles(profiles);
+    }
+
+    // The allocation was restored as saved, so only busbars that were
+    // waiting for dispatch at save time need solving again
+    GridState& state = grid->getState();
+    state.clearDirtyBusbars();
+    for (GridState::Handle busbar : pendingDispatch) {
+        state.markBusbarDirty(busbar);
+    }
+    grid->updateStatistics();
+    return grid;
+}
+
+const std::string& GridSnapshot::getLastError() const {
+    return lastError;
+}
+
+bool GridSnapshot::isSnapshotFile(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    char magic[sizeof(MAGIC)];
+    return file.read(magic, sizeof(magic)) && std::memcmp(magic, MAGIC, sizeof(MAGIC)) == 0;
+}
@@ -0,0 +1,1271 @@
+// GridState.cpp
+#include "../include/GridState.h"
+#include "../include/PowerSource.h"
+#include "../include/Busbar.h"
+#include "../include/Instrumentation.h"
+#include <algorithm>
+#include <numeric>
+
+namespace {
+
+// Views of a fork are bound lazily, so their lists grow on demand
+template <typename T>
+void setView(std::vector<T*>& views, std::size_t slot, T* view) {
+    if (views.size() <= slot) {
+        views.resize(slot + 1, nullptr);
+    }
+    views[slot] = view;
+}
+
+// Headroom below this is rounding left over by earlier tiers rather than
+// power to share out (kW)
+constexpr double CURTAILMENT_TOLERANCE = 1e-6;
+
+// Water level for a tier that does not fit: the cap with
+// sum(min(demand, level)) == capacity, given sum(demand) > capacity. Rather
+// than sorting, the demands are partitioned around a pivot: if the pivot is
+// below the level, everything under it is served in full and drops out,
+// otherwise everything from it up is capped and drops out. Expected linear
+// time; the demands are reordered.
+double waterLevel(std::vector<double>& demands, double capacity) {
+    if (demands.empty()) {
+        return capacity;
+    }
+    if (capacity <= 0.0) {
+        return 0.0;
+    }
+    double whole = 0.0;      // Demands known to be under the level
+    std::size_t capped = 0;  // Demands known to be at or above it
+    auto first = demands.begin();
+    auto last = demands.end();
+    while (first != last) {
+        double pivot = *(first + (last - first) / 2);
+        auto below = std::partition(first, last, [pivot](double d) { return d < pivot; });
+        auto equal = std::partition(below, last, [pivot](double d) { return d == pivot; });
+        double belowSum = std::accumulate(first, below, 0.0);
+        std::size_t atOrAbove = static_cast<std::size_t>(last - below);
+        if (whole + belowSum + static_cast<double>(capped + atOrAbove) * pivot <= capacity) {
+            whole += belowSum + static_cast<double>(equal - below) * pivot;
+            first = equal;
+        } else {
+            capped += atOrAbove;
+            last = below;
+        }
+    }
+    if (capped == 0) {
+        // Rounding put the whole tier under the capacity after all, so
+        // nothing is capped: a level at the largest demand serves them all
+        return *std::max_element(demands.begin(), demands.end());
+    }
+    return (capacity - whole) / static_cast<double>(capped);
+}
+
+} // namespace
+
+GridState::~GridState() {
+    // Views that outlive the grid keep its last values. The columns are left
+    // as they are, since a fork may still share them.
+    for (Handle load = 0; load < loadViews.size(); ++load) {
+        unbindLoadView(load);
+    }
+    for (Handle source = 0; source < sourceViews.size(); ++source) {
+        unbindSourceView(source);
+    }
+}
+
+std::unique_ptr<GridState> GridState::fork() const {
+    auto branch = std::make_unique<GridState>();
+    branch->loadDemand = loadDemand;
+    branch->loadPriority = loadPriority;
+    branch->loadType = loadType;
+    branch->loadConnected = loadConnected;
+    branch->loadServed = loadServed;
+    branch->loadServedKw = loadServedKw;
+    branch->loadCurtailable = loadCurtailable;
+    branch->loadBusbar = loadBusbar;
+    branch->loadIds = loadIds;
+    branch->loadBaseDemand = loadBaseDemand;
+    branch->loadProfileScale = loadProfileScale;
+    branch->sourceCapacity = sourceCapacity;
+    branch->sourceCurrentLoad = sourceCurrentLoad;
+    branch->sourceOperational = sourceOperational;
+    branch->sourceMinOutput = sourceMinOutput;
+    branch->sourceCostCurve = sourceCostCurve;
+    branch->sourceBusbar = sourceBusbar;
+    branch->sourceIds = sourceIds;
+    branch->busbarLoads = busbarLoads;
+    branch->busbarSources = busbarSources;
+    branch->busbarIds = busbarIds;
+    
+    // Forks of one grid usually look entities up by ID, so the index is
+    // built once here rather than once per fork
+    lookup();
+    branch->idLookup = idLookup;
+    
+    // Per-busbar bookkeeping is small enough to copy
+    branch->freeLoads = freeLoads;
+    branch->freeSources = freeSources;
+    branch->freeBusbars = freeBusbars;
+    branch->busbarUsed = busbarUsed;
+    branch->busbarDirty = busbarDirty;
+    branch->dirtyBusbars = dirtyBusbars;
+    branch->busbarServedDemand = busbarServedDemand;
+    branch->busbarDemand = busbarDemand;
+    branch->busbarPriorityDemand = busbarPriorityDemand;
+    branch->busbarCapacity = busbarCapacity;
+    branch->busbarOperationalSources = busbarOperationalSources;
+    branch->totalDemand = totalDemand;
+    branch->servedDemand = servedDemand;
+    branch->totalSupply = totalSupply;
+    branch->allocationStrategy = allocationStrategy;
+    branch->curtailment = curtailment;
+    branch->economicDispatch = economicDispatch;
+    branch->meritOrder = meritOrder;
+    branch->busbarCost = busbarCost;
+    branch->busbarLambda = busbarLambda;
+    branch->totalCost = totalCost;
+    branch->lastTypeFactors = lastTypeFactors;
+    branch->profileInputsChanged = profileInputsChanged;
+    branch->appendedBusbars = appendedBusbars;
+    branch->appendedFrom = appendedFrom;
+    return branch;
+}
+
+Load* GridState::getLoadView(Handle load) const {
+    return load < loadViews.size() ? loadViews[load] : nullptr;
+}
+
+PowerSource* GridState::getSourceView(Handle source) const {
+    return source < sourceViews.size() ? sourceViews[source] : nullptr;
+}
+
+Busbar* GridState::getBusbarView(Handle busbar) const {
+    return busbar < busbarViews.size() ? busbarViews[busbar] : nullptr;
+}
+
+void GridState::bindLoadView(Load* view, Handle load) {
+    setView(loadViews, load, view);
+    view->state = this;
+    view->handle = load;
+}
+
+void GridState::bindSourceView(PowerSource* view, Handle source) {
+    setView(sourceViews, source, view);
+    view->state = this;
+    view->handle = source;
+}
+
+void GridState::bindBusbarView(Busbar* view, Handle busbar) {
+    setView(busbarViews, busbar, view);
+}
+
+const GridState::IdLookup& GridState::lookup() const {
+    if (!idLookup) {
+        auto built = std::make_shared<IdLookup>();
+        built->loadIds = loadIds;
+        built->sourceIds = sourceIds;
+        built->busbarIds = busbarIds;
+        built->loads.reserve(loadIds.size());
+        for (Handle load = 0; load < loadIds.size(); ++load) {
+            if (isLoadSlotUsed(load)) {
+                built->loads.emplace(built->loadIds[load], load);
+            }
+        }
+        for (Handle source = 0; source < sourceIds.size(); ++source) {
+            if (isSourceSlotUsed(source)) {
+                built->sources.emplace(built->sourceIds[source], source);
+            }
+        }
+        for (Handle busbar = 0; busbar < busbarIds.size(); ++busbar) {
+            if (isBusbarSlotUsed(busbar)) {
+                built->busbars.emplace(built->busbarIds[busbar], busbar);
+            }
+        }
+        idLookup = std::move(built);
+    }
+    return *idLookup;
+}
+
+GridState::Handle GridState::findLoad(std::string_view id) const {
+    const auto& loads = lookup().loads;
+    auto found = loads.find(id);
+    return found == loads.end() ? INVALID_HANDLE : found->second;
+}
+
+GridState::Handle GridState::findSource(std::string_view id) const {
+    const auto& sources = lookup().sources;
+    auto found = sources.find(id);
+    return found == sources.end() ? INVALID_HANDLE : found->second;
+}
+
+GridState::Handle GridState::findBusbar(std::string_view id) const {
+    const auto& busbars = lookup().busbars;
+    auto found = busbars.find(id);
+    return found == busbars.end() ? INVALID_HANDLE : found->second;
+}
+
+GridState::Handle GridState::addBusbar(Busbar* view) {
+    idLookup.reset();
+    Handle busbar;
+    if (!freeBusbars.empty()) {
+        busbar = freeBusbars.back();
+        freeBusbars.pop_back();
+        busbarUsed[busbar] = 1;
+        busbarDirty[busbar] = 0;
+        busbarServedDemand[busbar] = 0.0;
+        busbarDemand[busbar] = 0.0;
+        std::fill_n(busbarPriorityDemand.begin() + busbar * PRIORITY_COUNT, PRIORITY_COUNT, 0.0);
+        busbarCapacity[busbar] = 0.0;
+        busbarOperationalSources[busbar] = 0;
+        busbarCost[busbar] = 0.0;
+        busbarLambda[busbar] = 0.0;
+    } else {
+        busbar = busbarLoads.size();
+        busbarLoads.emplace_back();
+        busbarSources.emplace_back();
+        busbarIds.emplace_back();
+        busbarUsed.push_back(1);
+        busbarDirty.push_back(0);
+        busbarServedDemand.push_back(0.0);
+        busbarDemand.push_back(0.0);
+        busbarPriorityDemand.resize(busbarPriorityDemand.size() + PRIORITY_COUNT, 0.0);
+        busbarCapacity.push_back(0.0);
+        busbarOperationalSources.push_back(0);
+        busbarCost.push_back(0.0);
+        busbarLambda.push_back(0.0);
+    }
+    busbarIds.edit(busbar) = view->getId();
+    setView(busbarViews, busbar, view);
+    markBusbarDirty(busbar);
+    return busbar;
+}
+
+void GridState::removeBusbar(Handle busbar) {
+    // Everything on the busbar goes, so the member lists are dropped whole
+    // rather than edited one entity at a time
+    idLookup.reset();
+    for (Handle load : busbarLoads[busbar]) {
+        releaseLoad(load);
+    }
+    busbarLoads.edit(busbar).clear();
+    for (Handle source : busbarSources[busbar]) {
+        releaseSource(source);
+    }
+    busbarSources.edit(busbar).clear();
+    busbarIds.edit(busbar).clear();
+    busbarUsed[busbar] = 0;
+    // A slot left marked would never be marked again once reused
+    if (busbarDirty[busbar]) {
+        busbarDirty[busbar] = 0;
+        dirtyBusbars.erase(std::remove(dirtyBusbars.begin(), dirtyBusbars.end(), busbar), dirtyBusbars.end());
+    }
+    totalCost -= busbarCost[busbar];
+    busbarCost[busbar] = 0.0;
+    if (busbar < busbarViews.size()) {
+        busbarViews[busbar] = nullptr;
+    }
+    freeBusbars.push_back(busbar);
+}
+
+GridState::Handle GridState::addLoad(Load* view, Handle busbar) {
+    Handle load = allocateLoad(view, busbar);
+    
+    // Insert after every load of the same or higher priority
+    auto& members = busbarLoads.edit(busbar);
+    std::uint8_t priority = loadPriority[load];
+    members.insert(std::upper_bound(members.begin(), members.end(), priority,
+                                    [this](std::uint8_t p, Handle other) {
+                                        return p < loadPriority[other];
+                                    }),
+                   load);
+    return load;
+}
+
+GridState::Handle GridState::appendLoad(Load* view, Handle busbar) {
+    Handle load = allocateLoad(view, busbar);
+    
+    // Remember where the busbar's sorted members end, the first time
+    if (appendedFrom.size() < busbarLoads.size()) {
+        appendedFrom.resize(busbarLoads.size(), INVALID_HANDLE);
+    }
+    if (appendedFrom[busbar] == INVALID_HANDLE) {
+        appendedFrom[busbar] = busbarLoads[busbar].size();
+        appendedBusbars.push_back(busbar);
+    }
+    busbarLoads.edit(busbar).push_back(load);
+    return load;
+}
+
+void GridState::commitAppendedLoads() {
+    auto byPriority = [this](Handle a, Handle b) {
+        return loadPriority[a] < loadPriority[b];
+    };
+    // Sorting the appended run and merging it behind the existing members
+    // gives the same order as inserting the loads one at a time
+    instrumentation::PhaseTimer timer(instrumentation::Phase::SORT);
+    for (Handle busbar : appendedBusbars) {
+        auto& members = busbarLoads.edit(busbar);
+        auto appended = members.begin() + appendedFrom[busbar];
+        std::stable_sort(appended, members.end(), byPriority);
+        std::inplace_merge(members.begin(), appended, members.end(), byPriority);
+        appendedFrom[busbar] = INVALID_HANDLE;
+    }
+    appendedBusbars.clear();
+}
+
+GridState::Handle GridState::allocateLoad(Load* view, Handle busbar) {
+    idLookup.reset();
+    Handle load;
+    if (!freeLoads.empty()) {
+        load = freeLoads.back();
+        freeLoads.pop_back();
+    } else {
+        load = loadDemand.size();
+        loadDemand.push_back(0.0);
+        loadPriority.push_back(0);
+        loadType.push_back(0);
+        loadConnected.push_back(0);
+        loadServed.push_back(0);
+        loadServedKw.push_back(0.0);
+        loadCurtailable.push_back(0);
+        loadBusbar.push_back(INVALID_HANDLE);
+        loadIds.emplace_back();
+        loadBaseDemand.push_back(0.0);
+        loadProfileScale.push_back(1.0);
+    }
+
+    // Move the view's detached values into the arrays
+    loadDemand.edit()[load] = view->powerDemand;
+    loadPriority.edit()[load] = static_cast<std::uint8_t>(view->priority);
+    loadType.edit()[load] = static_cast<std::uint8_t>(view->type);
+    loadConnected.edit()[load] = view->isConnected ? 1 : 0;
+    bool curtailed = view->isServed && view->curtailable && view->servedPower < view->powerDemand;
+    loadServed.edit()[load] = curtailed ? CURTAILED : (view->isServed ? 1 : 0);
+    loadServedKw.edit()[load] = curtailed ? view->servedPower : 0.0;
+    loadCurtailable.edit()[load] = view->curtailable ? 1 : 0;
+    loadBusbar.edit()[load] = busbar;
+    loadIds.edit(load) = view->id;
+    loadBaseDemand.edit()[load] = view->baseDemand;
+    loadProfileScale.edit()[load] = view->profileScale;
+    profileInputsChanged = true;
+    endLoadEdit(load);
+
+    bindLoadView(view, load);
+    return load;
+}
+
+void GridState::removeLoad(Handle load) {
+    // Members are priority ordered, so the search starts at the load's tier
+    auto& members = busbarLoads.edit(loadBusbar[load]);
+    auto tier = std::lower_bound(members.begin(), members.end(), loadPriority[load],
+                                 [this](Handle other, std::uint8_t p) {
+                                     return loadPriority[other] < p;
+                                 });
+    members.erase(std::find(tier, members.end(), load));
+    releaseLoad(load);
+}
+
+void GridState::releaseLoad(Handle load) {
+    idLookup.reset();
+    unbindLoadView(load);
+
+    beginLoadEdit(load);
+    markBusbarDirty(loadBusbar[load]);
+
+    loadConnected.edit()[load] = 0;
+    loadServed.edit()[load] = 0;
+    loadCurtailable.edit()[load] = 0;
+    loadBusbar.edit()[load] = INVALID_HANDLE;
+    loadIds.edit(load).clear();
+    loadBaseDemand.edit()[load] = 0.0;
+    freeLoads.push_back(load);
+}
+
+void GridState::unbindLoadView(Handle load) {
+    Load* view = getLoadView(load);
+    if (view) {
+        // Copy the live values back so the view stays meaningful on its own
+        view->powerDemand = loadDemand[load];
+        view->isConnected = loadConnected[load] != 0;
+        view->isServed = loadServed[load] != 0;
+        view->servedPower = loadServedPower(load);
+        view->curtailable = loadCurtailable[load] != 0;
+        view->baseDemand = loadBaseDemand[load];
+        view->profileScale = loadProfileScale[load];
+        view->state = nullptr;
+        view->handle = INVALID_HANDLE;
+        loadViews[load] = nullptr;
+    }
+}
+
+GridState::Handle GridState::addSource(PowerSource* view, Handle busbar) {
+    idLookup.reset();
+    Handle source;
+    if (!freeSources.empty()) {
+        source = freeSources.back();
+        freeSources.pop_back();
+    } else {
+        source = sourceCapacity.size();
+        sourceCapacity.push_back(0.0);
+        sourceCurrentLoad.push_back(0.0);
+        sourceOperational.push_back(0);
+        sourceMinOutput.push_back(0.0);
+        sourceCostCurve.push_back({});
+        sourceBusbar.push_back(INVALID_HANDLE);
+        sourceIds.emplace_back();
+    }
+
+    sourceCapacity.edit()[source] = view->capacity;
+    sourceCurrentLoad.edit()[source] = view->currentLoad;
+    sourceOperational.edit()[source] = view->operational ? 1 : 0;
+    sourceMinOutput.edit()[source] = view->minOutput;
+    sourceCostCurve.edit()[source] = view->costCurve;
+    sourceBusbar.edit()[source] = busbar;
+    sourceIds.edit(source) = view->id;
+    busbarSources.edit(busbar).push_back(source);
+    endSourceEdit(source);
+
+    bindSourceView(view, source);
+    return source;
+}
+
+void GridState::removeSource(Handle source) {
+    auto& members = busbarSources.edit(sourceBusbar[source]);
+    members.erase(std::find(members.begin(), members.end(), source));
+    releaseSource(source);
+}
+
+void GridState::releaseSource(Handle source) {
+    idLookup.reset();
+    unbindSourceView(source);
+
+    beginSourceEdit(source);
+    markBusbarDirty(sourceBusbar[source]);
+    if (economicDispatch) {
+        meritOrder.removeSource(sourceBusbar[source], source);
+    }
+
+    sourceCapacity.edit()[source] = 0.0;
+    sourceCurrentLoad.edit()[source] = 0.0;
+    sourceOperational.edit()[source] = 0;
+    sourceMinOutput.edit()[source] = 0.0;
+    sourceCostCurve.edit()[source].clear();
+    sourceBusbar.edit()[source] = INVALID_HANDLE;
+    sourceIds.edit(source).clear();
+    freeSources.push_back(source);
+}
+
+void GridState::unbindSourceView(Handle source) {
+    PowerSource* view = getSourceView(source);
+    if (view) {
+        view->capacity = sourceCapacity[source];
+        view->currentLoad = sourceCurrentLoad[source];
+        view->operational = sourceOperational[source] != 0;
+        view->minOutput = sourceMinOutput[source];
+        view->costCurve = sourceCostCurve[source];
+        view->state = nullptr;
+        view->handle = INVALID_HANDLE;
+        sourceViews[source] = nullptr;
+    }
+}
+
+void GridState::reserve(std::size_t busbarCount, std::size_t sourceCount, std::size_t loadCount) {
+    busbarLoads.reserve(busbarCount);
+    busbarSources.reserve(busbarCount);
+    busbarIds.reserve(busbarCount);
+    busbarViews.reserve(busbarCount);
+    busbarUsed.reserve(busbarCount);
+    busbarDirty.reserve(busbarCount);
+    busbarServedDemand.reserve(busbarCount);
+    busbarDemand.reserve(busbarCount);
+    busbarPriorityDemand.reserve(busbarCount * PRIORITY_COUNT);
+    busbarCapacity.reserve(busbarCount);
+    busbarOperationalSources.reserve(busbarCount);
+    busbarCost.reserve(busbarCount);
+    busbarLambda.reserve(busbarCount);
+    dirtyBusbars.reserve(busbarCount);
+
+    sourceCapacity.edit().reserve(sourceCount);
+    sourceCurrentLoad.edit().reserve(sourceCount);
+    sourceOperational.edit().reserve(sourceCount);
+    sourceMinOutput.edit().reserve(sourceCount);
+    sourceCostCurve.edit().reserve(sourceCount);
+    sourceBusbar.edit().reserve(sourceCount);
+    sourceIds.reserve(sourceCount);
+    sourceViews.reserve(sourceCount);
+
+    loadDemand.edit().reserve(loadCount);
+    loadPriority.edit().reserve(loadCount);
+    loadType.edit().reserve(loadCount);
+    loadConnected.edit().reserve(loadCount);
+    loadServed.edit().reserve(loadCount);
+    loadServedKw.edit().reserve(loadCount);
+    loadCurtailable.edit().reserve(loadCount);
+    loadBusbar.edit().reserve(loadCount);
+    loadIds.reserve(loadCount);
+    loadViews.reserve(loadCount);
+    loadBaseDemand.edit().reserve(loadCount);
+    loadProfileScale.edit().reserve(loadCount);
+}
+
+std::size_t GridState::loadSlotCount() const {
+    return loadDemand.size();
+}
+
+std::size_t GridState::sourceSlotCount() const {
+    return sourceCapacity.size();
+}
+
+std::size_t GridState::busbarSlotCount() const {
+    return busbarLoads.size();
+}
+
+bool GridState::isLoadSlotUsed(Handle load) const {
+    return loadBusbar[load] != INVALID_HANDLE;
+}
+
+bool GridState::isSourceSlotUsed(Handle source) const {
+    return sourceBusbar[source] != INVALID_HANDLE;
+}
+
+bool GridState::isBusbarSlotUsed(Handle busbar) const {
+    return busbarUsed[busbar] != 0;
+}
+
+double GridState::demandContribution(Handle load) const {
+    return loadConnected[load] ? loadDemand[load] : 0.0;
+}
+
+double GridState::servedContribution(Handle load) const {
+    return loadServedPower(load);
+}
+
+double GridState::supplyContribution(Handle source) const {
+    return sourceOperational[source] ? sourceCapacity[source] : 0.0;
+}
+
+void GridState::beginLoadEdit(Handle load) {
+    Handle busbar = loadBusbar[load];
+    double demand = demandContribution(load);
+    double served = servedContribution(load);
+    totalDemand -= demand;
+    servedDemand -= served;
+    busbarServedDemand[busbar] -= served;
+    busbarDemand[busbar] -= demand;
+    busbarPriorityDemand[busbar * PRIORITY_COUNT + loadPriority[load] - 1] -= demand;
+}
+
+void GridState::endLoadEdit(Handle load) {
+    Handle busbar = loadBusbar[load];
+    double demand = demandContribution(load);
+    double served = servedContribution(load);
+    totalDemand += demand;
+    servedDemand += served;
+    busbarServedDemand[busbar] += served;
+    busbarDemand[busbar] += demand;
+    busbarPriorityDemand[busbar * PRIORITY_COUNT + loadPriority[load] - 1] += demand;
+    markBusbarDirty(busbar);
+}
+
+void GridState::beginSourceEdit(Handle source) {
+    Handle busbar = sourceBusbar[source];
+    double supply = supplyContribution(source);
+    totalSupply -= supply;
+    busbarCapacity[busbar] -= supply;
+    busbarOperationalSources[busbar] -= sourceOperational[source];
+}
+
+void GridState::endSourceEdit(Handle source) {
+    Handle busbar = sourceBusbar[source];
+    double supply = supplyContribution(source);
+    totalSupply += supply;
+    busbarCapacity[busbar] += supply;
+    busbarOperationalSources[busbar] += sourceOperational[source];
+    markBusbarDirty(busbar);
+    if (economicDispatch) {
+        meritOrder.updateSource(*this, source);
+    }
+}
+
+void GridState::recomputeBusbarDemand() {
+    std::fill(busbarDemand.begin(), busbarDemand.end(), 0.0);
+    std::fill(busbarPriorityDemand.begin(), busbarPriorityDemand.end(), 0.0);
+    for (Handle busbar = 0; busbar < busbarLoads.size(); ++busbar) {
+        double tiers[PRIORITY_COUNT] = {};
+        double connected = 0.0;
+        for (Handle load : busbarLoads[busbar]) {
+            if (loadConnected[load]) {
+                connected += loadDemand[load];
+                tiers[loadPriority[load] - 1] += loadDemand[load];
+            }
+        }
+        storeBusbarDemand(busbar, connected, tiers);
+    }
+}
+
+void GridState::storeBusbarDemand(Handle busbar, double connected, const double* tiers) {
+    busbarDemand[busbar] = connected;
+    std::copy(tiers, tiers + PRIORITY_COUNT, busbarPriorityDemand.begin() + busbar * PRIORITY_COUNT);
+}
+
+void GridState::setLoadDemand(Handle load, double demand) {
+    // The new demand is the base the profiles scale, so the next change of
+    // profile factors keeps it
+    loadBaseDemand.edit()[load] = demand;
+    if (!lastTypeFactors.empty()) {
+        demand *= loadProfileScale[load] * lastTypeFactors[loadType[load]];
+    }
+    beginLoadEdit(load);
+    loadDemand.edit()[load] = demand;
+    endLoadEdit(load);
+}
+
+void GridState::setLoadConnected(Handle load, bool connected) {
+    beginLoadEdit(load);
+    loadConnected.edit()[load] = connected ? 1 : 0;
+    if (!connected) {
+        loadServed.edit()[load] = 0;
+    }
+    endLoadEdit(load);
+}
+
+void GridState::setLoadServed(Handle load, bool served) {
+    beginLoadEdit(load);
+    loadServed.edit()[load] = served ? 1 : 0;
+    endLoadEdit(load);
+}
+
+void GridState::setLoadCurtailable(Handle load, bool curtailable) {
+    loadCurtailable.edit()[load] = curtailable ? 1 : 0;
+    markBusbarDirty(loadBusbar[load]);
+}
+
+void GridState::setLoadProfileInputs(Handle load, double baseDemand, double scale) {
+    loadBaseDemand.edit()[load] = baseDemand;
+    loadProfileScale.edit()[load] = scale;
+    profileInputsChanged = true;
+}
+
+bool GridState::applyDemandFactors(const double* typeFactors, std::size_t typeCount) {
+    if (!profileInputsChanged && 
+        lastTypeFactors.size() == typeCount &&
+        std::equal(lastTypeFactors.begin(), lastTypeFactors.end(), typeFactors)) {
+        return false;
+    }
+    lastTypeFactors.assign(typeFactors, typeFactors + typeCount);
+    profileInputsChanged = false;
+    
+    const std::size_t count = loadDemand.size();
+    double* demand = loadDemand.edit().data();
+    const double* base = loadBaseDemand.data();
+    const double* scale = loadProfileScale.data();
+    const std::uint8_t* type = loadType.data();
+    const std::uint8_t* connected = loadConnected.data();
+    
+    for (std::size_t i = 0; i < count; ++i) {
+        demand[i] = base[i] * scale[i] * typeFactors[type[i]];
+    }
+    
+    double total = 0.0;
+    for (std::size_t i = 0; i < count; ++i) {
+        total += connected[i] ? demand[i] : 0.0;
+    }
+    totalDemand = total;
+    recomputeBusbarDemand();
+    
+    // Served totals are brought back in line by re-dispatching every busbar
+    markAllBusbarsDirty();
+    return true;
+}
+
+void GridState::setSourceCapacity(Handle source, double capacity) {
+    beginSourceEdit(source);
+    sourceCapacity.edit()[source] = capacity;
+    endSourceEdit(source);
+}
+
+void GridState::setSourceOperational(Handle source, bool operational) {
+    beginSourceEdit(source);
+    sourceOperational.edit()[source] = operational ? 1 : 0;
+    endSourceEdit(source);
+}
+
+void GridState::setSourceCurrentLoad(Handle source, double currentLoad) {
+    // Loading is owned by dispatch, so a manual edit forces a re-solve
+    sourceCurrentLoad.edit()[source] = currentLoad;
+    markBusbarDirty(sourceBusbar[source]);
+}
+
+void GridState::setSourceMinOutput(Handle source, double minOutput) {
+    beginSourceEdit(source);
+    sourceMinOutput.edit()[source] = minOutput;
+    endSourceEdit(source);
+}
+
+void GridState::setSourceCostCurve(Handle source, const std::vector<CostSegment>& curve) {
+    beginSourceEdit(source);
+    sourceCostCurve.edit()[source] = curve;
+    endSourceEdit(source);
+}
+
+void GridState::markBusbarDirty(Handle busbar) {
+    if (!busbarDirty[busbar]) {
+        busbarDirty[busbar] = 1;
+        dirtyBusbars.push_back(busbar);
+    }
+}
+
+bool GridState::isBusbarDirty(Handle busbar) const {
+    return busbarDirty[busbar] != 0;
+}
+
+void GridState::markAllBusbarsDirty() {
+    for (Handle busbar = 0; busbar < busbarLoads.size(); ++busbar) {
+        if (busbarUsed[busbar]) {
+            markBusbarDirty(busbar);
+        }
+    }
+}
+
+const std::vector<GridState::Handle>& GridState::getDirtyBusbars() {
+    // Drop busbars removed since they were marked, and dispatch in
+    // handle order so that output is deterministic
+    dirtyBusbars.erase(std::remove_if(dirtyBusbars.begin(), dirtyBusbars.end(),
+                                      [this](Handle busbar) {
+                                          if (busbarUsed[busbar]) return false;
+                                          busbarDirty[busbar] = 0;
+                                          return true;
+                                      }),
+                       dirtyBusbars.end());
+    std::sort(dirtyBusbars.begin(), dirtyBusbars.end());
+    return dirtyBusbars;
+}
+
+void GridState::clearDirtyBusbars() {
+    for (Handle busbar : dirtyBusbars) {
+        busbarDirty[busbar] = 0;
+    }
+    dirtyBusbars.clear();
+}
+
+double GridState::getTotalDemand() const {
+    return totalDemand;
+}
+
+double GridState::getServedDemand() const {
+    return servedDemand;
+}
+
+double GridState::getTotalSupply() const {
+    return totalSupply;
+}
+
+void GridState::recomputeTotals() {
+    totalDemand = 0.0;
+    servedDemand = 0.0;
+    totalSupply = 0.0;
+    std::fill(busbarServedDemand.begin(), busbarServedDemand.end(), 0.0);
+    std::fill(busbarCapacity.begin(), busbarCapacity.end(), 0.0);
+    std::fill(busbarOperationalSources.begin(), busbarOperationalSources.end(), 0);
+    
+    for (Handle load = 0; load < loadDemand.size(); ++load) {
+        if (!isLoadSlotUsed(load)) continue;
+        double served = servedContribution(load);
+        totalDemand += demandContribution(load);
+        servedDemand += served;
+        busbarServedDemand[loadBusbar[load]] += served;
+    }
+    for (Handle source = 0; source < sourceCapacity.size(); ++source) {
+        if (!isSourceSlotUsed(source)) continue;
+        totalSupply += supplyContribution(source);
+        busbarCapacity[sourceBusbar[source]] += supplyContribution(source);
+        busbarOperationalSources[sourceBusbar[source]] += sourceOperational[source];
+    }
+    recomputeBusbarDemand();
+}
+
+double GridState::loadServedPower(Handle load) const {
+    if (!loadConnected[load]) {
+        return 0.0;
+    }
+    switch (loadServed[load]) {
+        case 0: return 0.0;
+        // A demand change is only re-solved at the next dispatch
+        case CURTAILED: return std::min(loadServedKw[load], loadDemand[load]);
+        default: return loadDemand[load];
+    }
+}
+
+void GridState::resetAll() {
+    std::vector<double>& sourceLoading = sourceCurrentLoad.edit();
+    std::vector<std::uint8_t>& servedFlags = loadServed.edit();
+    std::fill(sourceLoading.begin(), sourceLoading.end(), 0.0);
+    std::fill(servedFlags.begin(), servedFlags.end(), 0);
+    std::fill(busbarServedDemand.begin(), busbarServedDemand.end(), 0.0);
+    servedDemand = 0.0;
+    markAllBusbarsDirty();
+}
+
+void GridState::claimDispatchColumns() {
+    loadServed.edit();
+    loadServedKw.edit();
+    sourceCurrentLoad.edit();
+}
+
+bool GridState::firstFit(Handle load, Handle busbar, std::uint8_t* servedFlags, double* sourceLoading,
+                         std::uint64_t& probes) {
+    double demandPower = loadDemand[load];
+    const std::uint8_t* operational = sourceOperational.data();
+    const double* capacity = sourceCapacity.data();
+    for (Handle source : busbarSources[busbar]) {
+        if constexpr (instrumentation::ENABLED) {
+            ++probes;
+        }
+        if (operational[source] && sourceLoading[source] + demandPower <= capacity[source]) {
+            sourceLoading[source] += demandPower;
+            servedFlags[load] = 1;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool GridState::dispatchBusbar(Handle busbar, std::vector<Handle>& shed) {
+    std::size_t shedBefore = shed.size();
+    commitBusbarServed(busbar, solveBusbar(busbar, shed));
+    return shed.size() == shedBefore;
+}
+
+void GridState::resetBusbarSources(Handle busbar) {
+    double capacity = 0.0;
+    std::size_t operational = 0;
+    double* sourceLoading = sourceCurrentLoad.edit().data();
+    for (Handle source : busbarSources[busbar]) {
+        sourceLoading[source] = 0.0;
+        capacity += supplyContribution(source);
+        operational += sourceOperational[source];
+    }
+    busbarCapacity[busbar] = capacity;
+    busbarOperationalSources[busbar] = operational;
+}
+
+GridState::Handle GridState::coveringSource(Handle busbar) const {
+    // First-fit puts every load on the first operational source while it has
+    // room for the whole demand. Other strategies may spread loads over
+    // several sources, so for them only a sole operational source qualifies.
+    std::size_t operational = busbarOperationalSources[busbar];
+    if (operational == 0 || (allocationStrategy && operational != 1)) {
+        return INVALID_HANDLE;
+    }
+    for (Handle source : busbarSources[busbar]) {
+        if (sourceOperational[source]) {
+            return busbarDemand[busbar] <= sourceCapacity[source] ? source : INVALID_HANDLE;
+        }
+    }
+    return INVALID_HANDLE;
+}
+
+bool GridState::serveAllFrom(Handle busbar, Handle source, double& served) {
+    // The aggregate may be a rounding error off, so the fit is confirmed
+    // load by load, in the same order and arithmetic as first-fit
+    double capacity = sourceCapacity[source];
+    double tiers[PRIORITY_COUNT] = {};
+    double loading = 0.0;
+    std::uint8_t* servedFlags = loadServed.edit().data();
+    const std::uint8_t* connected = loadConnected.data();
+    const double* demand = loadDemand.data();
+    const std::uint8_t* priority = loadPriority.data();
+    for (Handle load : busbarLoads[busbar]) {
+        servedFlags[load] = connected[load];
+        if (!connected[load]) continue;
+        double demandPower = demand[load];
+        if (loading + demandPower > capacity) {
+            return false;
+        }
+        loading += demandPower;
+        tiers[priority[load] - 1] += demandPower;
+    }
+    sourceCurrentLoad.edit()[source] = loading;
+    storeBusbarDemand(busbar, loading, tiers);
+    served = loading;
+    return true;
+}
+
+double GridState::solveBusbar(Handle busbar, std::vector<Handle>& shed) {
+    instrumentation::PhaseTimer timer(instrumentation::Phase::RESET);
+    resetBusbarSources(busbar);
+    
+    // Comfortably supplied busbars skip the allocation pass
+    timer.next(instrumentation::Phase::ALLOCATE);
+    Handle covering = coveringSource(busbar);
+    double served = 0.0;
+    if (covering != INVALID_HANDLE && serveAllFrom(busbar, covering, served)) {
+        instrumentation::count(instrumentation::Counter::COVERED_BUSBARS);
+        instrumentation::count(instrumentation::Counter::BUSBARS_SOLVED);
+        return served;
+    }
+    
+    if (curtailment) {
+        return solveBusbarCurtailed(busbar, shed);
+    }
+    if (allocationStrategy) {
+        return solveBusbarWithStrategy(busbar, shed);
+    }
+
+    // Loads are already in priority order, so serving and shedding are
+    // decided in the same traversal
+    std::size_t shedBefore = shed.size();
+    std::uint64_t probes = 0;
+    std::uint64_t allocations = 0;
+    double tiers[PRIORITY_COUNT] = {};
+    double connected = 0.0;
+    std::uint8_t* servedFlags = loadServed.edit().data();
+    double* sourceLoading = sourceCurrentLoad.edit().data();
+    const std::uint8_t* isConnected = loadConnected.data();
+    const double* demand = loadDemand.data();
+    const std::uint8_t* priority = loadPriority.data();
+    for (Handle load : busbarLoads[busbar]) {
+        servedFlags[load] = 0;
+        if (!isConnected[load]) continue;
+        connected += demand[load];
+        tiers[priority[load] - 1] += demand[load];
+        if (firstFit(load, busbar, servedFlags, sourceLoading, probes)) {
+            served += demand[load];
+            ++allocations;
+        } else {
+            shed.push_back(load);
+        }
+    }
+    storeBusbarDemand(busbar, connected, tiers);
+    instrumentation::count(instrumentation::Counter::SOURCE_PROBES, probes);
+    instrumentation::count(instrumentation::Counter::ALLOCATIONS, allocations);
+    instrumentation::count(instrumentation::Counter::LOADS_SHED, shed.size() - shedBefore);
+    instrumentation::count(instrumentation::Counter::BUSBARS_SOLVED);
+    return served;
+}
+
+bool GridState::serveFromBusbar(Handle load, Handle busbar) {
+    std::uint64_t probes = 0;
+    bool served = firstFit(load, busbar, loadServed.edit().data(), sourceCurrentLoad.edit().data(), probes);
+    instrumentation::count(instrumentation::Counter::SOURCE_PROBES, probes);
+    if (served) {
+        busbarServedDemand[loadBusbar[load]] += loadDemand[load];
+        servedDemand += loadDemand[load];
+    }
+    return served;
+}
+
+void GridState::setAllocationStrategy(const AllocationStrategy* strategy) {
+    allocationStrategy = strategy;
+    markAllBusbarsDirty();
+}
+
+void GridState::setCurtailment(bool enabled) {
+    if (curtailment == enabled) {
+        return;
+    }
+    curtailment = enabled;
+    markAllBusbarsDirty();
+}
+
+bool GridState::isCurtailmentEnabled() const {
+    return curtailment;
+}
+
+void GridState::setEconomicDispatch(bool enabled) {
+    if (economicDispatch == enabled) {
+        return;
+    }
+    economicDispatch = enabled;
+    if (enabled) {
+        meritOrder.rebuild(*this);
+    } else {
+        meritOrder.clear();
+    }
+    markAllBusbarsDirty();
+}
+
+bool GridState::isEconomicDispatchEnabled() const {
+    return economicDispatch;
+}
+
+bool GridState::redispatchEconomically(Handle busbar) {
+    double* outputs = sourceCurrentLoad.edit().data();
+    double demand = 0.0;
+    for (Handle source : busbarSources[busbar]) {
+        demand += outputs[source];
+    }
+    MeritOrder::Dispatch result;
+    bool met = meritOrder.dispatch(*this, busbar, demand, outputs, result);
+    if (!met) {
+        result.costPerHour = 0.0;
+        result.lambda = 0.0;
+        for (Handle source : busbarSources[busbar]) {
+            result.costPerHour += operatingCost(sourceCostCurve[source], outputs[source]);
+            result.lambda = std::max(result.lambda, incrementalCost(sourceCostCurve[source], outputs[source]));
+        }
+    }
+    totalCost += result.costPerHour - busbarCost[busbar];
+    busbarCost[busbar] = result.costPerHour;
+    busbarLambda[busbar] = result.lambda;
+    return met;
+}
+
+double GridState::getOperatingCost() const {
+    if (economicDispatch) {
+        return totalCost;
+    }
+    double cost = 0.0;
+    for (Handle source = 0; source < sourceCapacity.size(); ++source) {
+        if (isSourceSlotUsed(source)) {
+            cost += operatingCost(sourceCostCurve[source], sourceCurrentLoad[source]);
+        }
+    }
+    return cost;
+}
+
+double GridState::busbarIncrementalCost(Handle busbar) const {
+    return busbarLambda[busbar];
+}
+
+void GridState::buildAllocationProblem(Handle busbar, AllocationProblem& problem,
+                                       std::vector<Handle>& loads, 
+                                       std::vector<Handle>& sources) const {
+    problem.demands.clear();
+    problem.priorities.clear();
+    problem.capacities.clear();
+    loads.clear();
+    sources.clear();
+    
+    for (Handle load : busbarLoads[busbar]) {
+        if (!loadConnected[load]) continue;
+        loads.push_back(load);
+        problem.demands.push_back(loadDemand[load]);
+        problem.priorities.push_back(loadPriority[load]);
+    }
+    for (Handle source : busbarSources[busbar]) {
+        if (!sourceOperational[source]) continue;
+        sources.push_back(source);
+        problem.capacities.push_back(sourceCapacity[source]);
+    }
+}
+
+double GridState::solveBusbarWithStrategy(Handle busbar, std::vector<Handle>& shed) {
+    // Per-thread scratch so busbars can be solved concurrently
+    thread_local AllocationProblem problem;
+    thread_local std::vector<Handle> loads;
+    thread_local std::vector<Handle> sources;
+    thread_local std::vector<std::size_t> assignment;
+    
+    double tiers[PRIORITY_COUNT] = {};
+    double connected = 0.0;
+    std::uint8_t* servedFlags = loadServed.edit().data();
+    for (Handle load : busbarLoads[busbar]) {
+        servedFlags[load] = 0;
+        if (loadConnected[load]) {
+            connected += loadDemand[load];
+            tiers[loadPriority[load] - 1] += loadDemand[load];
+        }
+    }
+    storeBusbarDemand(busbar, connected, tiers);
+    
+    buildAllocationProblem(busbar, problem, loads, sources);
+    allocationStrategy->allocate(problem, assignment);
+    
+    std::size_t shedBefore = shed.size();
+    double served = 0.0;
+    double* sourceLoading = sourceCurrentLoad.edit().data();
+    for (std::size_t i = 0; i < loads.size(); ++i) {
+        if (assignment[i] == AllocationStrategy::UNSERVED) {
+            shed.push_back(loads[i]);
+        } else {
+            sourceLoading[sources[assignment[i]]] += problem.demands[i];
+            servedFlags[loads[i]] = 1;
+            served += problem.demands[i];
+        }
+    }
+    instrumentation::count(instrumentation::Counter::ALLOCATIONS, loads.size() - (shed.size() - shedBefore));
+    instrumentation::count(instrumentation::Counter::LOADS_SHED, shed.size() - shedBefore);
+    instrumentation::count(instrumentation::Counter::BUSBARS_SOLVED);
+    return served;
+}
+
+double GridState::solveBusbarCurtailed(Handle busbar, std::vector<Handle>& shed) {
+    thread_local std::vector<Handle> curtailable;  // Per-thread, like the strategy scratch
+    
+    std::size_t shedBefore = shed.size();
+    std::uint64_t probes = 0;
+    std::uint64_t allocations = 0;
+    double tiers[PRIORITY_COUNT] = {};
+    double connected = 0.0;
+    double served = 0.0;
+    std::uint8_t* servedFlags = loadServed.edit().data();
+    double* sourceLoading = sourceCurrentLoad.edit().data();
+    const std::uint8_t* isConnected = loadConnected.data();
+    const std::uint8_t* isCurtailable = loadCurtailable.data();
+    const double* demand = loadDemand.data();
+    const std::uint8_t* priority = loadPriority.data();
+    const auto& loads = busbarLoads[busbar];
+    for (std::size_t begin = 0; begin < loads.size();) {
+        // Whole loads of the tier first, then the curtailable ones share
+        // what is left
+        std::uint8_t tier = priority[loads[begin]];
+        double wanted = 0.0;
+        curtailable.clear();
+        std::size_t end = begin;
+        for (; end < loads.size() && priority[loads[end]] == tier; ++end) {
+            Handle load = loads[end];
+            servedFlags[load] = 0;
+            if (!isConnected[load]) continue;
+            connected += demand[load];
+            tiers[tier - 1] += demand[load];
+            if (isCurtailable[load]) {
+                curtailable.push_back(load);
+                wanted += demand[load];
+            } else if (firstFit(load, busbar, servedFlags, sourceLoading, probes)) {
+                served += demand[load];
+                ++allocations;
+            } else {
+                shed.push_back(load);
+            }
+        }
+        if (!curtailable.empty()) {
+            std::size_t tierShed = shed.size();
+            served += curtailTier(busbar, curtailable, wanted, servedFlags, sourceLoading, shed);
+            allocations += curtailable.size() - (shed.size() - tierShed);
+        }
+        begin = end;
+    }
+    storeBusbarDemand(busbar, connected, tiers);
+    instrumentation::count(instrumentation::Counter::SOURCE_PROBES, probes);
+    instrumentation::count(instrumentation::Counter::ALLOCATIONS, allocations);
+    instrumentation::count(instrumentation::Counter::LOADS_SHED, shed.size() - shedBefore);
+    instrumentation::count(instrumentation::Counter::BUSBARS_SOLVED);
+    return served;
+}
+
+double GridState::curtailTier(Handle busbar, const std::vector<Handle>& loads, double wanted,
+                              std::uint8_t* servedFlags, double* sourceLoading, std::vector<Handle>& shed) {
+    thread_local std::vector<double> demands;
+    
+    const std::uint8_t* operational = sourceOperational.data();
+    const double* capacity = sourceCapacity.data();
+    const double* demand = loadDemand.data();
+    double headroom = 0.0;
+    for (Handle source : busbarSources[busbar]) {
+        if (operational[source]) {
+            headroom += std::max(capacity[source] - sourceLoading[source], 0.0);
+        }
+    }
+    if (headroom < CURTAILMENT_TOLERANCE) {
+        headroom = 0.0;
+    }
+    
+    double served = wanted;
+    if (wanted <= headroom) {
+        for (Handle load : loads) {
+            servedFlags[load] = 1;
+        }
+    } else {
+        demands.clear();
+        for (Handle load : loads) {
+            demands.push_back(demand[load]);
+        }
+        double level = waterLevel(demands, headroom);
+        double* servedKw = loadServedKw.edit().data();
+        served = 0.0;
+        for (Handle load : loads) {
+            if (demand[load] <= level) {
+                servedFlags[load] = 1;
+                served += demand[load];
+            } else if (level > 0.0) {
+                servedFlags[load] = CURTAILED;
+                servedKw[load] = level;
+                served += level;
+            } else {
+                shed.push_back(load);
+            }
+        }
+    }
+    
+    // Pooled headroom is charged to the sources in connection order
+    double remaining = served;
+    for (Handle source : busbarSources[busbar]) {
+        if (remaining <= 0.0) break;
+        if (!operational[source]) continue;
+        double take = std::min(std::max(capacity[source] - sourceLoading[source], 0.0), remaining);
+        sourceLoading[source] += take;
+        remaining -= take;
+    }
+    return served;
+}
+
+double GridState::evaluateBusbar(Handle busbar, const Handle* outagedSources, std::size_t outagedCount,
+                                 std::vector<double>& sourceLoadScratch, 
+                                 std::vector<Handle>& shed) const {
+    const auto& sources = busbarSources[busbar];
+    
+    // Outaged sources get no headroom at all; the rest start empty
+    sourceLoadScratch.resize(sources.size());
+    for (std::size_t i = 0; i < sources.size(); ++i) {
+        bool outaged = std::find(outagedSources, outagedSources + outagedCount, sources[i]) 
+                       != outagedSources + outagedCount;
+        sourceLoadScratch[i] = (outaged || !sourceOperational[sources[i]]) ? -1.0 : 0.0;
+    }
+    
+    double served = 0.0;
+    for (Handle load : busbarLoads[busbar]) {
+        if (!loadConnected[load]) continue;
+        double demandPower = loadDemand[load];
+        bool loadServed = false;
+        for (std::size_t i = 0; i < sources.size(); ++i) {
+            if (sourceLoadScratch[i] >= 0.0 &&
+                sourceLoadScratch[i] + demandPower <= sourceCapacity[sources[i]]) {
+                sourceLoadScratch[i] += demandPower;
+                loadServed = true;
+                break;
+            }
+        }
+        if (loadServed) {
+            served += demandPower;
+        } else {
+            shed.push_back(load);
+        }
+    }
+    return served;
+}
+
+void GridState::commitBusbarServed(Handle busbar, double served) {
+    servedDemand += served - busbarServedDemand[busbar];
+    busbarServedDemand[busbar] = served;
+}
+
+double GridState::busbarConnectedLoad(Handle busbar) const {
+    return busbarDemand[busbar];
+}
+
+double GridState::busbarConnectedLoad(Handle busbar, Priority priority) const {
+    return busbarPriorityDemand[busbar * PRIORITY_COUNT + static_cast<std::size_t>(priority) - 1];
+}
+
+double GridState::busbarServedPower(Handle busbar) const {
+    return busbarServedDemand[busbar];
+}
+
+double GridState::busbarOperationalCapacity(Handle busbar) const {
+    return busbarCapacity[busbar];
+}
+
+bool GridState::isBusbarEnergized(Handle busbar) const {
+    return busbarOperationalSources[busbar] > 0;
+}
+
+double GridState::busbarAvailablePower(Handle busbar) const {
+    double totalPower = 0.0;
+    for (Handle source : busbarSources[busbar]) {
+        if (sourceOperational[source]) {
+            totalPower += sourceCapacity[source] - sourceCurrentLoad[source];
+        }
+    }
+    return totalPower;
+}
@@ -0,0 +1,193 @@
+// Instrumentation.cpp
+#include "../include/Instrumentation.h"
+#include <algorithm>
+#include <cstdio>
+#include <string>
+
+namespace instrumentation {
+
+namespace {
+
+constexpr std::size_t PHASE_COUNT = static_cast<std::size_t>(Phase::COUNT);
+constexpr std::size_t COUNTER_COUNT = static_cast<std::size_t>(Counter::COUNT);
+
+std::array<Histogram, PHASE_COUNT> phaseHistograms;
+std::array<std::atomic<std::uint64_t>, COUNTER_COUNT> counters{};
+
+std::size_t bucketOf(std::uint64_t ns) {
+    std::size_t bucket = 0;
+    while (ns != 0 && bucket + 1 < Histogram::BUCKETS) {
+        ns >>= 1;
+        ++bucket;
+    }
+    return bucket;
+}
+
+std::uint64_t bucketUpperNs(std::size_t bucket) {
+    return bucket == 0 ? 0 : (std::uint64_t(1) << bucket) - 1;
+}
+
+// Nanoseconds in the most readable unit
+std::string formatDuration(double ns) {
+    char text[32];
+    if (ns < 1e3) {
+        std::snprintf(text, sizeof(text), "%.0f ns", ns);
+    } else if (ns < 1e6) {
+        std::snprintf(text, sizeof(text), "%.1f us", ns / 1e3);
+    } else if (ns < 1e9) {
+        std::snprintf(text, sizeof(text), "%.1f ms", ns / 1e6);
+    } else {
+        std::snprintf(text, sizeof(text), "%.2f s", ns / 1e9);
+    }
+    return text;
+}
+
+} // namespace
+
+void Histogram::record(std::uint64_t ns) {
+    buckets[bucketOf(ns)].fetch_add(1, std::memory_order_relaxed);
+    count.fetch_add(1, std::memory_order_relaxed);
+    totalNs.fetch_add(ns, std::memory_order_relaxed);
+    std::uint64_t seen = maxNs.load(std::memory_order_relaxed);
+    while (ns > seen && !maxNs.compare_exchange_weak(seen, ns, std::memory_order_relaxed)) {
+    }
+}
+
+void Histogram::reset() {
+    for (auto& bucket : buckets) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    count.store(0, std::memory_order_relaxed);
+    totalNs.store(0, std::memory_order_relaxed);
+    maxNs.store(0, std::memory_order_relaxed);
+}
+
+std::uint64_t Histogram::getCount() const {
+    return count.load(std::memory_order_relaxed);
+}
+
+std::uint64_t Histogram::getTotalNs() const {
+    return totalNs.load(std::memory_order_relaxed);
+}
+
+std::uint64_t Histogram::getMaxNs() const {
+    return maxNs.load(std::memory_order_relaxed);
+}
+
+std::uint64_t Histogram::getBucket(std::size_t bucket) const {
+    return buckets[bucket].load(std::memory_order_relaxed);
+}
+
+std::uint64_t Histogram::percentileNs(double fraction) const {
+    std::uint64_t total = getCount();
+    std::uint64_t seen = 0;
+    for (std::size_t bucket = 0; bucket < BUCKETS; ++bucket) {
+        seen += getBucket(bucket);
+        if (seen > 0 && static_cast<double>(seen) >= fraction * static_cast<double>(total)) {
+            return bucketUpperNs(bucket);
+        }
+    }
+    return getMaxNs();
+}
+
+void recordPhase(Phase phase, std::uint64_t ns) {
+    phaseHistograms[static_cast<std::size_t>(phase)].record(ns);
+}
+
+void addCount(Counter counter, std::uint64_t amount) {
+    counters[static_cast<std::size_t>(counter)].fetch_add(amount, std::memory_order_relaxed);
+}
+
+const Histogram& getPhaseHistogram(Phase phase) {
+    return phaseHistograms[static_cast<std::size_t>(phase)];
+}
+
+std::uint64_t getCount(Counter counter) {
+    return counters[static_cast<std::size_t>(counter)].load(std::memory_order_relaxed);
+}
+
+const char* phaseName(Phase phase) {
+    switch (phase) {
+        case Phase::DISPATCH: return "dispatch";
+        case Phase::RESET: return "reset";
+        case Phase::SORT: return "sort";
+        case Phase::ALLOCATE: return "allocate";
+        case Phase::SHED: return "shed";
+        case Phase::STATS: return "stats";
+        case Phase::TRANSFER: return "transfer";
+        case Phase::ECONOMIC: return "economic";
+        case Phase::POWER_FLOW: return "power flow";
+        default: return "unknown";
+    }
+}
+
+const char* counterName(Counter counter) {
+    switch (counter) {
+        case Counter::SOURCE_PROBES: return "source probes";
+        case Counter::ALLOCATIONS: return "allocations";
+        case Counter::LOADS_SHED: return "loads shed";
+        case Counter::BUSBARS_SOLVED: return "busbars solved";
+        case Counter::COVERED_BUSBARS: return "covered busbars";
+        case Counter::TRANSFERS: return "transfers";
+        case Counter::FACTORIZATIONS: return "factorizations";
+        default: return "unknown";
+    }
+}
+
+void reset() {
+    for (auto& histogram : phaseHistograms) {
+        histogram.reset();
+    }
+    for (auto& counter : counters) {
+        counter.store(0, std::memory_order_relaxed);
+    }
+}
+
+void writeReport(std::ostream& out) {
+    if (!ENABLED) {
+        out << "Instrumentation is not compiled in (configure with -DENABLE_INSTRUMENTATION=ON)\n";
+        return;
+    }
+
+    out << "Dispatch counters:\n";
+    for (std::size_t i = 0; i < COUNTER_COUNT; ++i) {
+        Counter counter = static_cast<Counter>(i);
+        out << "  " << counterName(counter) << ": " << getCount(counter) << "\n";
+    }
+
+    out << "Dispatch phases:\n";
+    for (std::size_t i = 0; i < PHASE_COUNT; ++i) {
+        Phase phase = static_cast<Phase>(i);
+        const Histogram& histogram = getPhaseHistogram(phase);
+        std::uint64_t samples = histogram.getCount();
+        out << "  " << phaseName(phase) << ": " << samples << " samples";
+        if (samples == 0) {
+            out << "\n";
+            continue;
+        }
+        out << ", total " << formatDuration(static_cast<double>(histogram.getTotalNs()))
+            << ", mean " << formatDuration(static_cast<double>(histogram.getTotalNs()) / samples)
+            << ", p50 <= " << formatDuration(static_cast<double>(histogram.percentileNs(0.50)))
+            << ", p99 <= " << formatDuration(static_cast<double>(histogram.percentileNs(0.99)))
+            << ", max " << formatDuration(static_cast<double>(histogram.getMaxNs())) << "\n";
+
+        // One line per non-empty bucket, with a bar scaled to the fullest
+        std::uint64_t fullest = 0;
+        for (std::size_t bucket = 0; bucket < Histogram::BUCKETS; ++bucket) {
+            fullest = std::max(fullest, histogram.getBucket(bucket));
+        }
+        for (std::size_t bucket = 0; bucket < Histogram::BUCKETS; ++bucket) {
+            std::uint64_t hits = histogram.getBucket(bucket);
+            if (hits == 0) {
+                continue;
+            }
+            char line[64];
+            std::snprintf(line, sizeof(line), "    <= %-10s %12llu ",
+                          formatDuration(static_cast<double>(bucketUpperNs(bucket))).c_str(),
+                          static_cast<unsigned long long>(hits));
+            out << line << std::string(static_cast<std::size_t>(40 * hits / fullest) + 1, '#') << "\n";
+        }
+    }
+}
+
+} // namespace instrumentation
@@ -1,16 +1,86 @@
 // Load.cpp
 #include "../include/Load.h"
+#include "../include/GridState.h"
+#include <algorithm>
+#include <cctype>
+
+namespace {
+
+bool equalsIgnoreCase(std::string_view text, std::string_view name) {
+    if (text.size() != name.size()) {
+        return false;
+    }
+    for (std::size_t i = 0; i < text.size(); ++i) {
+        if (std::toupper(static_cast<unsigned char>(text[i])) != name[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+bool parseLoadType(std::string_view text, LoadType& type) {
+    if (equalsIgnoreCase(text, "RESIDENTIAL")) type = LoadType::RESIDENTIAL;
+    else if (equalsIgnoreCase(text, "COMMERCIAL")) type = LoadType::COMMERCIAL;
+    else if (equalsIgnoreCase(text, "INDUSTRIAL")) type = LoadType::INDUSTRIAL;
+    else if (equalsIgnoreCase(text, "CRITICAL")) type = LoadType::CRITICAL;
+    else return false;
+    return true;
+}
+
+bool parsePriority(std::string_view text, Priority& priority) {
+    if (equalsIgnoreCase(text, "CRITICAL") || text == "1") priority = Priority::CRITICAL;
+    else if (equalsIgnoreCase(text, "HIGH") || text == "2") priority = Priority::HIGH;
+    else if (equalsIgnoreCase(text, "MEDIUM") || text == "3") priority = Priority::MEDIUM;
+    else if (equalsIgnoreCase(text, "LOW") || text == "4") priority = Priority::LOW;
+    else if (equalsIgnoreCase(text, "MINIMAL") || text == "5") priority = Priority::MINIMAL;
+    else return false;
+    return true;
+}
+
+const char* loadTypeName(LoadType type) {
+    switch (type) {
+        case LoadType::RESIDENTIAL: return "RESIDENTIAL";
+        case LoadType::COMMERCIAL: return "COMMERCIAL";
+        case LoadType::INDUSTRIAL: return "INDUSTRIAL";
+        case LoadType::CRITICAL: return "CRITICAL";
+        default: return "UNKNOWN";
+    }
+}
+
+const char* loadTypeDisplayName(LoadType type) {
+    switch (type) {
+        case LoadType::RESIDENTIAL: return "Residential";
+        case LoadType::COMMERCIAL: return "Commercial";
+        case LoadType::INDUSTRIAL: return "Industrial";
+        case LoadType::CRITICAL: return "Critical";
+        default: return "Unknown";
+    }
+}
+
+const char* priorityDisplayName(Priority priority) {
+    switch (priority) {
+        case Priority::CRITICAL: return "Critical (1)";
+        case Priority::HIGH: return "High (2)";
+        case Priority::MEDIUM: return "Medium (3)";
+        case Priority::LOW: return "Low (4)";
+        case Priority::MINIMAL: return "Minimal (5)";
+        default: return "Unknown";
+    }
+}
 
 Load::Load(const std::string& id, double powerDemand, LoadType type, Priority priority)
     : id(id), powerDemand(powerDemand), type(type), priority(priority), 
-      isConnected(false), isServed(false) {}
+      isConnected(false), isServed(false), baseDemand(powerDemand), profileScale(1.0), 
+      curtailable(false), servedPower(0.0), state(nullptr), handle(GridState::INVALID_HANDLE), busbarSlot(0) {}
 
-std::string Load::getId() const {
+const std::string& Load::getId() const {
     return id;
 }
 
 double Load::getPowerDemand() const {
-    return powerDemand;
+    return state ? state->loadDemand[handle] : powerDemand;
 }
 
 LoadType Load::getType() const {
@@ -22,47 +92,107 @@ Priority Load::getPriority() const {
 }
 
 bool Load::isLoadConnected() const {
-    return isConnected;
+    return state ? state->loadConnected[handle] != 0 : isConnected;
 }
 
 bool Load::isLoadServed() const {
-    return isServed;
+    return state ? state->loadServed[handle] != 0 : isServed;
+}
+
+double Load::getBaseDemand() const {
+    return state ? state->loadBaseDemand[handle] : baseDemand;
+}
+
+double Load::getProfileScale() const {
+    return state ? state->loadProfileScale[handle] : profileScale;
+}
+
+bool Load::isCurtailable() const {
+    return state ? state->loadCurtailable[handle] != 0 : curtailable;
+}
+
+double Load::getServedPower() const {
+    if (state) {
+        return state->loadServedPower(handle);
+    }
+    if (!isConnected || !isServed) {
+        return 0.0;
+    }
+    return curtailable ? std::min(servedPower, powerDemand) : powerDemand;
 }
 
 void Load::setPowerDemand(double demand) {
-    powerDemand = demand;
+    if (state) {
+        state->setLoadDemand(handle, demand);
+    } else {
+        powerDemand = demand;
+        baseDemand = demand;
+    }
 }
 
 void Load::connect() {
-    isConnected = true;
+    if (state) {
+        state->setLoadConnected(handle, true);
+    } else {
+        isConnected = true;
+    }
 }
 
 void Load::disconnect() {
-    isConnected = false;
-    isServed = false;
+    if (state) {
+        state->setLoadConnected(handle, false);
+    } else {
+        isConnected = false;
+        isServed = false;
+        servedPower = 0.0;
+    }
 }
 
 void Load::setServed(bool served) {
-    isServed = served;
+    if (state) {
+        state->setLoadServed(handle, served);
+    } else {
+        isServed = served;
+        servedPower = served ? powerDemand : 0.0;
+    }
 }
 
-std::string Load::getTypeString() const {
-    switch (type) {
-        case LoadType::RESIDENTIAL: return "Residential";
-        case LoadType::COMMERCIAL: return "Commercial";
-        case LoadType::INDUSTRIAL: return "Industrial";
-        case LoadType::CRITICAL: return "Critical";
-        default: return "Unknown";
+void Load::setBaseDemand(double demand) {
+    if (state) {
+        state->setLoadProfileInputs(handle, demand, state->loadProfileScale[handle]);
+    } else {
+        baseDemand = demand;
     }
 }
 
-std::string Load::getPriorityString() const {
-    switch (priority) {
-        case Priority::CRITICAL: return "Critical (1)";
-        case Priority::HIGH: return "High (2)";
-        case Priority::MEDIUM: return "Medium (3)";
-        case Priority::LOW: return "Low (4)";
-        case Priority::MINIMAL: return "Minimal (5)";
-        default: return "Unknown";
+void Load::setProfileScale(double scale) {
+    if (state) {
+        state->setLoadProfileInputs(handle, state->loadBaseDemand[handle], scale);
+    } else {
+        profileScale = scale;
+    }
+}
+
+void Load::setCurtailable(bool curtailable) {
+    if (state) {
+        state->setLoadCurtailable(handle, curtailable);
+    } else {
+        this->curtailable = curtailable;
     }
 }
+
+bool Load::isAttached() const {
+    return state != nullptr;
+}
+
+std::size_t Load::getHandle() const {
+    return handle;
+}
+
+std::string Load::getTypeString() const {
+    return loadTypeDisplayName(getType());
+}
+
+std::string Load::getPriorityString() const {
+    return priorityDisplayName(getPriority());
+}
\ No newline at end of file
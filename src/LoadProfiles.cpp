@@ -0,0 +1,32 @@
+// LoadProfiles.cpp
+#include "../include/LoadProfiles.h"
+#include <algorithm>
+
+LoadProfiles::LoadProfiles(std::size_t intervals)
+    : intervals(std::max<std::size_t>(intervals, 1)), 
+      factors(LOAD_TYPE_COUNT * std::max<std::size_t>(intervals, 1), 1.0) {}
+
+std::size_t LoadProfiles::getIntervalCount() const {
+    return intervals;
+}
+
+double LoadProfiles::getFactor(LoadType type, std::size_t interval) const {
+    return factors[static_cast<std::size_t>(type) * intervals + interval % intervals];
+}
+
+bool LoadProfiles::setCurve(LoadType type, const std::vector<double>& curve) {
+    if (curve.size() != intervals) {
+        return false;
+    }
+    std::copy(curve.begin(), curve.end(), 
+              factors.begin() + static_cast<std::size_t>(type) * intervals);
+    return true;
+}
+
+void LoadProfiles::getFactorsForStep(long long step, double (&out)[LOAD_TYPE_COUNT]) const {
+    long long cycle = static_cast<long long>(intervals);
+    std::size_t interval = static_cast<std::size_t>(((step % cycle) + cycle) % cycle);
+    for (std::size_t type = 0; type < LOAD_TYPE_COUNT; ++type) {
+        out[type] = factors[type * intervals + interval];
+    }
+}
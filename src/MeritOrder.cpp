@@ -0,0 +1,230 @@
+// MeritOrder.cpp
+#include "../include/MeritOrder.h"
+#include "../include/GridState.h"
+#include <algorithm>
+
+namespace {
+
+// Demand beyond the sources' capacity by less than this is rounding (kW)
+constexpr double CAPACITY_TOLERANCE = 1e-6;
+
+} // namespace
+
+bool MeritOrder::before(const Segment& a, const Segment& b) {
+    if (a.cost != b.cost) {
+        return a.cost < b.cost;
+    }
+    if (a.source != b.source) {
+        return a.source < b.source;
+    }
+    return a.piece < b.piece;
+}
+
+MeritOrder::BusbarOrder& MeritOrder::orderOf(Handle busbar) {
+    if (busbars.size() <= busbar) {
+        busbars.resize(busbar + 1);
+    }
+    return busbars[busbar];
+}
+
+void MeritOrder::place(const GridState& state, Handle source, std::vector<Segment>& segments) {
+    if (sourceMinOutput.size() <= source) {
+        sourceMinOutput.resize(source + 1, 0.0);
+        sourceMinCost.resize(source + 1, 0.0);
+    }
+    sourceMinOutput[source] = 0.0;
+    sourceMinCost[source] = 0.0;
+    if (!state.sourceOperational[source]) {
+        return;
+    }
+
+    double capacity = std::max(state.sourceCapacity[source], 0.0);
+    double minimum = std::min(std::max(state.sourceMinOutput[source], 0.0), capacity);
+    const std::vector<CostSegment>& curve = state.sourceCostCurve[source];
+    sourceMinOutput[source] = minimum;
+    sourceMinCost[source] = operatingCost(curve, minimum);
+    if (curve.empty()) {
+        if (capacity > minimum) {
+            segments.push_back({0.0, capacity - minimum, source, 0});
+        }
+        return;
+    }
+    // Only the part of each piece between the minimum and the capacity
+    double from = 0.0;
+    for (std::size_t piece = 0; piece < curve.size(); ++piece) {
+        double to = (piece + 1 == curve.size()) ? capacity : std::min(curve[piece].upToKw, capacity);
+        double start = std::max(from, minimum);
+        if (to > start) {
+            segments.push_back({curve[piece].costPerKwh, to - start, source, piece});
+        }
+        from = curve[piece].upToKw;
+    }
+}
+
+void MeritOrder::clear() {
+    busbars.clear();
+    sourceMinOutput.clear();
+    sourceMinCost.clear();
+}
+
+void MeritOrder::rebuild(const GridState& state) {
+    clear();
+    busbars.resize(state.busbarSlotCount());
+    for (Handle source = 0; source < state.sourceSlotCount(); ++source) {
+        if (state.isSourceSlotUsed(source)) {
+            place(state, source, busbars[state.sourceBusbar[source]].segments);
+        }
+    }
+    for (BusbarOrder& order : busbars) {
+        std::sort(order.segments.begin(), order.segments.end(), before);
+    }
+}
+
+void MeritOrder::updateSource(const GridState& state, Handle source) {
+    Handle busbar = state.sourceBusbar[source];
+    removeSource(busbar, source);
+
+    // A source has a handful of pieces, so each is inserted in place rather
+    // than re-sorting the busbar
+    BusbarOrder& order = busbars[busbar];
+    placed.clear();
+    place(state, source, placed);
+    for (const Segment& segment : placed) {
+        auto at = std::upper_bound(order.segments.begin(), order.segments.end(), segment, before);
+        order.sumsValid = std::min(order.sumsValid, static_cast<std::size_t>(at - order.segments.begin()));
+        order.segments.insert(at, segment);
+    }
+}
+
+void MeritOrder::removeSource(Handle busbar, Handle source) {
+    BusbarOrder& order = orderOf(busbar);
+    auto owned = [source](const Segment& segment) { return segment.source == source; };
+    auto first = std::find_if(order.segments.begin(), order.segments.end(), owned);
+    order.sumsValid = std::min(order.sumsValid, static_cast<std::size_t>(first - order.segments.begin()));
+    order.segments.erase(std::remove_if(first, order.segments.end(), owned), order.segments.end());
+    if (source < sourceMinOutput.size()) {
+        sourceMinOutput[source] = 0.0;
+        sourceMinCost[source] = 0.0;
+    }
+}
+
+void MeritOrder::refreshSums(BusbarOrder& order) {
+    const std::vector<Segment>& segments = order.segments;
+    order.widthSums.resize(segments.size());
+    order.costSums.resize(segments.size());
+    for (std::size_t i = order.sumsValid; i < segments.size(); ++i) {
+        double width = i ? order.widthSums[i - 1] : 0.0;
+        double cost = i ? order.costSums[i - 1] : 0.0;
+        order.widthSums[i] = width + segments[i].widthKw;
+        order.costSums[i] = cost + segments[i].widthKw * segments[i].cost;
+    }
+    order.sumsValid = segments.size();
+}
+
+bool MeritOrder::dispatch(const GridState& state, Handle busbar, double demand, double* outputs,
+                          Dispatch& result) {
+    BusbarOrder& order = orderOf(busbar);
+    const std::vector<Handle>& sources = state.busbarSources[busbar];
+    double minimum = 0.0;
+    double minimumCost = 0.0;
+    for (Handle source : sources) {
+        minimum += sourceMinOutput[source];
+        minimumCost += sourceMinCost[source];
+    }
+    if (demand < minimum) {
+        return commitAndDispatch(state, busbar, demand, outputs, result);
+    }
+
+    // Lambda search: the first segment whose cumulative width covers what
+    // the minimum outputs leave
+    refreshSums(order);
+    const std::vector<Segment>& segments = order.segments;
+    double rest = demand - minimum;
+    std::size_t marginal = static_cast<std::size_t>(
+        std::lower_bound(order.widthSums.begin(), order.widthSums.end(), rest) - order.widthSums.begin());
+    if (marginal == segments.size()) {
+        double available = segments.empty() ? 0.0 : order.widthSums.back();
+        if (rest - available > CAPACITY_TOLERANCE) {
+            return false;
+        }
+        marginal = segments.empty() ? 0 : segments.size() - 1;
+    }
+
+    for (Handle source : sources) {
+        outputs[source] = sourceMinOutput[source];
+    }
+    result.costPerHour = minimumCost;
+    result.lambda = segments.empty() ? 0.0 : segments[marginal].cost;
+    if (segments.empty() || rest <= 0.0) {
+        return true;
+    }
+    for (std::size_t i = 0; i < marginal; ++i) {
+        outputs[segments[i].source] += segments[i].widthKw;
+    }
+    double below = marginal ? order.widthSums[marginal - 1] : 0.0;
+    double partial = std::min(rest - below, segments[marginal].widthKw);
+    outputs[segments[marginal].source] += partial;
+    result.costPerHour += (marginal ? order.costSums[marginal - 1] : 0.0) + partial * segments[marginal].cost;
+    return true;
+}
+
+bool MeritOrder::commitAndDispatch(const GridState& state, Handle busbar, double demand, double* outputs,
+                                   Dispatch& result) const {
+    thread_local std::vector<Handle> candidates;
+    thread_local std::vector<Handle> committed;
+
+    const std::vector<Handle>& sources = state.busbarSources[busbar];
+    candidates.clear();
+    for (Handle source : sources) {
+        if (state.sourceOperational[source] && state.sourceCapacity[source] > 0.0) {
+            candidates.push_back(source);
+        }
+    }
+    auto costAtMinimum = [&](Handle source) {
+        return incrementalCost(state.sourceCostCurve[source], sourceMinOutput[source]);
+    };
+    std::sort(candidates.begin(), candidates.end(), [&](Handle a, Handle b) {
+        double costA = costAtMinimum(a);
+        double costB = costAtMinimum(b);
+        return costA != costB ? costA < costB : a < b;
+    });
+
+    committed.clear();
+    double minimum = 0.0;
+    double capacity = 0.0;
+    for (Handle source : candidates) {
+        if (capacity >= demand) break;
+        if (minimum + sourceMinOutput[source] > demand) continue;
+        committed.push_back(source);
+        minimum += sourceMinOutput[source];
+        capacity += state.sourceCapacity[source];
+    }
+    if (demand - capacity > CAPACITY_TOLERANCE) {
+        return false;
+    }
+    std::sort(committed.begin(), committed.end());
+
+    for (Handle source : sources) {
+        outputs[source] = 0.0;
+    }
+    result.costPerHour = 0.0;
+    result.lambda = 0.0;
+    for (Handle source : committed) {
+        outputs[source] = sourceMinOutput[source];
+        result.costPerHour += sourceMinCost[source];
+    }
+    // The rest along the merit order, skipping sources left off
+    double rest = demand - minimum;
+    if (busbar < busbars.size()) {
+        for (const Segment& segment : busbars[busbar].segments) {
+            if (rest <= 0.0) break;
+            if (!std::binary_search(committed.begin(), committed.end(), segment.source)) continue;
+            double take = std::min(segment.widthKw, rest);
+            outputs[segment.source] += take;
+            result.costPerHour += take * segment.cost;
+            result.lambda = segment.cost;
+            rest -= take;
+        }
+    }
+    return true;
+}
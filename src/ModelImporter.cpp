@@ -0,0 +1,500 @@
+// ModelImporter.cpp
+#include "../include/ModelImporter.h"
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <utility>
+
+namespace {
+
+constexpr std::size_t CHUNK_SIZE = 1 << 20;
+
+const char* const COLUMN_NAMES[] = {"id", "kind", "kw", "capacity", "type", "priority", "busbar"};
+
+bool equalsIgnoreCase(std::string_view text, std::string_view lowerName) {
+    if (text.size() != lowerName.size()) {
+        return false;
+    }
+    for (std::size_t i = 0; i < text.size(); ++i) {
+        if (std::tolower(static_cast<unsigned char>(text[i])) != lowerName[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool endsWith(const std::string& text, std::string_view suffix) {
+    return text.size() >= suffix.size() &&
+           equalsIgnoreCase(std::string_view(text).substr(text.size() - suffix.size()), suffix);
+}
+
+std::string_view trim(std::string_view text) {
+    std::size_t first = text.find_first_not_of(" \t");
+    if (first == std::string_view::npos) {
+        return {};
+    }
+    std::size_t last = text.find_last_not_of(" \t");
+    return text.substr(first, last - first + 1);
+}
+
+void skipSpace(std::string_view line, std::size_t& pos) {
+    while (pos < line.size() && (line[pos] == ' ' || line[pos] == '\t')) {
+        ++pos;
+    }
+}
+
+bool parseNumber(std::string_view text, double& value) {
+    const char* end = text.data() + text.size();
+    auto result = std::from_chars(text.data(), end, value);
+    return result.ec == std::errc() && result.ptr == end && std::isfinite(value);
+}
+
+// Reads the CSV field at pos and moves pos past the comma that ends it, or
+// to npos after the last field. Quoted fields with doubled quotes are
+// unescaped into scratch.
+bool readCsvField(std::string_view line, std::size_t& pos, std::string_view& value,
+                  std::string& scratch, std::string& error) {
+    skipSpace(line, pos);
+    if (pos < line.size() && line[pos] == '"') {
+        std::size_t start = ++pos;
+        bool escaped = false;
+        for (;;) {
+            std::size_t quote = line.find('"', pos);
+            if (quote == std::string_view::npos) {
+                error = "unterminated quoted field";
+                return false;
+            }
+            if (quote + 1 < line.size() && line[quote + 1] == '"') {
+                escaped = true;
+                pos = quote + 2;
+                continue;
+            }
+            value = line.substr(start, quote - start);
+            pos = quote + 1;
+            break;
+        }
+        if (escaped) {
+            scratch.clear();
+            for (std::size_t i = 0; i < value.size(); ++i) {
+                scratch += value[i];
+                if (value[i] == '"') {
+                    ++i;  // Skip the second quote of the pair
+                }
+            }
+            value = scratch;
+        }
+        skipSpace(line, pos);
+        if (pos < line.size() && line[pos] != ',') {
+            error = "unexpected text after quoted field";
+            return false;
+        }
+    } else {
+        std::size_t comma = line.find(',', pos);
+        std::size_t end = (comma == std::string_view::npos) ? line.size() : comma;
+        value = trim(line.substr(pos, end - pos));
+        pos = end;
+    }
+    pos = (pos < line.size()) ? pos + 1 : std::string_view::npos;
+    return true;
+}
+
+void appendUtf8(std::string& text, unsigned codePoint) {
+    if (codePoint < 0x80) {
+        text += static_cast<char>(codePoint);
+    } else if (codePoint < 0x800) {
+        text += static_cast<char>(0xC0 | (codePoint >> 6));
+        text += static_cast<char>(0x80 | (codePoint & 0x3F));
+    } else {
+        text += static_cast<char>(0xE0 | (codePoint >> 12));
+        text += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+        text += static_cast<char>(0x80 | (codePoint & 0x3F));
+    }
+}
+
+// Reads the JSON string at pos (which must be at its opening quote) and
+// moves pos past it. Strings with escapes are decoded into scratch.
+bool readJsonString(std::string_view line, std::size_t& pos, std::string_view& value,
+                    std::string& scratch, std::string& error) {
+    std::size_t start = ++pos;
+    std::size_t end = line.find_first_of("\"\\", start);
+    if (end != std::string_view::npos && line[end] == '"') {
+        value = line.substr(start, end - start);
+        pos = end + 1;
+        return true;
+    }
+
+    scratch.assign(line.data() + start, (end == std::string_view::npos ? line.size() : end) - start);
+    pos = end;
+    while (pos < line.size() && line[pos] != '"') {
+        char c = line[pos++];
+        if (c != '\\') {
+            scratch += c;
+            continue;
+        }
+        if (pos >= line.size()) {
+            break;
+        }
+        char escape = line[pos++];
+        switch (escape) {
+            case '"': case '\\': case '/': scratch += escape; break;
+            case 'b': scratch += '\b'; break;
+            case 'f': scratch += '\f'; break;
+            case 'n': scratch += '\n'; break;
+            case 'r': scratch += '\r'; break;
+            case 't': scratch += '\t'; break;
+            case 'u': {
+                unsigned codePoint = 0;
+                const char* digits = line.data() + pos;
+                if (pos + 4 > line.size() ||
+                    std::from_chars(digits, digits + 4, codePoint, 16).ptr != digits + 4) {
+                    error = "invalid \\u escape";
+                    return false;
+                }
+                appendUtf8(scratch, codePoint);
+                pos += 4;
+                break;
+            }
+            default:
+                error = std::string("invalid escape \\") + escape;
+                return false;
+        }
+    }
+    if (pos >= line.size()) {
+        error = "unterminated string";
+        return false;
+    }
+    value = scratch;
+    ++pos;
+    return true;
+}
+
+} // namespace
+
+ModelImporter::ModelImporter(Grid& grid, std::size_t batchSize)
+    : grid(grid), batchSize(batchSize ? batchSize : 1), loadCount(0), sourceCount(0),
+      busbarCount(0), jsonLines(false), started(false), lastBusbar(nullptr) {}
+
+ModelImporter::Column ModelImporter::columnFor(std::string_view name) {
+    name = trim(name);
+    if (equalsIgnoreCase(name, "id")) return ID;
+    if (equalsIgnoreCase(name, "kind")) return KIND;
+    if (equalsIgnoreCase(name, "kw") || equalsIgnoreCase(name, "demand_kw")) return DEMAND;
+    if (equalsIgnoreCase(name, "capacity") || equalsIgnoreCase(name, "capacity_kw")) return CAPACITY;
+    if (equalsIgnoreCase(name, "type")) return TYPE;
+    if (equalsIgnoreCase(name, "priority")) return PRIORITY;
+    if (equalsIgnoreCase(name, "busbar")) return BUSBAR;
+    return IGNORED;
+}
+
+bool ModelImporter::importFile(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        lastError = "cannot open " + path;
+        return false;
+    }
+
+    jsonLines = endsWith(path, ".jsonl") || endsWith(path, ".ndjson");
+    started = false;
+    csvColumns.clear();
+    loadIds.clear();
+    sourceIds.clear();
+    lastBusbar = nullptr;
+
+    // Lines are parsed in place in the chunk; a partial line at the end of a
+    // chunk moves to the front before the next read
+    std::vector<char> buffer(CHUNK_SIZE);
+    std::size_t filled = 0;
+    int lineNumber = 0;
+    bool ok = true;
+    while (ok) {
+        if (filled == buffer.size()) {
+            buffer.resize(buffer.size() * 2);  // One line fills the whole chunk
+        }
+        file.read(buffer.data() + filled, static_cast<std::streamsize>(buffer.size() - filled));
+        std::size_t got = static_cast<std::size_t>(file.gcount());
+        filled += got;
+        bool atEnd = (got == 0);
+
+        std::size_t start = 0;
+        while (ok && start < filled) {
+            const char* newline = static_cast<const char*>(
+                std::memchr(buffer.data() + start, '\n', filled - start));
+            if (!newline && !atEnd) {
+                break;
+            }
+            std::size_t end = newline ? static_cast<std::size_t>(newline - buffer.data()) : filled;
+            std::string_view line(buffer.data() + start, end - start);
+            if (lineNumber == 0 && line.substr(0, 3) == "\xEF\xBB\xBF") {
+                line.remove_prefix(3);  // UTF-8 byte order mark
+            }
+            ++lineNumber;
+            if (!parseLine(line)) {
+                lastError = path + ":" + std::to_string(lineNumber) + ": " + lastError;
+                ok = false;
+            }
+            start = newline ? end + 1 : filled;
+        }
+        if (atEnd) {
+            break;
+        }
+        std::memmove(buffer.data(), buffer.data() + start, filled - start);
+        filled -= start;
+    }
+    if (ok && file.bad()) {
+        lastError = "cannot read " + path;
+        ok = false;
+    }
+
+    commit();
+    return ok;
+}
+
+bool ModelImporter::parseLine(std::string_view line) {
+    if (!line.empty() && line.back() == '\r') {
+        line.remove_suffix(1);
+    }
+    std::size_t first = line.find_first_not_of(" \t");
+    if (first == std::string_view::npos || line[first] == '#') {
+        return true;
+    }
+
+    if (!started) {
+        started = true;
+        if (line[first] == '{') {
+            jsonLines = true;
+        } else if (!jsonLines) {
+            return parseCsvHeader(line);
+        }
+    }
+
+    Record record;
+    if (jsonLines ? !parseJsonRecord(line, record) : !parseCsvRecord(line, record)) {
+        return false;
+    }
+    return addRecord(record);
+}
+
+bool ModelImporter::parseCsvHeader(std::string_view line) {
+    bool hasId = false;
+    std::size_t pos = 0;
+    while (pos != std::string_view::npos) {
+        std::string_view name;
+        if (!readCsvField(line, pos, name, scratch, lastError)) {
+            return false;
+        }
+        csvColumns.push_back(columnFor(name));
+        hasId = hasId || csvColumns.back() == ID;
+    }
+    if (!hasId) {
+        lastError = "header has no id column";
+        return false;
+    }
+    return true;
+}
+
+bool ModelImporter::parseCsvRecord(std::string_view line, Record& record) {
+    std::size_t pos = 0;
+    for (std::size_t field = 0; pos != std::string_view::npos; ++field) {
+        Column column = (field < csvColumns.size()) ? csvColumns[field] : IGNORED;
+        std::string_view value;
+        if (!readCsvField(line, pos, value, column == IGNORED ? scratch : unescaped[column], lastError)) {
+            return false;
+        }
+        if (column != IGNORED) {
+            record[column] = value;
+        }
+    }
+    return true;
+}
+
+bool ModelImporter::parseJsonRecord(std::string_view line, Record& record) {
+    std::size_t pos = 0;
+    skipSpace(line, pos);
+    if (pos >= line.size() || line[pos] != '{') {
+        lastError = "expected a JSON object";
+        return false;
+    }
+    ++pos;
+    skipSpace(line, pos);
+    bool more = (pos < line.size() && line[pos] != '}');
+    while (more) {
+        std::string_view key;
+        skipSpace(line, pos);
+        if (pos >= line.size() || line[pos] != '"') {
+            lastError = "expected a key";
+            return false;
+        }
+        if (!readJsonString(line, pos, key, scratch, lastError)) {
+            return false;
+        }
+        Column column = columnFor(key);
+        skipSpace(line, pos);
+        if (pos >= line.size() || line[pos] != ':') {
+            lastError = "expected ':' after a key";
+            return false;
+        }
+        ++pos;
+        skipSpace(line, pos);
+
+        std::string_view value;
+        if (pos < line.size() && line[pos] == '"') {
+            if (!readJsonString(line, pos, value, column == IGNORED ? scratch : unescaped[column], lastError)) {
+                return false;
+            }
+        } else if (pos < line.size() && (line[pos] == '{' || line[pos] == '[')) {
+            lastError = "nested values are not supported";
+            return false;
+        } else {
+            // Numbers, true, false and null
+            std::size_t end = line.find_first_of(",} \t", pos);
+            end = (end == std::string_view::npos) ? line.size() : end;
+            value = line.substr(pos, end - pos);
+            pos = end;
+            if (value.empty()) {
+                lastError = "expected a value";
+                return false;
+            }
+            if (value == "null") {
+                value = {};
+            }
+        }
+        if (column != IGNORED) {
+            record[column] = value;
+        }
+
+        skipSpace(line, pos);
+        if (pos < line.size() && line[pos] == ',') {
+            ++pos;
+        } else if (pos < line.size() && line[pos] == '}') {
+            more = false;
+        } else {
+            lastError = "expected ',' or '}'";
+            return false;
+        }
+    }
+    ++pos;  // Past the closing brace
+    skipSpace(line, pos);
+    if (pos < line.size()) {
+        lastError = "unexpected text after the object";
+        return false;
+    }
+    return true;
+}
+
+bool ModelImporter::addRecord(const Record& record) {
+    for (Column column : {ID, BUSBAR}) {
+        if (record[column].empty()) {
+            lastError = std::string("missing ") + COLUMN_NAMES[column];
+            return false;
+        }
+    }
+
+    bool isSource = !record[CAPACITY].empty();
+    if (!record[KIND].empty()) {
+        if (equalsIgnoreCase(record[KIND], "source")) {
+            isSource = true;
+        } else if (equalsIgnoreCase(record[KIND], "load")) {
+            isSource = false;
+        } else {
+            lastError = "unknown kind '" + std::string(record[KIND]) + "'";
+            return false;
+        }
+    }
+
+    if (isSource) {
+        double capacity;
+        if (!parseNumber(record[CAPACITY], capacity)) {
+            lastError = "invalid capacity '" + std::string(record[CAPACITY]) + "'";
+            return false;
+        }
+        if (capacity < 0.0) {
+            lastError = "negative capacity '" + std::string(record[CAPACITY]) + "'";
+            return false;
+        }
+        if (sourceIds.count(record[ID])) {
+            lastError = "duplicate source id '" + std::string(record[ID]) + "'";
+            return false;
+        }
+        auto source = grid.createSource(std::string(record[ID]), capacity);
+        sourceIds.insert(source->getId());
+        pendingSources.push_back({std::move(source), busbarFor(record[BUSBAR])});
+    } else {
+        double demand;
+        LoadType type;
+        Priority priority;
+        if (!parseNumber(record[DEMAND], demand)) {
+            lastError = "invalid demand '" + std::string(record[DEMAND]) + "'";
+            return false;
+        }
+        if (demand < 0.0) {
+            lastError = "negative demand '" + std::string(record[DEMAND]) + "'";
+            return false;
+        }
+        if (!parseLoadType(record[TYPE], type)) {
+            lastError = "unknown load type '" + std::string(record[TYPE]) + "'";
+            return false;
+        }
+        if (!parsePriority(record[PRIORITY], priority)) {
+            lastError = "unknown priority '" + std::string(record[PRIORITY]) + "'";
+            return false;
+        }
+        if (loadIds.count(record[ID])) {
+            lastError = "duplicate load id '" + std::string(record[ID]) + "'";
+            return false;
+        }
+        auto load = grid.createLoad(std::string(record[ID]), demand, type, priority);
+        loadIds.insert(load->getId());
+        pendingLoads.push_back({std::move(load), busbarFor(record[BUSBAR])});
+    }
+
+    if (pendingLoads.size() + pendingSources.size() >= batchSize) {
+        commit();
+    }
+    return true;
+}
+
+Busbar* ModelImporter::busbarFor(std::string_view busbarId) {
+    if (lastBusbar && lastBusbar->getId() == busbarId) {
+        return lastBusbar;
+    }
+    std::string id(busbarId);
+    auto busbar = grid.getBusbar(id);
+    if (!busbar) {
+        busbar = grid.createBusbar(id);
+        grid.addBusbar(busbar);
+        ++busbarCount;
+    }
+    lastBusbar = busbar.get();
+    return lastBusbar;
+}
+
+void ModelImporter::commit() {
+    if (!pendingSources.empty()) {
+        grid.addSources(pendingSources);
+        sourceCount += pendingSources.size();
+        pendingSources.clear();
+    }
+    if (!pendingLoads.empty()) {
+        grid.addLoads(pendingLoads);
+        loadCount += pendingLoads.size();
+        pendingLoads.clear();
+    }
+}
+
+const std::string& ModelImporter::getLastError() const {
+    return lastError;
+}
+
+std::size_t ModelImporter::getLoadCount() const {
+    return loadCount;
+}
+
+std::size_t ModelImporter::getSourceCount() const {
+    return sourceCount;
+}
+
+std::size_t ModelImporter::getBusbarCount() const {
+    return busbarCount;
+}
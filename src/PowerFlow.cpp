@@ -0,0 +1,253 @@
+// PowerFlow.cpp
+#include "../include/PowerFlow.h"
+#include "../include/Instrumentation.h"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <iterator>
+#include <numeric>
+#include <queue>
+#include <utility>
+
+PowerFlow::PowerFlow() : overloads(0), maxLoadingPercent(0.0) {}
+
+std::shared_ptr<const PowerFlow::Factor> PowerFlow::factorize(const Topology& topology, std::size_t busbarSlots) {
+    auto result = std::make_shared<Factor>();
+    Factor& factor = *result;
+    factor.revision = topology.getRevision();
+    const std::vector<Topology::Tie>& ties = topology.getTies();
+
+    // Tie-connected groups; each group's lowest handle is its reference
+    std::vector<Handle> group(busbarSlots);
+    std::iota(group.begin(), group.end(), 0);
+    auto root = [&group](Handle busbar) {
+        while (group[busbar] != busbar) {
+            group[busbar] = group[group[busbar]];
+            busbar = group[busbar];
+        }
+        return busbar;
+    };
+    std::vector<std::uint8_t> tied(busbarSlots, 0);
+    for (const Topology::Tie& tie : ties) {
+        if (!tie.closed) continue;
+        tied[tie.from] = tied[tie.to] = 1;
+        Handle a = root(tie.from);
+        Handle b = root(tie.to);
+        group[std::max(a, b)] = std::min(a, b);
+    }
+
+    // A row for every other tied busbar
+    std::vector<std::size_t> node(busbarSlots, NONE);
+    std::vector<Handle> busbarOfNode;
+    for (Handle busbar = 0; busbar < busbarSlots; ++busbar) {
+        if (tied[busbar] && root(busbar) != busbar) {
+            node[busbar] = busbarOfNode.size();
+            busbarOfNode.push_back(busbar);
+        }
+    }
+    std::size_t n = busbarOfNode.size();
+
+    // The susceptance matrix: its diagonal, and each node's susceptances to
+    // other nodes (parallel ties appear once each)
+    std::vector<double> diagonal(n, 0.0);
+    std::vector<std::vector<std::pair<std::size_t, double>>> coupling(n);
+    for (const Topology::Tie& tie : ties) {
+        if (!tie.closed) continue;
+        double susceptance = 1.0 / tie.reactance;
+        std::size_t a = node[tie.from];
+        std::size_t b = node[tie.to];
+        if (a != NONE) diagonal[a] += susceptance;
+        if (b != NONE) diagonal[b] += susceptance;
+        if (a != NONE && b != NONE) {
+            coupling[a].push_back({b, susceptance});
+            coupling[b].push_back({a, susceptance});
+        }
+    }
+
+    // Minimum degree ordering on the elimination graph. Eliminating a node
+    // joins its remaining neighbours into a clique, and those neighbours
+    // are exactly the rows below the diagonal in its column of the factor.
+    std::vector<std::vector<std::size_t>> graph(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        for (const auto& entry : coupling[i]) {
+            graph[i].push_back(entry.first);
+        }
+        std::sort(graph[i].begin(), graph[i].end());
+        graph[i].erase(std::unique(graph[i].begin(), graph[i].end()), graph[i].end());
+    }
+    using Candidate = std::pair<std::size_t, std::size_t>;  // Degree, node
+    std::priority_queue<Candidate, std::vector<Candidate>, std::greater<Candidate>> queue;
+    for (std::size_t i = 0; i < n; ++i) {
+        queue.push({graph[i].size(), i});
+    }
+    std::vector<std::size_t> position(n, NONE);
+    std::vector<std::size_t> eliminated;
+    std::vector<std::vector<std::size_t>> structure(n);
+    std::vector<std::size_t> merged;
+    eliminated.reserve(n);
+    while (!queue.empty()) {
+        Candidate next = queue.top();
+        queue.pop();
+        std::size_t v = next.second;
+        if (position[v] != NONE || next.first != graph[v].size()) {
+            continue;  // Stale entry
+        }
+        position[v] = eliminated.size();
+        eliminated.push_back(v);
+        for (std::size_t u : graph[v]) {
+            merged.clear();
+            std::set_union(graph[u].begin(), graph[u].end(), graph[v].begin(), graph[v].end(),
+                           std::back_inserter(merged));
+            merged.erase(std::remove_if(merged.begin(), merged.end(),
+                                        [u, v](std::size_t w) { return w == u || w == v; }),
+                         merged.end());
+            graph[u].swap(merged);
+            queue.push({graph[u].size(), u});
+        }
+        structure[v].swap(graph[v]);
+    }
+
+    // The factor's structure in elimination order
+    factor.rowOf.assign(busbarSlots, NONE);
+    factor.busbarOf.resize(n);
+    factor.columnStart.assign(n + 1, 0);
+    for (std::size_t k = 0; k < n; ++k) {
+        std::size_t v = eliminated[k];
+        factor.busbarOf[k] = busbarOfNode[v];
+        factor.rowOf[busbarOfNode[v]] = k;
+        factor.columnStart[k + 1] = factor.columnStart[k] + 1 + structure[v].size();
+    }
+    factor.rowIndex.resize(factor.columnStart[n]);
+    factor.values.assign(factor.columnStart[n], 0.0);
+    // Columns with a non-zero in each row, left of the diagonal
+    std::vector<std::size_t> rowStart(n + 1, 0);
+    for (std::size_t k = 0; k < n; ++k) {
+        std::size_t p = factor.columnStart[k];
+        factor.rowIndex[p++] = k;
+        for (std::size_t w : structure[eliminated[k]]) {
+            factor.rowIndex[p++] = position[w];
+            ++rowStart[position[w] + 1];
+        }
+        std::sort(factor.rowIndex.begin() + factor.columnStart[k] + 1, factor.rowIndex.begin() + p);
+    }
+    for (std::size_t j = 0; j < n; ++j) {
+        rowStart[j + 1] += rowStart[j];
+    }
+    std::vector<std::size_t> rowColumns(rowStart[n]);
+    std::vector<std::size_t> fill(rowStart.begin(), rowStart.end() - 1);
+    for (std::size_t k = 0; k < n; ++k) {
+        for (std::size_t p = factor.columnStart[k] + 1; p < factor.columnStart[k + 1]; ++p) {
+            rowColumns[fill[factor.rowIndex[p]]++] = k;
+        }
+    }
+
+    // Left-looking Cholesky: each column is its column of B less the
+    // earlier columns with a non-zero in its row. Those columns are read
+    // from their entry in this row downwards, so each keeps a cursor.
+    std::vector<double> work(n, 0.0);
+    std::vector<std::size_t> cursor(factor.columnStart.begin(), factor.columnStart.end() - 1);
+    for (std::size_t j = 0; j < n; ++j) {
+        std::size_t v = eliminated[j];
+        work[j] = diagonal[v];
+        for (const auto& entry : coupling[v]) {
+            if (position[entry.first] > j) {
+                work[position[entry.first]] -= entry.second;
+            }
+        }
+        for (std::size_t r = rowStart[j]; r < rowStart[j + 1]; ++r) {
+            std::size_t k = rowColumns[r];
+            std::size_t p = ++cursor[k];  // Past the diagonal, or the previous row
+            double ljk = factor.values[p];
+            for (std::size_t q = p; q < factor.columnStart[k + 1]; ++q) {
+                work[factor.rowIndex[q]] -= factor.values[q] * ljk;
+            }
+        }
+        double pivot = std::sqrt(work[j]);
+        work[j] = 0.0;
+        factor.values[factor.columnStart[j]] = pivot;
+        for (std::size_t p = factor.columnStart[j] + 1; p < factor.columnStart[j + 1]; ++p) {
+            factor.values[p] = work[factor.rowIndex[p]] / pivot;
+            work[factor.rowIndex[p]] = 0.0;
+        }
+    }
+    return result;
+}
+
+void PowerFlow::solve(const GridState& state, Topology& topology) {
+    if (!factor || factor->revision != topology.getRevision()) {
+        factor = factorize(topology, state.busbarSlotCount());
+        instrumentation::count(instrumentation::Counter::FACTORIZATIONS);
+    }
+    const Factor& L = *factor;
+    std::size_t n = L.busbarOf.size();
+
+    // Injections: what the busbar's sources put out less what its loads are
+    // served. Any imbalance in a group (system-wide shedding ignores the
+    // ties) is taken up at its reference busbar.
+    angles.resize(n);
+    for (std::size_t row = 0; row < n; ++row) {
+        Handle busbar = L.busbarOf[row];
+        double injection = -state.busbarServedPower(busbar);
+        for (Handle source : state.busbarSources[busbar]) {
+            injection += state.sourceCurrentLoad[source];
+        }
+        angles[row] = injection;
+    }
+    // L y = P, then L' angles = y
+    for (std::size_t j = 0; j < n; ++j) {
+        double y = angles[j] / L.values[L.columnStart[j]];
+        angles[j] = y;
+        for (std::size_t p = L.columnStart[j] + 1; p < L.columnStart[j + 1]; ++p) {
+            angles[L.rowIndex[p]] -= L.values[p] * y;
+        }
+    }
+    for (std::size_t j = n; j-- > 0;) {
+        double theta = angles[j];
+        for (std::size_t p = L.columnStart[j] + 1; p < L.columnStart[j + 1]; ++p) {
+            theta -= L.values[p] * angles[L.rowIndex[p]];
+        }
+        angles[j] = theta / L.values[L.columnStart[j]];
+    }
+
+    auto angleOf = [&](Handle busbar) {
+        std::size_t row = busbar < L.rowOf.size() ? L.rowOf[busbar] : NONE;
+        return row == NONE ? 0.0 : angles[row];
+    };
+    const std::vector<Topology::Tie>& ties = topology.getTies();
+    flows.assign(ties.size(), 0.0);
+    overloads = 0;
+    maxLoadingPercent = 0.0;
+    for (std::size_t i = 0; i < ties.size(); ++i) {
+        const Topology::Tie& tie = ties[i];
+        if (!tie.closed) continue;
+        double flow = (angleOf(tie.from) - angleOf(tie.to)) / tie.reactance;
+        flows[i] = flow;
+        if (std::abs(flow) > tie.limitKw + OVERLOAD_TOLERANCE) {
+            ++overloads;
+        }
+        if (tie.limitKw > 0.0) {
+            maxLoadingPercent = std::max(maxLoadingPercent, std::abs(flow) / tie.limitKw * 100.0);
+        }
+    }
+    topology.setPowerFlows(flows);
+}
+
+void PowerFlow::clear() {
+    factor.reset();
+    angles.clear();
+    flows.clear();
+    overloads = 0;
+    maxLoadingPercent = 0.0;
+}
+
+std::size_t PowerFlow::getOverloadCount() const {
+    return overloads;
+}
+
+double PowerFlow::getMaxLoadingPercent() const {
+    return maxLoadingPercent;
+}
+
+std::size_t PowerFlow::getFactorSize() const {
+    return factor ? factor->values.size() : 0;
+}
@@ -1,59 +1,161 @@
 // PowerSource.cpp
 #include "../include/PowerSource.h"
+#include "../include/GridState.h"
+#include <algorithm>
+
+double operatingCost(const std::vector<CostSegment>& curve, double outputKw) {
+    double cost = 0.0;
+    double from = 0.0;
+    for (std::size_t i = 0; i < curve.size() && from < outputKw; ++i) {
+        double to = (i + 1 == curve.size()) ? outputKw : std::min(curve[i].upToKw, outputKw);
+        cost += (to - from) * curve[i].costPerKwh;
+        from = to;
+    }
+    return cost;
+}
+
+double incrementalCost(const std::vector<CostSegment>& curve, double outputKw) {
+    for (std::size_t i = 0; i + 1 < curve.size(); ++i) {
+        if (outputKw < curve[i].upToKw) {
+            return curve[i].costPerKwh;
+        }
+    }
+    return curve.empty() ? 0.0 : curve.back().costPerKwh;
+}
+
+bool isConvexCostCurve(const std::vector<CostSegment>& curve) {
+    for (std::size_t i = 1; i < curve.size(); ++i) {
+        if (curve[i].upToKw <= curve[i - 1].upToKw || curve[i].costPerKwh < curve[i - 1].costPerKwh) {
+            return false;
+        }
+    }
+    return true;
+}
 
 PowerSource::PowerSource(const std::string& id, double capacity)
-    : id(id), capacity(capacity), currentLoad(0.0), operational(true) {}
+    : id(id), capacity(capacity), currentLoad(0.0), operational(true), minOutput(0.0),
+      state(nullptr), handle(GridState::INVALID_HANDLE), busbarSlot(0) {}
 
-std::string PowerSource::getId() const {
+const std::string& PowerSource::getId() const {
     return id;
 }
 
 double PowerSource::getCapacity() const {
-    return capacity;
+    return state ? state->sourceCapacity[handle] : capacity;
 }
 
 double PowerSource::getCurrentLoad() const {
-    return currentLoad;
+    return state ? state->sourceCurrentLoad[handle] : currentLoad;
 }
 
 double PowerSource::getAvailableCapacity() const {
-    if (!operational) return 0.0;
-    return capacity - currentLoad;
+    if (!isOperational()) return 0.0;
+    return getCapacity() - getCurrentLoad();
 }
 
 bool PowerSource::isOperational() const {
-    return operational;
+    return state ? state->sourceOperational[handle] != 0 : operational;
+}
+
+double PowerSource::getMinOutput() const {
+    return state ? state->sourceMinOutput[handle] : minOutput;
+}
+
+const std::vector<CostSegment>& PowerSource::getCostCurve() const {
+    return state ? state->sourceCostCurve[handle] : costCurve;
+}
+
+double PowerSource::getMarginalCost() const {
+    return incrementalCost(getCostCurve(), getCurrentLoad());
+}
+
+double PowerSource::getOperatingCost() const {
+    return operatingCost(getCostCurve(), getCurrentLoad());
 }
 
 void PowerSource::setCapacity(double newCapacity) {
-    capacity = newCapacity;
+    if (state) {
+        state->setSourceCapacity(handle, newCapacity);
+    } else {
+        capacity = newCapacity;
+    }
 }
 
 void PowerSource::setOperational(bool isOperational) {
-    operational = isOperational;
+    if (state) {
+        state->setSourceOperational(handle, isOperational);
+    } else {
+        operational = isOperational;
+    }
+}
+
+void PowerSource::setMinOutput(double kw) {
+    if (state) {
+        state->setSourceMinOutput(handle, kw);
+    } else {
+        minOutput = kw;
+    }
+}
+
+void PowerSource::setMarginalCost(double costPerKwh) {
+    setCostCurve({{0.0, costPerKwh}});
+}
+
+bool PowerSource::setCostCurve(const std::vector<CostSegment>& curve) {
+    if (!isConvexCostCurve(curve)) {
+        return false;
+    }
+    if (state) {
+        state->setSourceCostCurve(handle, curve);
+    } else {
+        costCurve = curve;
+    }
+    return true;
 }
 
 bool PowerSource::canSupplyPower(double requestedPower) const {
-    if (!operational) return false;
-    return (currentLoad + requestedPower <= capacity);
+    if (!isOperational()) return false;
+    return (getCurrentLoad() + requestedPower <= getCapacity());
 }
 
 bool PowerSource::addLoad(double power) {
-    if (!operational || !canSupplyPower(power)) {
+    if (!isOperational() || !canSupplyPower(power)) {
         return false;
     }
     
-    currentLoad += power;
+    if (state) {
+        state->setSourceCurrentLoad(handle, state->sourceCurrentLoad[handle] + power);
+    } else {
+        currentLoad += power;
+    }
     return true;
 }
 
 void PowerSource::removeLoad(double power) {
-    currentLoad -= power;
-    if (currentLoad < 0.0) {
-        currentLoad = 0.0;
+    double load = getCurrentLoad() - power;
+    if (load < 0.0) {
+        load = 0.0;
+    }
+    
+    if (state) {
+        state->setSourceCurrentLoad(handle, load);
+    } else {
+        currentLoad = load;
     }
 }
 
 void PowerSource::resetLoading() {
-    currentLoad = 0.0;
+    if (state) {
+        state->setSourceCurrentLoad(handle, 0.0);
+    } else {
+        currentLoad = 0.0;
+    }
+}
+
+bool PowerSource::isAttached() const {
+    return state != nullptr;
+}
+
+std::size_t PowerSource::getHandle() const {
+    return handle;
 }
@@ -0,0 +1,553 @@
+// ReportSink.cpp
+#include "../include/ReportSink.h"
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+
+ReportSink::ReportSink(std::ostream& out, std::size_t bufferSize)
+    : out(out), bufferSize(bufferSize) {
+    buffer.reserve(bufferSize);
+}
+
+ReportSink::~ReportSink() {
+    flush();
+}
+
+void ReportSink::flush() {
+    if (!buffer.empty()) {
+        out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        buffer.clear();
+    }
+    out.flush();
+}
+
+void ReportSink::write(std::string_view text) {
+    if (buffer.size() + text.size() > bufferSize && !buffer.empty()) {
+        out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        buffer.clear();
+    }
+    buffer.append(text.data(), text.size());
+}
+
+void ReportSink::write(char c) {
+    write(std::string_view(&c, 1));
+}
+
+void ReportSink::writeNumber(double value) {
+    char text[32];
+    auto result = std::to_chars(text, text + sizeof(text), value);
+    write(std::string_view(text, static_cast<std::size_t>(result.ptr - text)));
+}
+
+void ReportSink::writeDefaultNumber(double value) {
+    char text[32];
+    auto result = std::to_chars(text, text + sizeof(text), value, std::chars_format::general, 6);
+    write(std::string_view(text, static_cast<std::size_t>(result.ptr - text)));
+}
+
+void ReportSink::writeInteger(long long value) {
+    char text[24];
+    auto result = std::to_chars(text, text + sizeof(text), value);
+    write(std::string_view(text, static_cast<std::size_t>(result.ptr - text)));
+}
+
+void ReportSink::writePadded(std::string_view text, std::size_t width) {
+    write(text);
+    for (std::size_t i = text.size(); i < width; ++i) {
+        write(' ');
+    }
+}
+
+void ReportSink::writePaddedNumber(double value, std::size_t width) {
+    char text[32];
+    auto result = std::to_chars(text, text + sizeof(text), value, std::chars_format::general, 6);
+    writePadded(std::string_view(text, static_cast<std::size_t>(result.ptr - text)), width);
+}
+
+std::unique_ptr<ReportSink> ReportSink::create(const std::string& format, std::ostream& out) {
+    if (format == "table") {
+        return std::make_unique<TableReportSink>(out);
+    }
+    if (format == "csv") {
+        return std::make_unique<CsvReportSink>(out);
+    }
+    if (format == "jsonl") {
+        return std::make_unique<JsonLinesReportSink>(out);
+    }
+    return nullptr;
+}
+
+std::string ReportSink::formatForPath(const std::string& path) {
+    auto endsWith = [&path](const std::string& suffix) {
+        return path.size() >= suffix.size() &&
+               path.compare(path.size() - suffix.size(), suffix.size(), suffix) == 0;
+    };
+    if (endsWith(".csv")) {
+        return "csv";
+    }
+    if (endsWith(".jsonl") || endsWith(".ndjson")) {
+        return "jsonl";
+    }
+    return "table";
+}
+
+// TableReportSink
+
+void TableReportSink::beginReport(std::string_view gridName) {
+    write("\n======= ");
+    write(gridName);
+    write(" SYSTEM REPORT =======\n");
+}
+
+void TableReportSink::beginSection(ReportSection section) {
+    switch (section) {
+        case ReportSection::BUSBARS:
+            write("\nBUSBARS:\n");
+            writePadded("ID", 15);
+            writePadded("Status", 13);
+            writePadded("Connected Load", 15);
+            writePadded("Available Power", 20);
+            write('\n');
+            write(std::string(63, '-'));
+            break;
+        case ReportSection::TIES:
+            write("\nBUS TIES:\n");
+            writePadded("ID", 15);
+            writePadded("From", 15);
+            writePadded("To", 15);
+            writePadded("Status", 10);
+            writePadded("Limit", 15);
+            writePadded("Flow", 15);
+            write('\n');
+            write(std::string(85, '-'));
+            break;
+        case ReportSection::POWER_FLOW:
+            write("\nPOWER FLOW:\n");
+            writePadded("Tie", 15);
+            writePadded("From", 15);
+            writePadded("To", 15);
+            writePadded("Flow", 18);
+            writePadded("Limit", 18);
+            writePadded("Loading", 10);
+            writePadded("Status", 10);
+            write('\n');
+            write(std::string(101, '-'));
+            break;
+        case ReportSection::SOURCES:
+            write("\nPOWER SOURCES:\n");
+            writePadded("ID", 15);
+            writePadded("Status", 10);
+            writePadded("Capacity", 15);
+            writePadded("Current Load", 15);
+            writePadded("Available Capacity", 20);
+            write('\n');
+            write(std::string(75, '-'));
+            break;
+        case ReportSection::LOADS:
+            write("\nLOADS:\n");
+            writePadded("ID", 15);
+            writePadded("Type", 15);
+            writePadded("Priority", 15);
+            writePadded("Demand", 15);
+            writePadded("Connected", 10);
+            writePadded("Served", 10);
+            write('\n');
+            write(std::string(80, '-'));
+            break;
+    }
+    write('\n');
+}
+
+void TableReportSink::busbar(const BusbarReportRow& row) {
+    writePadded(row.id, 15);
+    writePadded(row.energized ? "Energized" : "De-energized", 13);
+    writePaddedNumber(row.connectedLoadKw, 15);
+    write(" kW");
+    writePaddedNumber(row.availablePowerKw, 20);
+    write(" kW\n");
+}
+
+void TableReportSink::tie(const TieReportRow& row) {
+    writePadded(row.id, 15);
+    writePadded(row.fromBusbarId, 15);
+    writePadded(row.toBusbarId, 15);
+    writePadded(row.closed ? "Closed" : "Open", 10);
+    writePaddedNumber(row.limitKw, 15);
+    write(" kW");
+    writePaddedNumber(row.flowKw, 15);
+    write(" kW\n");
+}
+
+void TableReportSink::powerFlow(const PowerFlowReportRow& row) {
+    writePadded(row.tieId, 15);
+    writePadded(row.fromBusbarId, 15);
+    writePadded(row.toBusbarId, 15);
+    writePaddedNumber(row.flowKw, 15);
+    write(" kW");
+    writePaddedNumber(row.limitKw, 15);
+    write(" kW");
+    char loading[32];
+    auto result = std::to_chars(loading, loading + sizeof(loading) - 1, row.loadingPercent,
+                                std::chars_format::fixed, 1);
+    *result.ptr++ = '%';
+    writePadded(std::string_view(loading, static_cast<std::size_t>(result.ptr - loading)), 10);
+    write(row.overloaded ? "OVERLOAD\n" : "OK\n");
+}
+
+void TableReportSink::source(const SourceReportRow& row) {
+    writePadded(row.id, 15);
+    writePadded(row.operational ? "Online" : "Offline", 10);
+    writePaddedNumber(row.capacityKw, 15);
+    write(" kW");
+    writePaddedNumber(row.currentLoadKw, 15);
+    write(" kW");
+    writePaddedNumber(row.availableKw, 20);
+    write(" kW\n");
+}
+
+void TableReportSink::load(const LoadReportRow& row) {
+    writePadded(row.id, 15);
+    writePadded(loadTypeDisplayName(row.type), 15);
+    writePadded(priorityDisplayName(row.priority), 15);
+    writePaddedNumber(row.demandKw, 15);
+    write(" kW");
+    writePadded(row.connected ? "Yes" : "No", 10);
+    writePadded(!row.served ? "No" : (row.servedKw < row.demandKw ? "Partial" : "Yes"), 10);
+    write('\n');
+}
+
+void TableReportSink::endReport(const ReportSummary& summary) {
+    write("\nSYSTEM STATISTICS:\n");
+    write("Total Supply Capacity: ");
+    writeDefaultNumber(summary.totalSupplyKw);
+    write(" kW\nTotal Connected Load: ");
+    writeDefaultNumber(summary.totalDemandKw);
+    write(" kW\nTotal Served Load: ");
+    writeDefaultNumber(summary.servedKw);
+    write(" kW\nTotal Shed Load: ");
+    writeDefaultNumber(summary.shedKw);
+    write(" kW\nSupply Utilization: ");
+    double supplyUtilization = 0.0;
+    if (summary.totalSupplyKw > 0.0) {
+        supplyUtilization = (summary.servedKw / summary.totalSupplyKw) * 100.0;
+    }
+    writeDefaultNumber(supplyUtilization);
+    write("%\n");
+
+    if (summary.totalDemandKw > 0.0) {
+        write("Service Level: ");
+        writeDefaultNumber((summary.servedKw / summary.totalDemandKw) * 100.0);
+        write("%\n");
+    } else {
+        write("Service Level: N/A (no demand)\n");
+    }
+
+    write("=================================\n\n");
+}
+
+void TableReportSink::shed(const ShedReportRow& row) {
+    write(row.busbarId.empty() ? "System-wide load shedding: " : "Load shedding: ");
+    write(row.loadId);
+    write(" (");
+    write(loadTypeDisplayName(row.type));
+    write(", ");
+    writeDefaultNumber(row.demandKw);
+    write(" kW) was shed.\n");
+}
+
+// CsvReportSink
+
+CsvReportSink::CsvReportSink(std::ostream& out, std::size_t bufferSize)
+    : ReportSink(out, bufferSize), headerWritten(false) {}
+
+void CsvReportSink::writeField(std::string_view text) {
+    write(',');
+    if (text.find_first_of(",\"\r\n") == std::string_view::npos) {
+        write(text);
+        return;
+    }
+    write('"');
+    for (char c : text) {
+        if (c == '"') {
+            write('"');
+        }
+        write(c);
+    }
+    write('"');
+}
+
+void CsvReportSink::beginRow(std::string_view record) {
+    if (!headerWritten) {
+        write("record,step,id,busbar,status,type,priority,capacity_kw,demand_kw,served_kw,available_kw\n");
+        headerWritten = true;
+    }
+    write(record);
+}
+
+void CsvReportSink::beginReport(std::string_view) {}
+
+void CsvReportSink::beginSection(ReportSection) {}
+
+void CsvReportSink::busbar(const BusbarReportRow& row) {
+    beginRow("busbar");
+    write(',');
+    writeField(row.id);
+    write(',');
+    writeField(row.energized ? "energized" : "de-energized");
+    write(",,,,");
+    writeNumber(row.connectedLoadKw);
+    write(",,");
+    writeNumber(row.availablePowerKw);
+    write('\n');
+}
+
+void CsvReportSink::tie(const TieReportRow& row) {
+    beginRow("tie");
+    write(',');
+    writeField(row.id);
+    std::string busbars(row.fromBusbarId);
+    busbars += '>';
+    busbars += row.toBusbarId;
+    writeField(busbars);
+    writeField(row.closed ? "closed" : "open");
+    write(",,,");
+    writeNumber(row.limitKw);
+    write(",,");
+    writeNumber(row.flowKw);
+    write(',');
+    writeNumber(row.limitKw - std::abs(row.flowKw));
+    write('\n');
+}
+
+void CsvReportSink::powerFlow(const PowerFlowReportRow& row) {
+    beginRow("flow");
+    write(',');
+    writeField(row.tieId);
+    std::string busbars(row.fromBusbarId);
+    busbars += '>';
+    busbars += row.toBusbarId;
+    writeField(busbars);
+    writeField(row.overloaded ? "overloaded" : "ok");
+    write(",,,");
+    writeNumber(row.limitKw);
+    write(",,");
+    writeNumber(row.flowKw);
+    write(',');
+    writeNumber(row.limitKw - std::abs(row.flowKw));
+    write('\n');
+}
+
+void CsvReportSink::source(const SourceReportRow& row) {
+    beginRow("source");
+    write(',');
+    writeField(row.id);
+    writeField(row.busbarId);
+    writeField(row.operational ? "online" : "offline");
+    write(",,,");
+    writeNumber(row.capacityKw);
+    write(",,");
+    writeNumber(row.currentLoadKw);
+    write(',');
+    writeNumber(row.availableKw);
+    write('\n');
+}
+
+void CsvReportSink::load(const LoadReportRow& row) {
+    beginRow("load");
+    write(',');
+    writeField(row.id);
+    writeField(row.busbarId);
+    writeField(!row.connected ? "disconnected"
+               : !row.served ? "shed"
+               : row.servedKw < row.demandKw ? "curtailed" : "served");
+    writeField(loadTypeName(row.type));
+    write(',');
+    writeInteger(static_cast<int>(row.priority));
+    write(",,");
+    writeNumber(row.demandKw);
+    write(',');
+    writeNumber(row.servedKw);
+    write(",\n");
+}
+
+void CsvReportSink::endReport(const ReportSummary& summary) {
+    beginRow("summary");
+    write(',');
+    writeField(summary.gridName);
+    write(",,,,,");
+    writeNumber(summary.totalSupplyKw);
+    write(',');
+    writeNumber(summary.totalDemandKw);
+    write(',');
+    writeNumber(summary.servedKw);
+    write(',');
+    writeNumber(summary.totalSupplyKw - summary.servedKw);
+    write('\n');
+}
+
+void CsvReportSink::shed(const ShedReportRow& row) {
+    beginRow("shed");
+    write(',');
+    writeInteger(row.step);
+    writeField(row.loadId);
+    writeField(row.busbarId);
+    write(",shed");
+    writeField(loadTypeName(row.type));
+    write(',');
+    writeInteger(static_cast<int>(row.priority));
+    write(",,");
+    writeNumber(row.demandKw);
+    write(",0,\n");
+}
+
+// JsonLinesReportSink
+
+void JsonLinesReportSink::writeString(std::string_view text) {
+    write('"');
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            write('\\');
+            write(c);
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char escape[8];
+            std::snprintf(escape, sizeof(escape), "\\u%04x", static_cast<unsigned>(c));
+            write(escape);
+        } else {
+            write(c);
+        }
+    }
+    write('"');
+}
+
+void JsonLinesReportSink::writeKey(std::string_view key) {
+    write(",\"");
+    write(key);
+    write("\":");
+}
+
+void JsonLinesReportSink::beginReport(std::string_view) {}
+
+void JsonLinesReportSink::beginSection(ReportSection) {}
+
+void JsonLinesReportSink::busbar(const BusbarReportRow& row) {
+    write("{\"record\":\"busbar\"");
+    writeKey("id");
+    writeString(row.id);
+    writeKey("energized");
+    write(row.energized ? "true" : "false");
+    writeKey("connected_load_kw");
+    writeNumber(row.connectedLoadKw);
+    writeKey("available_kw");
+    writeNumber(row.availablePowerKw);
+    write("}\n");
+}
+
+void JsonLinesReportSink::tie(const TieReportRow& row) {
+    write("{\"record\":\"tie\"");
+    writeKey("id");
+    writeString(row.id);
+    writeKey("from");
+    writeString(row.fromBusbarId);
+    writeKey("to");
+    writeString(row.toBusbarId);
+    writeKey("closed");
+    write(row.closed ? "true" : "false");
+    writeKey("limit_kw");
+    writeNumber(row.limitKw);
+    writeKey("flow_kw");
+    writeNumber(row.flowKw);
+    write("}\n");
+}
+
+void JsonLinesReportSink::powerFlow(const PowerFlowReportRow& row) {
+    write("{\"record\":\"power_flow\"");
+    writeKey("tie");
+    writeString(row.tieId);
+    writeKey("from");
+    writeString(row.fromBusbarId);
+    writeKey("to");
+    writeString(row.toBusbarId);
+    writeKey("flow_kw");
+    writeNumber(row.flowKw);
+    writeKey("limit_kw");
+    writeNumber(row.limitKw);
+    writeKey("loading_pct");
+    writeNumber(row.loadingPercent);
+    writeKey("overloaded");
+    write(row.overloaded ? "true" : "false");
+    write("}\n");
+}
+
+void JsonLinesReportSink::source(const SourceReportRow& row) {
+    write("{\"record\":\"source\"");
+    writeKey("id");
+    writeString(row.id);
+    writeKey("busbar");
+    writeString(row.busbarId);
+    writeKey("operational");
+    write(row.operational ? "true" : "false");
+    writeKey("capacity_kw");
+    writeNumber(row.capacityKw);
+    writeKey("load_kw");
+    writeNumber(row.currentLoadKw);
+    writeKey("available_kw");
+    writeNumber(row.availableKw);
+    write("}\n");
+}
+
+void JsonLinesReportSink::load(const LoadReportRow& row) {
+    write("{\"record\":\"load\"");
+    writeKey("id");
+    writeString(row.id);
+    writeKey("busbar");
+    writeString(row.busbarId);
+    writeKey("type");
+    writeString(loadTypeName(row.type));
+    writeKey("priority");
+    writeInteger(static_cast<int>(row.priority));
+    writeKey("demand_kw");
+    writeNumber(row.demandKw);
+    writeKey("connected");
+    write(row.connected ? "true" : "false");
+    writeKey("served");
+    write(row.served ? "true" : "false");
+    writeKey("served_kw");
+    writeNumber(row.servedKw);
+    write("}\n");
+}
+
+void JsonLinesReportSink::endReport(const ReportSummary& summary) {
+    write("{\"record\":\"summary\"");
+    writeKey("grid");
+    writeString(summary.gridName);
+    writeKey("supply_kw");
+    writeNumber(summary.totalSupplyKw);
+    writeKey("demand_kw");
+    writeNumber(summary.totalDemandKw);
+    writeKey("served_kw");
+    writeNumber(summary.servedKw);
+    writeKey("shed_kw");
+    writeNumber(summary.shedKw);
+    write("}\n");
+}
+
+void JsonLinesReportSink::shed(const ShedReportRow& row) {
+    write("{\"record\":\"shed\"");
+    writeKey("step");
+    writeInteger(row.step);
+    writeKey("id");
+    writeString(row.loadId);
+    writeKey("busbar");
+    if (row.busbarId.empty()) {
+        write("null");
+    } else {
+        writeString(row.busbarId);
+    }
+    writeKey("type");
+    writeString(loadTypeName(row.type));
+    writeKey("priority");
+    writeInteger(static_cast<int>(row.priority));
+    writeKey("demand_kw");
+    writeNumber(row.demandKw);
+    write("}\n");
+}
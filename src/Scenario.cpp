@@ -0,0 +1,273 @@
+// Scenario.cpp
+#include "../include/Scenario.h"
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+Scenario::Scenario() : gridName("Scenario Grid"), nextEvent(0) {}
+
+bool Scenario::loadFromFile(const std::string& path) {
+    std::ifstream file(path);
+    if (!file) {
+        lastError = "cannot open " + path;
+        return false;
+    }
+
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(file, line)) {
+        ++lineNumber;
+        if (!parseLine(line)) {
+            lastError = path + ":" + std::to_string(lineNumber) + ": " + lastError;
+            return false;
+        }
+    }
+
+    // Events at the same step keep their file order
+    std::stable_sort(events.begin(), events.end(),
+                     [](const Event& a, const Event& b) { return a.time < b.time; });
+    nextEvent = 0;
+    return true;
+}
+
+bool Scenario::parseLine(const std::string& line) {
+    std::istringstream fields(line);
+    std::string keyword;
+    if (!(fields >> keyword) || keyword[0] == '#') {
+        return true;
+    }
+
+    if (keyword == "grid") {
+        std::getline(fields >> std::ws, gridName);
+        return true;
+    }
+    if (keyword == "busbar") {
+        BusbarSpec spec;
+        if (fields >> spec.id) {
+            busbars.push_back(spec);
+            return true;
+        }
+    } else if (keyword == "tie") {
+        TieSpec spec;
+        if (fields >> spec.id >> spec.fromBusbarId >> spec.toBusbarId >> spec.limit) {
+            std::string option;
+            spec.closed = true;
+            spec.reactance = 1.0;
+            while (fields >> option) {
+                if (option == "open") {
+                    spec.closed = false;
+                } else if (option == "reactance") {
+                    if (!(fields >> spec.reactance) || !(spec.reactance > 0.0)) {
+                        lastError = "reactance of tie " + spec.id + " must be a positive number";
+                        return false;
+                    }
+                } else {
+                    lastError = "unknown tie option '" + option + "'";
+                    return false;
+                }
+            }
+            ties.push_back(spec);
+            return true;
+        }
+    } else if (keyword == "source") {
+        SourceSpec spec;
+        if (fields >> spec.id >> spec.capacity >> spec.busbarId) {
+            spec.minOutput = 0.0;
+            std::string option;
+            while (fields >> option) {
+                double value;
+                if (option != "min" && option != "cost") {
+                    lastError = "unknown source option '" + option + "'";
+                    return false;
+                }
+                if (!(fields >> value)) {
+                    lastError = "source option '" + option + "' needs a value";
+                    return false;
+                }
+                if (option == "min") {
+                    spec.minOutput = value;
+                } else {
+                    spec.costCurve = {{0.0, value}};
+                }
+            }
+            sources.push_back(spec);
+            return true;
+        }
+    } else if (keyword == "load") {
+        LoadSpec spec;
+        std::string type, priority;
+        if (fields >> spec.id >> spec.demand >> type >> priority >> spec.busbarId) {
+            if (!parseLoadType(type, spec.type)) {
+                lastError = "unknown load type '" + type + "'";
+                return false;
+            }
+            if (!parsePriority(priority, spec.priority)) {
+                lastError = "unknown priority '" + priority + "'";
+                return false;
+            }
+            std::string option;
+            spec.curtailable = false;
+            if (fields >> option) {
+                if (option != "curtailable") {
+                    lastError = "unknown load option '" + option + "'";
+                    return false;
+                }
+                spec.curtailable = true;
+            }
+            loads.push_back(spec);
+            return true;
+        }
+    } else if (keyword == "profile") {
+        std::string typeName;
+        LoadType type;
+        if (fields >> typeName) {
+            if (!parseLoadType(typeName, type)) {
+                lastError = "unknown load type '" + typeName + "'";
+                return false;
+            }
+            std::vector<double> curve;
+            double factor;
+            while (fields >> factor) {
+                curve.push_back(factor);
+            }
+            if (!curve.empty()) {
+                if (!profiles.empty() && profiles.begin()->second.size() != curve.size()) {
+                    lastError = "profile length differs from earlier profiles";
+                    return false;
+                }
+                profiles[type] = curve;
+                return true;
+            }
+        }
+    } else if (keyword == "scale") {
+        std::string loadId;
+        double factor;
+        if (fields >> loadId >> factor) {
+            profileScales[loadId] = factor;
+            return true;
+        }
+    } else if (keyword == "curve") {
+        std::string sourceId;
+        if (fields >> sourceId) {
+            std::vector<double> values;
+            double value;
+            while (fields >> value) {
+                values.push_back(value);
+            }
+            if (!values.empty() && values.size() % 2 == 0) {
+                std::vector<CostSegment> curve;
+                for (std::size_t i = 0; i < values.size(); i += 2) {
+                    curve.push_back({values[i], values[i + 1]});
+                }
+                if (!isConvexCostCurve(curve)) {
+                    lastError = "cost curve of " + sourceId + " must rise in kW and never fall in cost";
+                    return false;
+                }
+                costCurves[sourceId] = curve;
+                return true;
+            }
+        }
+    } else if (keyword == "at") {
+        Event event;
+        std::string action;
+        event.value = 0.0;
+        if (fields >> event.time >> action >> event.targetId) {
+            if (action == "demand" || action == "capacity") {
+                if (!(fields >> event.value)) {
+                    lastError = "missing kW value";
+                    return false;
+                }
+                event.type = (action == "demand") ? EventType::SET_DEMAND : EventType::SET_CAPACITY;
+            } else if (action == "trip") {
+                event.type = EventType::TRIP_SOURCE;
+            } else if (action == "restore") {
+                event.type = EventType::RESTORE_SOURCE;
+            } else if (action == "connect") {
+                event.type = EventType::CONNECT_LOAD;
+            } else if (action == "disconnect") {
+                event.type = EventType::DISCONNECT_LOAD;
+            } else if (action == "open") {
+                event.type = EventType::OPEN_TIE;
+            } else if (action == "close") {
+                event.type = EventType::CLOSE_TIE;
+            } else {
+                lastError = "unknown event '" + action + "'";
+                return false;
+            }
+            events.push_back(event);
+            return true;
+        }
+    } else {
+        lastError = "unknown record '" + keyword + "'";
+        return false;
+    }
+
+    lastError = "malformed '" + keyword + "' record";
+    return false;
+}
+
+const std::string& Scenario::getLastError() const {
+    return lastError;
+}
+
+std::string Scenario::getGridName() const {
+    return gridName;
+}
+
+std::size_t Scenario::getEventCount() const {
+    return events.size();
+}
+
+void Scenario::buildGrid(Grid& grid) const {
+    for (const auto& spec : busbars) {
+        grid.addBusbar(grid.createBusbar(spec.id));
+    }
+    for (const auto& spec : ties) {
+        grid.addTie(spec.id, spec.fromBusbarId, spec.toBusbarId, spec.limit, spec.closed, spec.reactance);
+    }
+    for (const auto& spec : sources) {
+        auto source = grid.createSource(spec.id, spec.capacity);
+        source->setMinOutput(spec.minOutput);
+        auto curve = costCurves.find(spec.id);
+        source->setCostCurve(curve != costCurves.end() ? curve->second : spec.costCurve);
+        grid.addSource(source, spec.busbarId);
+    }
+    for (const auto& spec : loads) {
+        auto load = grid.createLoad(spec.id, spec.demand, spec.type, spec.priority);
+        auto scale = profileScales.find(spec.id);
+        if (scale != profileScales.end()) {
+            load->setProfileScale(scale->second);
+        }
+        load->setCurtailable(spec.curtailable);
+        grid.addLoad(load, spec.busbarId);
+    }
+    
+    if (!profiles.empty()) {
+        auto loadProfiles = std::make_shared<LoadProfiles>(profiles.begin()->second.size());
+        for (const auto& profile : profiles) {
+            loadProfiles->setCurve(profile.first, profile.second);
+        }
+        grid.setLoadProfiles(loadProfiles);
+    }
+}
+
+int Scenario::applyEvents(Grid& grid, int step) {
+    int applied = 0;
+    while (nextEvent < events.size() && events[nextEvent].time <= step) {
+        // Unknown targets are skipped
+        if (events[nextEvent++].apply(grid)) {
+            ++applied;
+        }
+    }
+    return applied;
+}
+
+void Scenario::rewind() {
+    nextEvent = 0;
+}
+
+void Scenario::scheduleEvents(EventQueue& queue) const {
+    for (const Event& event : events) {
+        queue.schedule(event);
+    }
+}
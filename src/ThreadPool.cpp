@@ -0,0 +1,125 @@
+// ThreadPool.cpp
+#include "../include/ThreadPool.h"
+#include <algorithm>
+
+ThreadPool::ThreadPool(std::size_t threadCount)
+    : job(nullptr), generation(0), remaining(0), stopping(false) {
+    if (threadCount == 0) {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+    
+    for (std::size_t i = 0; i < threadCount; ++i) {
+        queues.push_back(std::make_unique<WorkQueue>());
+    }
+    for (std::size_t i = 1; i < threadCount; ++i) {
+        workers.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        stopping = true;
+    }
+    workAvailable.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+std::size_t ThreadPool::getThreadCount() const {
+    return queues.size();
+}
+
+bool ThreadPool::takeRange(std::size_t self, Range& range) {
+    // Own queue first, newest range first for cache locality
+    {
+        WorkQueue& own = *queues[self];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.ranges.empty()) {
+            range = own.ranges.back();
+            own.ranges.pop_back();
+            return true;
+        }
+    }
+    
+    // Then steal the oldest range from the others
+    for (std::size_t offset = 1; offset < queues.size(); ++offset) {
+        WorkQueue& victim = *queues[(self + offset) % queues.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.ranges.empty()) {
+            range = victim.ranges.front();
+            victim.ranges.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ThreadPool::runOneRange(std::size_t self) {
+    Range range;
+    if (!takeRange(self, range)) {
+        return false;
+    }
+    
+    const auto& body = *job;
+    for (std::size_t i = range.first; i < range.second; ++i) {
+        body(i);
+    }
+    
+    if (remaining.fetch_sub(range.second - range.first) == range.second - range.first) {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        workFinished.notify_all();
+    }
+    return true;
+}
+
+void ThreadPool::workerLoop(std::size_t self) {
+    std::size_t seenGeneration = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(stateMutex);
+            workAvailable.wait(lock, [&]() { return stopping || generation != seenGeneration; });
+            if (stopping) return;
+            seenGeneration = generation;
+        }
+        
+        while (runOneRange(self)) {}
+    }
+}
+
+void ThreadPool::parallelFor(std::size_t count, const std::function<void(std::size_t)>& body) {
+    if (count == 0) return;
+    if (queues.size() == 1 || count == 1) {
+        for (std::size_t i = 0; i < count; ++i) {
+            body(i);
+        }
+        return;
+    }
+    
+    // Several small ranges per participant leave something to steal
+    std::size_t grain = std::max<std::size_t>(1, count / (queues.size() * 8));
+    
+    job = &body;
+    remaining.store(count);
+    std::size_t queueIndex = 0;
+    for (std::size_t begin = 0; begin < count; begin += grain) {
+        WorkQueue& queue = *queues[queueIndex];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.ranges.emplace_back(begin, std::min(count, begin + grain));
+        queueIndex = (queueIndex + 1) % queues.size();
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        ++generation;
+    }
+    workAvailable.notify_all();
+    
+    // The calling thread works too, then waits for stragglers
+    while (runOneRange(0)) {}
+    
+    std::unique_lock<std::mutex> lock(stateMutex);
+    workFinished.wait(lock, [&]() { return remaining.load() == 0; });
+    job = nullptr;
+}
@@ -0,0 +1,360 @@
+// Topology.cpp
+#include "../include/Topology.h"
+#include <algorithm>
+#include <limits>
+
+namespace {
+
+constexpr std::size_t PRIORITY_LIMIT = static_cast<std::size_t>(Priority::MINIMAL) + 1;
+
+} // namespace
+
+Topology::Topology() : closedTies(0), structureValid(false), revision(0), visitStamp(0) {}
+
+bool Topology::addTie(const std::string& id, Handle from, Handle to, double limitKw, bool closed,
+                      double reactance) {
+    if (from == to || tieIndex.count(id) || !(reactance > 0.0)) {
+        return false;
+    }
+    tieIndex[id] = ties.size();
+    ties.push_back({id, from, to, limitKw, closed, 0.0, reactance, 0.0});
+    if (closed) {
+        ++closedTies;
+    }
+    structureValid = false;
+    ++revision;
+    return true;
+}
+
+bool Topology::removeTie(const std::string& id) {
+    auto found = tieIndex.find(id);
+    if (found == tieIndex.end()) {
+        return false;
+    }
+    std::size_t slot = found->second;
+    tieIndex.erase(found);
+    if (ties[slot].closed) {
+        --closedTies;
+    }
+
+    // The last tie takes the freed slot
+    if (slot + 1 != ties.size()) {
+        ties[slot] = std::move(ties.back());
+        tieIndex[ties[slot].id] = slot;
+    }
+    ties.pop_back();
+    structureValid = false;
+    ++revision;
+    return true;
+}
+
+bool Topology::setClosed(const std::string& id, bool closed) {
+    auto found = tieIndex.find(id);
+    if (found == tieIndex.end()) {
+        return false;
+    }
+    Tie& tie = ties[found->second];
+    if (tie.closed != closed) {
+        tie.closed = closed;
+        tie.flowKw = 0.0;
+        tie.powerFlowKw = 0.0;
+        if (closed) {
+            ++closedTies;
+        } else {
+            --closedTies;
+        }
+        structureValid = false;
+        ++revision;
+    }
+    return true;
+}
+
+bool Topology::setLimit(const std::string& id, double limitKw) {
+    auto found = tieIndex.find(id);
+    if (found == tieIndex.end()) {
+        return false;
+    }
+    ties[found->second].limitKw = limitKw;
+    return true;
+}
+
+bool Topology::setFlow(const std::string& id, double flowKw) {
+    auto found = tieIndex.find(id);
+    if (found == tieIndex.end()) {
+        return false;
+    }
+    ties[found->second].flowKw = flowKw;
+    return true;
+}
+
+std::vector<Topology::Handle> Topology::removeBusbar(Handle busbar) {
+    std::vector<Handle> neighbours;
+    for (std::size_t i = ties.size(); i > 0; --i) {
+        const Tie& tie = ties[i - 1];
+        if (tie.from == busbar || tie.to == busbar) {
+            neighbours.push_back(tie.from == busbar ? tie.to : tie.from);
+            removeTie(std::string(tie.id));
+        }
+    }
+    return neighbours;
+}
+
+const Topology::Tie* Topology::findTie(const std::string& id) const {
+    auto found = tieIndex.find(id);
+    return found == tieIndex.end() ? nullptr : &ties[found->second];
+}
+
+const std::vector<Topology::Tie>& Topology::getTies() const {
+    return ties;
+}
+
+bool Topology::hasClosedTies() const {
+    return closedTies > 0;
+}
+
+std::uint64_t Topology::getRevision() const {
+    return revision;
+}
+
+void Topology::clearFlows() {
+    for (Tie& tie : ties) {
+        tie.flowKw = 0.0;
+    }
+}
+
+void Topology::setPowerFlows(const std::vector<double>& flows) {
+    for (std::size_t i = 0; i < ties.size() && i < flows.size(); ++i) {
+        ties[i].powerFlowKw = flows[i];
+    }
+}
+
+void Topology::rebuild(std::size_t busbarSlots) {
+    // Compressed adjacency of the closed ties
+    adjacencyStart.assign(busbarSlots + 1, 0);
+    for (const Tie& tie : ties) {
+        if (tie.closed) {
+            ++adjacencyStart[tie.from + 1];
+            ++adjacencyStart[tie.to + 1];
+        }
+    }
+    for (std::size_t busbar = 0; busbar < busbarSlots; ++busbar) {
+        adjacencyStart[busbar + 1] += adjacencyStart[busbar];
+    }
+    adjacency.resize(adjacencyStart[busbarSlots]);
+    std::vector<std::size_t> next(adjacencyStart.begin(), adjacencyStart.end() - 1);
+    for (std::size_t i = 0; i < ties.size(); ++i) {
+        if (ties[i].closed) {
+            adjacency[next[ties[i].from]++] = i;
+            adjacency[next[ties[i].to]++] = i;
+        }
+    }
+
+    // Tie-connected groups, found breadth-first from the lowest handle
+    componentOf.assign(busbarSlots, NONE);
+    componentStart.clear();
+    componentMembers.clear();
+    for (Handle root = 0; root < busbarSlots; ++root) {
+        if (componentOf[root] != NONE || adjacencyStart[root] == adjacencyStart[root + 1]) {
+            continue;
+        }
+        std::size_t component = componentStart.size();
+        std::size_t first = componentMembers.size();
+        componentStart.push_back(first);
+        componentOf[root] = component;
+        componentMembers.push_back(root);
+        for (std::size_t head = first; head < componentMembers.size(); ++head) {
+            Handle busbar = componentMembers[head];
+            for (std::size_t k = adjacencyStart[busbar]; k < adjacencyStart[busbar + 1]; ++k) {
+                const Tie& tie = ties[adjacency[k]];
+                Handle neighbour = tie.from == busbar ? tie.to : tie.from;
+                if (componentOf[neighbour] == NONE) {
+                    componentOf[neighbour] = component;
+                    componentMembers.push_back(neighbour);
+                }
+            }
+        }
+        std::sort(componentMembers.begin() + first, componentMembers.end());
+    }
+    componentStart.push_back(componentMembers.size());
+
+    visited.assign(busbarSlots, 0);
+    visitStamp = 0;
+    parentTie.assign(busbarSlots, NONE);
+    maxHeadroom.assign(busbarSlots, 0.0);
+    componentSeen.assign(componentStart.size() - 1, 0);
+    structureValid = true;
+}
+
+void Topology::refresh(const GridState& state) {
+    // Busbars added since the last rebuild need their slots sized too
+    if (!structureValid || adjacencyStart.size() != state.busbarSlotCount() + 1) {
+        rebuild(state.busbarSlotCount());
+    }
+}
+
+double Topology::headroomOf(const GridState& state, Handle busbar) const {
+    double best = -std::numeric_limits<double>::infinity();
+    for (Handle source : state.busbarSources[busbar]) {
+        if (state.sourceOperational[source]) {
+            best = std::max(best, state.sourceCapacity[source] - state.sourceCurrentLoad[source]);
+        }
+    }
+    return best;
+}
+
+bool Topology::canCarry(const Tie& tie, Handle towards, double kw) const {
+    double flowTowards = tie.to == towards ? tie.flowKw : -tie.flowKw;
+    return flowTowards + kw <= tie.limitKw;
+}
+
+void Topology::expandDirty(GridState& state) {
+    if (!hasClosedTies()) {
+        return;
+    }
+    refresh(state);
+
+    // Marking appends to the dirty list, so only the original entries are walked
+    const auto& dirty = state.getDirtyBusbars();
+    std::size_t count = dirty.size();
+    pendingComponents.clear();
+    for (std::size_t i = 0; i < count; ++i) {
+        std::size_t component = componentOf[dirty[i]];
+        if (component == NONE || componentSeen[component]) {
+            continue;
+        }
+        componentSeen[component] = 1;
+        pendingComponents.push_back(component);
+        for (std::size_t m = componentStart[component]; m < componentStart[component + 1]; ++m) {
+            state.markBusbarDirty(componentMembers[m]);
+        }
+    }
+    for (std::size_t component : pendingComponents) {
+        componentSeen[component] = 0;
+    }
+}
+
+std::size_t Topology::transfer(GridState& state, const std::vector<Handle>& solved) {
+    if (!hasClosedTies()) {
+        return 0;
+    }
+    refresh(state);
+
+    pendingComponents.clear();
+    for (Handle busbar : solved) {
+        std::size_t component = componentOf[busbar];
+        if (component != NONE && !componentSeen[component]) {
+            componentSeen[component] = 1;
+            pendingComponents.push_back(component);
+        }
+    }
+
+    std::size_t transferred = 0;
+    for (std::size_t component : pendingComponents) {
+        transferred += transferComponent(state, component);
+        componentSeen[component] = 0;
+    }
+    return transferred;
+}
+
+std::size_t Topology::transferComponent(GridState& state, std::size_t component) {
+    auto first = componentMembers.begin() + componentStart[component];
+    auto last = componentMembers.begin() + componentStart[component + 1];
+
+    // Every member was just solved on its own, so flows start from zero
+    double componentMax = -std::numeric_limits<double>::infinity();
+    for (auto member = first; member != last; ++member) {
+        for (std::size_t k = adjacencyStart[*member]; k < adjacencyStart[*member + 1]; ++k) {
+            ties[adjacency[k]].flowKw = 0.0;
+        }
+        maxHeadroom[*member] = headroomOf(state, *member);
+        componentMax = std::max(componentMax, maxHeadroom[*member]);
+    }
+
+    // Unserved loads of the whole group by priority; within a priority in
+    // busbar handle order, then each busbar's dispatch order. A counting
+    // pass keeps that order without sorting.
+    std::size_t tierStart[PRIORITY_LIMIT + 1] = {};
+    candidates.clear();
+    for (auto member = first; member != last; ++member) {
+        for (Handle load : state.busbarLoads[*member]) {
+            if (state.loadConnected[load] && !state.loadServed[load]) {
+                candidates.push_back(load);
+                ++tierStart[state.loadPriority[load] + 1];
+            }
+        }
+    }
+    for (std::size_t priority = 1; priority <= PRIORITY_LIMIT; ++priority) {
+        tierStart[priority] += tierStart[priority - 1];
+    }
+    ordered.resize(candidates.size());
+    for (Handle load : candidates) {
+        ordered[tierStart[state.loadPriority[load]]++] = load;
+    }
+
+    std::size_t transferred = 0;
+    for (Handle load : ordered) {
+        // No busbar of the group has a source with room for it
+        if (state.loadDemand[load] > componentMax) {
+            continue;
+        }
+        Handle supplier = route(state, load);
+        if (supplier == GridState::INVALID_HANDLE) {
+            continue;
+        }
+        ++transferred;
+        double previous = maxHeadroom[supplier];
+        maxHeadroom[supplier] = headroomOf(state, supplier);
+        if (previous >= componentMax) {
+            componentMax = -std::numeric_limits<double>::infinity();
+            for (auto member = first; member != last; ++member) {
+                componentMax = std::max(componentMax, maxHeadroom[*member]);
+            }
+        }
+    }
+    return transferred;
+}
+
+Topology::Handle Topology::route(GridState& state, Handle load) {
+    if (++visitStamp == 0) {
+        std::fill(visited.begin(), visited.end(), 0);
+        visitStamp = 1;
+    }
+
+    Handle start = state.loadBusbar[load];
+    double demand = state.loadDemand[load];
+    visited[start] = visitStamp;
+    queue.clear();
+    queue.push_back(start);
+
+    // Breadth-first over ties with room to carry the whole load towards it;
+    // the load's own busbar already had no source for it
+    for (std::size_t head = 0; head < queue.size(); ++head) {
+        Handle busbar = queue[head];
+        for (std::size_t k = adjacencyStart[busbar]; k < adjacencyStart[busbar + 1]; ++k) {
+            const Tie& tie = ties[adjacency[k]];
+            Handle neighbour = tie.from == busbar ? tie.to : tie.from;
+            if (visited[neighbour] == visitStamp || !canCarry(tie, busbar, demand)) {
+                continue;
+            }
+            visited[neighbour] = visitStamp;
+            parentTie[neighbour] = adjacency[k];
+
+            if (maxHeadroom[neighbour] >= demand && state.serveFromBusbar(load, neighbour)) {
+                // Push the load's power along the path back to its busbar
+                for (Handle at = neighbour; at != start;) {
+                    Tie& used = ties[parentTie[at]];
+                    if (used.from == at) {
+                        used.flowKw += demand;
+                        at = used.to;
+                    } else {
+                        used.flowKw -= demand;
+                        at = used.from;
+                    }
+                }
+                return neighbour;
+            }
+            queue.push_back(neighbour);
+        }
+    }
+    return GridState::INVALID_HANDLE;
+}
@@ -1,15 +1,178 @@
 // main.cpp
 #include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <limits>
 #include "../include/Simulator.h"
+#include "../include/AllocationStrategy.h"
+#include "../include/Instrumentation.h"
 
-int main() {
+namespace {
+
+void printUsage(const char* program) {
+    std::cout << "Usage:\n";
+    std::cout << "  " << program << "                       Interactive simulator\n";
+    std::cout << "  " << program << " --scenario <file> [--steps <n>] [--output <file>] [--threads <n>]\n";
+    std::cout << "                                  Headless batch run, writes per-step CSV\n";
+    std::cout << "                                  (--threads 0 dispatches on every core)\n";
+    std::cout << "                                  [--allocation first-fit|best-fit|branch-and-bound[:<us>]|knapsack[:<us>]]\n";
+    std::cout << "                                  [--curtailment] serve curtailable loads in part rather\n";
+    std::cout << "                                  than shed them (not with --allocation)\n";
+    std::cout << "                                  [--economic-dispatch] run sources at least cost along\n";
+    std::cout << "                                  their cost curves, adding a cost_per_h CSV column\n";
+    std::cout << "                                  [--power-flow] DC power flow over the bus ties after each\n";
+    std::cout << "                                  dispatch, adding tie overload CSV columns\n";
+    std::cout << "                                  [--report <file>] shed loads per step and a final grid\n";
+    std::cout << "                                  report, as CSV (.csv), JSON lines (.jsonl) or a table\n";
+    std::cout << "                                  [--event-driven] re-dispatch only at steps with events,\n";
+    std::cout << "                                  writing CSV rows for those steps only\n";
+    std::cout << "  " << program << " --scenario <file> --contingency <k> [--samples <n>] [--output <file>] [--threads <n>]\n";
+    std::cout << "                                  N-k source outage study, writes per-case CSV\n";
+    std::cout << "                                  (--samples draws random outage sets instead of all)\n";
+    std::cout << "  " << program << " --scenario <file> --save-snapshot <file>\n";
+    std::cout << "                                  Saves the dispatched grid as a binary snapshot, which\n";
+    std::cout << "                                  --scenario also accepts (the snapshot has no events)\n";
+    std::cout << "  Any mode above also takes --import <file> (repeatable) to add loads and sources\n";
+    std::cout << "  from CSV or JSON-lines asset exports; --scenario may then be left out.\n";
+    std::cout << "  --timings prints dispatch phase histograms and counters to stderr on exit\n";
+    std::cout << "  (needs a build configured with -DENABLE_INSTRUMENTATION=ON).\n";
+}
+
+// Reads a whole, non-negative count of at most 'limit'; false (with a
+// message) for anything else, so a typo is reported rather than thrown
+bool parseCount(const std::string& option, const char* text, long long limit, long long& value) {
+    char* end = nullptr;
+    errno = 0;
+    long long parsed = std::strtoll(text, &end, 10);
+    if (end == text || *end != '\0' || errno == ERANGE || parsed < 0 || parsed > limit) {
+        std::cerr << "Error: " << option << " needs a whole number from 0 to " << limit 
+                  << ", not '" << text << "'\n";
+        return false;
+    }
+    value = parsed;
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::string scenarioPath;
+    std::string outputPath = "results.csv";
+    long long steps = 1;
+    long long threads = 1;
+    long long contingency = 0;
+    long long samples = 0;
+    const long long intLimit = std::numeric_limits<int>::max();
+    std::string allocation;
+    std::string snapshotPath;
+    std::vector<std::string> importPaths;
+    std::string reportPath;
+    bool eventDriven = false;
+    bool curtailment = false;
+    bool economicDispatch = false;
+    bool powerFlow = false;
+    bool timings = false;
+    
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--scenario" && i + 1 < argc) {
+            scenarioPath = argv[++i];
+        } else if (arg == "--steps" && i + 1 < argc) {
+            if (!parseCount(arg, argv[++i], intLimit, steps)) {
+                printUsage(argv[0]);
+                return 1;
+            }
+        } else if (arg == "--output" && i + 1 < argc) {
+            outputPath = argv[++i];
+        } else if (arg == "--threads" && i + 1 < argc) {
+            if (!parseCount(arg, argv[++i], intLimit, threads)) {
+                printUsage(argv[0]);
+                return 1;
+            }
+        } else if (arg == "--contingency" && i + 1 < argc) {
+            if (!parseCount(arg, argv[++i], intLimit, contingency)) {
+                printUsage(argv[0]);
+                return 1;
+            }
+        } else if (arg == "--samples" && i + 1 < argc) {
+            if (!parseCount(arg, argv[++i], std::numeric_limits<long long>::max(), samples)) {
+                printUsage(argv[0]);
+                return 1;
+            }
+        } else if (arg == "--allocation" && i + 1 < argc) {
+            allocation = argv[++i];
+        } else if (arg == "--save-snapshot" && i + 1 < argc) {
+            snapshotPath = argv[++i];
+        } else if (arg == "--import" && i + 1 < argc) {
+            importPaths.push_back(argv[++i]);
+        } else if (arg == "--report" && i + 1 < argc) {
+            reportPath = argv[++i];
+        } else if (arg == "--curtailment") {
+            curtailment = true;
+        } else if (arg == "--economic-dispatch") {
+            economicDispatch = true;
+        } else if (arg == "--power-flow") {
+            powerFlow = true;
+        } else if (arg == "--event-driven") {
+            eventDriven = true;
+        } else if (arg == "--timings") {
+            timings = true;
+        } else {
+            printUsage(argv[0]);
+            return (arg == "--help" || arg == "-h") ? 0 : 1;
+        }
+    }
+    
+    Simulator simulator;
+    if (!scenarioPath.empty() || !importPaths.empty()) {
+        simulator.setImportFiles(importPaths);
+        simulator.setReportFile(reportPath);
+        simulator.setEventDriven(eventDriven);
+        simulator.setDispatchThreads(static_cast<std::size_t>(threads));
+        if (curtailment && !allocation.empty()) {
+            // Curtailment replaces the packing strategy, which would never run
+            std::cerr << "Error: --curtailment cannot be combined with --allocation\n";
+            return 1;
+        }
+        if (!allocation.empty()) {
+            auto strategy = AllocationStrategy::create(allocation);
+            if (!strategy) {
+                std::cerr << "Error: unknown allocation strategy " << allocation << "\n";
+                return 1;
+            }
+            simulator.setAllocationStrategy(strategy);
+        }
+        simulator.setCurtailment(curtailment);
+        simulator.setEconomicDispatch(economicDispatch);
+        simulator.setPowerFlow(powerFlow);
+        int status;
+        if (!snapshotPath.empty()) {
+            status = simulator.saveSnapshot(scenarioPath, snapshotPath);
+        } else if (contingency > 0) {
+            status = simulator.runContingencyAnalysis(scenarioPath, static_cast<std::size_t>(contingency),
+                                                      static_cast<std::size_t>(samples),
+                                                      outputPath);
+        } else {
+            status = simulator.runBatchSimulation(scenarioPath, static_cast<int>(steps), outputPath);
+        }
+        if (timings) {
+            instrumentation::writeReport(std::cerr);
+        }
+        return status;
+    }
+    
     std::cout << "==================================\n";
     std::cout << "Power Distribution & Load Management Simulator\n";
     std::cout << "Demo Version\n";
     std::cout << "==================================\n\n";
     
-    Simulator simulator;
     simulator.runInteractiveSimulation();
+    if (timings) {
+        instrumentation::writeReport(std::cerr);
+    }
     
     return 0;
-}
+}
\ No newline at end of file
@@ -0,0 +1,178 @@
+// AllocationStrategyTest.cpp
+//
+// Strategy names come straight from the command line, so malformed ones
+// must be refused rather than throw. The knapsack strategy must serve more
+// weighted demand than first-fit where it can, never at the expense of
+// CRITICAL loads, and stay feasible when its time budget runs out.
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+#include "../include/AllocationStrategy.h"
+#include "TestHarness.h"
+
+GRID_TEST(AllocationStrategy, CreatesKnownNames) {
+    for (const char* name : {"first-fit", "best-fit", "branch-and-bound", "branch-and-bound:250",
+                             "branch-and-bound:0", "knapsack", "knapsack:1.5", "knapsack:1e3"}) {
+        CHECK(AllocationStrategy::create(name) != nullptr);
+    }
+}
+
+GRID_TEST(AllocationStrategy, RefusesMalformedBudgets) {
+    for (const char* name : {"branch-and-bound:", "branch-and-bound:abc", "branch-and-bound:12us",
+                             "branch-and-bound:-5", "branch-and-bound:inf", "branch-and-bound:nan",
+                             "branch-and-bound:1e999", "branch-and-bound5", "knapsack:", "knapsack:x",
+                             "knapsack:-1", "knapsack:10 ", "first-fit:10", "unknown", ""}) {
+        CHECK(AllocationStrategy::create(name) == nullptr);
+    }
+}
+
+namespace {
+
+constexpr std::uint8_t CRITICAL = 1;
+constexpr std::uint8_t LOW = 4;
+
+// Every load on a real source, and no source past its capacity
+bool isFeasible(const AllocationProblem& problem, const std::vector<std::size_t>& assignment) {
+    if (assignment.size() != problem.demands.size()) return false;
+    std::vector<double> used(problem.capacities.size(), 0.0);
+    for (std::size_t i = 0; i < assignment.size(); ++i) {
+        if (assignment[i] == AllocationStrategy::UNSERVED) continue;
+        if (assignment[i] >= used.size()) return false;
+        used[assignment[i]] += problem.demands[i];
+    }
+    for (std::size_t j = 0; j < used.size(); ++j) {
+        if (used[j] > problem.capacities[j] + 1e-9) return false;
+    }
+    return true;
+}
+
+// Priority-weighted kW served, CRITICAL loads left out
+double weightedServed(const KnapsackStrategy& strategy, const AllocationProblem& problem,
+                      const std::vector<std::size_t>& assignment) {
+    double value = 0.0;
+    for (std::size_t i = 0; i < assignment.size(); ++i) {
+        if (assignment[i] != AllocationStrategy::UNSERVED && problem.priorities[i] != CRITICAL) {
+            value += strategy.getPriorityWeight(problem.priorities[i]) * problem.demands[i];
+        }
+    }
+    return value;
+}
+
+// No shed load would fit in the headroom the packing leaves
+bool isMaximal(const AllocationProblem& problem, const std::vector<std::size_t>& assignment) {
+    std::vector<double> headroom = problem.capacities;
+    for (std::size_t i = 0; i < assignment.size(); ++i) {
+        if (assignment[i] != AllocationStrategy::UNSERVED) headroom[assignment[i]] -= problem.demands[i];
+    }
+    for (std::size_t i = 0; i < assignment.size(); ++i) {
+        if (assignment[i] != AllocationStrategy::UNSERVED) continue;
+        for (double left : headroom) {
+            if (problem.demands[i] <= left) return false;
+        }
+    }
+    return true;
+}
+
+// Loads in priority order, as dispatch lists them, with sizes spread out so
+// that no greedy order packs them exactly, on sources with room for about
+// 60% of the demand
+AllocationProblem mixedProblem(std::size_t loads, std::size_t sources) {
+    AllocationProblem problem;
+    double total = 0.0;
+    for (std::size_t i = 0; i < loads; ++i) {
+        problem.demands.push_back(5.0 + static_cast<double>((i * 37) % 53));
+        problem.priorities.push_back(static_cast<std::uint8_t>(1 + i * 5 / loads));
+        total += problem.demands.back();
+    }
+    for (std::size_t j = 0; j < sources; ++j) {
+        problem.capacities.push_back(0.6 * total / static_cast<double>(sources) + 7.0 * static_cast<double>(j));
+    }
+    return problem;
+}
+
+// kW served to the problem's leading CRITICAL loads
+double criticalServed(const AllocationProblem& problem, const std::vector<std::size_t>& assignment) {
+    double served = 0.0;
+    for (std::size_t i = 0; i < assignment.size() && problem.priorities[i] == CRITICAL; ++i) {
+        if (assignment[i] != AllocationStrategy::UNSERVED) served += problem.demands[i];
+    }
+    return served;
+}
+
+// What the better greedy packing of the CRITICAL loads alone serves
+double greedyCriticalServed(const AllocationProblem& problem) {
+    AllocationProblem critical = problem;
+    std::size_t count = 0;
+    while (count < problem.priorities.size() && problem.priorities[count] == CRITICAL) ++count;
+    critical.demands.resize(count);
+    critical.priorities.resize(count);
+    std::vector<std::size_t> firstFit;
+    std::vector<std::size_t> bestFit;
+    FirstFitStrategy().allocate(critical, firstFit);
+    BestFitDecreasingStrategy().allocate(critical, bestFit);
+    return std::max(criticalServed(critical, firstFit), criticalServed(critical, bestFit));
+}
+
+} // namespace
+
+GRID_TEST(AllocationStrategy, KnapsackServesSmallLoadsALargeOneBlocks) {
+    // First-fit puts the 60 kW load on first and then has room for one 25
+    AllocationProblem problem{{60.0, 25.0, 25.0, 25.0, 25.0}, {LOW, LOW, LOW, LOW, LOW}, {100.0}};
+    KnapsackStrategy knapsack;
+    FirstFitStrategy firstFit;
+    std::vector<std::size_t> packed;
+    std::vector<std::size_t> firstFitPacked;
+    knapsack.allocate(problem, packed);
+    firstFit.allocate(problem, firstFitPacked);
+    REQUIRE(isFeasible(problem, packed));
+    CHECK_EQ(packed[0], AllocationStrategy::UNSERVED);
+    CHECK_EQ(weightedServed(knapsack, problem, packed), 200.0);
+    CHECK(weightedServed(knapsack, problem, packed) > weightedServed(knapsack, problem, firstFitPacked));
+}
+
+GRID_TEST(AllocationStrategy, KnapsackNeverShedsCriticalLoads) {
+    // The HIGH loads alone would fill both sources exactly, and are weighted
+    // far above anything else
+    AllocationProblem problem{{40.0, 45.0, 10.0, 10.0, 10.0, 10.0, 10.0, 10.0, 10.0, 10.0, 10.0, 10.0},
+                              {CRITICAL, CRITICAL, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2},
+                              {50.0, 50.0}};
+    KnapsackStrategy knapsack;
+    CHECK(!knapsack.setPriorityWeight(CRITICAL, 1.0));
+    REQUIRE(knapsack.setPriorityWeight(2, 1e6));
+    std::vector<std::size_t> packed;
+    knapsack.allocate(problem, packed);
+    REQUIRE(isFeasible(problem, packed));
+    CHECK(packed[0] != AllocationStrategy::UNSERVED);
+    CHECK(packed[1] != AllocationStrategy::UNSERVED);
+    CHECK_EQ(weightedServed(knapsack, problem, packed), 1e7);
+
+    // On tighter sources too, the CRITICAL loads keep their greedy packing
+    for (std::size_t sources : {1, 3, 6}) {
+        AllocationProblem mixed = mixedProblem(40, sources);
+        for (double& capacity : mixed.capacities) capacity *= 0.4;
+        knapsack.allocate(mixed, packed);
+        REQUIRE(isFeasible(mixed, packed));
+        CHECK_EQ(criticalServed(mixed, packed), greedyCriticalServed(mixed));
+    }
+}
+
+GRID_TEST(AllocationStrategy, KnapsackWithoutTimeFallsBackToGreedy) {
+    std::vector<std::size_t> packed;
+    // A zero budget, one that runs out partway through the search, and a
+    // busbar too large to search at all
+    struct Case {
+        double budget;
+        std::size_t loads;
+    };
+    for (const Case& test : {Case{0.0, 30}, Case{1.0, 60}, Case{200.0, 300}}) {
+        for (std::size_t sources : {1, 4}) {
+            AllocationProblem problem = mixedProblem(test.loads, sources);
+            KnapsackStrategy knapsack(test.budget);
+            knapsack.allocate(problem, packed);
+            REQUIRE(isFeasible(problem, packed));
+            CHECK(isMaximal(problem, packed));
+            CHECK_EQ(criticalServed(problem, packed), greedyCriticalServed(problem));
+            CHECK(weightedServed(knapsack, problem, packed) > 0.0);
+        }
+    }
+}
@@ -0,0 +1,143 @@
+// BatchRunTest.cpp
+//
+// Headless batch runs: neither the number of dispatch threads nor running
+// event-driven may change what they report.
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <sstream>
+#include <string>
+#include "../include/Simulator.h"
+#include "TestHarness.h"
+#include "TestSupport.h"
+
+namespace {
+
+const char* const TYPES[] = {"RESIDENTIAL", "COMMERCIAL", "INDUSTRIAL", "CRITICAL"};
+
+// A chain of tied busbars, some short of supply, with switching, trips and
+// demand changes spread over the run (and optionally load profiles)
+std::string writeScenario(bool profiles) {
+    std::string path = testing::tempPath(profiles ? "batch_profiles.txt" : "batch.txt");
+    std::ofstream file(path);
+    file << "grid Batch Grid\n";
+    const int busbars = 24;
+    for (int b = 0; b < busbars; ++b) {
+        file << "busbar B" << b << "\n";
+    }
+    for (int b = 0; b + 1 < busbars; ++b) {
+        file << "tie T" << b << " B" << b << " B" << b + 1 << " " << 60 + 10 * (b % 4)
+             << (b % 5 == 4 ? " open" : "") << "\n";
+    }
+    for (int b = 0; b < busbars; ++b) {
+        file << "source G" << b << "-a " << 120 + 37 * (b % 7) << " B" << b << "\n";
+        file << "source G" << b << "-b " << 40 + 13 * (b % 5) << " B" << b << "\n";
+        for (int l = 0; l < 10; ++l) {
+            file << "load L" << b << "-" << l << " " << 10 + (b * 7 + l * 13) % 40 << " "
+                 << TYPES[(b + l) % 4] << " " << 1 + (b * 3 + l) % 5 << " B" << b << "\n";
+        }
+    }
+    if (profiles) {
+        file << "profile RESIDENTIAL 0.5 0.8 1.2 1.0 0.7 0.6\n";
+        file << "profile COMMERCIAL 0.4 1.0 1.3 1.1 0.9 0.5\n";
+        file << "profile INDUSTRIAL 0.9 1.0 1.0 1.2 1.0 0.9\n";
+        file << "profile CRITICAL 1 1 1 1 1 1\n";
+    }
+    file << "at 3 trip G5-a\n"
+         << "at 4 open T2\n"
+         << "at 5 demand L7-3 200\n"
+         << "at 6 restore G5-a\n"
+         << "at 7 capacity G12-b 10\n"
+         << "at 8 disconnect L10-1\n"
+         << "at 9 close T2\n"
+         << "at 11 connect L10-1\n"
+         << "at 12 trip G0-a\n"
+         << "at 12 demand L3-0 5\n";
+    return path;
+}
+
+struct BatchOutput {
+    int exitCode;
+    std::string steps;   // The per-step CSV
+    std::string report;  // Shed events and the final grid report
+};
+
+// Step CSV rows by step, without the step column
+std::map<int, std::string> rowsByStep(const std::string& csv) {
+    std::map<int, std::string> rows;
+    std::istringstream lines(csv);
+    std::string line;
+    std::getline(lines, line);  // Header
+    while (std::getline(lines, line)) {
+        std::size_t comma = line.find(',');
+        rows[std::stoi(line.substr(0, comma))] = line.substr(comma + 1);
+    }
+    return rows;
+}
+
+BatchOutput runBatch(const std::string& scenarioPath, int steps, std::size_t threads, bool eventDriven) {
+    std::string output = testing::tempPath("batch_out.csv");
+    std::string report = testing::tempPath("batch_report.csv");
+    Simulator simulator;
+    simulator.setDispatchThreads(threads);
+    simulator.setEventDriven(eventDriven);
+    simulator.setReportFile(report);
+    BatchOutput result;
+    result.exitCode = simulator.runBatchSimulation(scenarioPath, steps, output);
+    result.steps = testing::readFile(output);
+    result.report = testing::readFile(report);
+    std::filesystem::remove(output);
+    std::filesystem::remove(report);
+    return result;
+}
+
+} // namespace
+
+GRID_TEST(BatchRun, ThreadCountDoesNotChangeResults) {
+    for (const std::string& scenario : {writeScenario(false), writeScenario(true),
+                                        std::string("scenarios/bus-ties.txt")}) {
+        BatchOutput serial = runBatch(scenario, 16, 1, false);
+        REQUIRE(serial.exitCode == 0);
+        CHECK(!serial.steps.empty());
+        CHECK(!serial.report.empty());
+        for (std::size_t threads : {2, 4}) {
+            BatchOutput parallel = runBatch(scenario, 16, threads, false);
+            CHECK_EQ(parallel.exitCode, 0);
+            CHECK(parallel.steps == serial.steps);
+            CHECK(parallel.report == serial.report);
+        }
+    }
+    std::filesystem::remove(testing::tempPath("batch.txt"));
+    std::filesystem::remove(testing::tempPath("batch_profiles.txt"));
+}
+
+GRID_TEST(BatchRun, EventDrivenMatchesFixedStep) {
+    struct Case {
+        std::string scenario;
+        std::size_t rows;  // Steps that re-solve when event-driven
+    };
+    const int steps = 50;
+    for (const Case& test : {Case{writeScenario(false), 10}, Case{writeScenario(true), steps + 1},
+                             Case{"scenarios/bus-ties.txt", 5}, Case{"scenarios/demo.txt", 5},
+                             Case{"scenarios/daily-profiles.txt", steps + 1}}) {
+        BatchOutput fixed = runBatch(test.scenario, steps, 1, false);
+        BatchOutput driven = runBatch(test.scenario, steps, 1, true);
+        REQUIRE(fixed.exitCode == 0);
+        REQUIRE(driven.exitCode == 0);
+        CHECK(driven.report == fixed.report);
+
+        // Quiet steps repeat the last step that re-solved
+        auto fixedRows = rowsByStep(fixed.steps);
+        auto drivenRows = rowsByStep(driven.steps);
+        CHECK_EQ(fixedRows.size(), static_cast<std::size_t>(steps + 1));
+        CHECK_EQ(drivenRows.size(), test.rows);
+        REQUIRE(drivenRows.count(0) == 1);
+        for (const auto& row : fixedRows) {
+            auto solved = std::prev(drivenRows.upper_bound(row.first));
+            CHECK(row.second == solved->second);
+        }
+    }
+    std::filesystem::remove(testing::tempPath("batch.txt"));
+    std::filesystem::remove(testing::tempPath("batch_profiles.txt"));
+}
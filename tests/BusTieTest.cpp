@@ -0,0 +1,110 @@
+// BusTieTest.cpp
+//
+// Dispatch over bus ties: loads a busbar cannot carry are served from
+// spare capacity across closed ties, within each tie's transfer limit, and
+// open ties carry nothing.
+#include <cmath>
+#include <map>
+#include <memory>
+#include <string>
+#include "../include/Grid.h"
+#include "TestHarness.h"
+#include "TestSupport.h"
+
+namespace {
+
+// Every tie within its limit (open ones idle), every source within its
+// capacity, and each busbar's served power equal to its own sources'
+// output plus what the ties bring in
+void checkFlows(Grid& grid) {
+    const GridState& state = grid.getState();
+    std::map<GridState::Handle, double> imported;
+    for (const auto& tie : grid.getTopology().getTies()) {
+        CHECK(std::fabs(tie.flowKw) <= tie.limitKw + 1e-9);
+        if (!tie.closed) {
+            CHECK_EQ(tie.flowKw, 0.0);
+        }
+        imported[tie.to] += tie.flowKw;
+        imported[tie.from] -= tie.flowKw;
+    }
+    for (const auto& busbar : grid.getBusbars()) {
+        GridState::Handle handle = busbar->getIndex();
+        double output = 0.0;
+        for (GridState::Handle source : state.busbarSources[handle]) {
+            CHECK(state.sourceCurrentLoad[source] <= state.sourceCapacity[source] + 1e-9);
+            output += state.sourceCurrentLoad[source];
+        }
+        CHECK_NEAR(state.busbarServedPower(handle), output + imported[handle], 1e-9);
+    }
+}
+
+const Topology::Tie& tie(Grid& grid, const std::string& id) {
+    return *grid.getTopology().findTie(id);
+}
+
+} // namespace
+
+GRID_TEST(BusTie, TransfersServeLoadsOverClosedTies) {
+    auto grid = testing::loadScenario("scenarios/bus-ties.txt");
+    REQUIRE(grid);
+    checkFlows(*grid);
+    // South's own 100 kW takes RES-S1; the hospital comes in over both ties
+    CHECK(grid->getLoad("HOSP-S")->isLoadServed());
+    CHECK(grid->getLoad("RES-S1")->isLoadServed());
+    CHECK(grid->getLoad("COMM-C2")->isLoadServed());
+    CHECK_NEAR(tie(*grid, "T-CS").flowKw, 150.0, 1e-9);
+    // T-NC is then full, so RES-S2 has nowhere to go
+    CHECK_NEAR(tie(*grid, "T-NC").flowKw, 300.0, 1e-9);
+    CHECK(!grid->getLoad("RES-S2")->isLoadServed());
+    CHECK_NEAR(grid->getShedLoad(), 120.0, 1e-9);
+}
+
+GRID_TEST(BusTie, OpenTieIsolatesItsBusbar) {
+    auto grid = testing::loadScenario("scenarios/bus-ties.txt");
+    REQUIRE(grid);
+    auto tied = testing::servedPowers(*grid);
+
+    grid->setTieClosed("T-CS", false);
+    grid->distributeLoadOptimally();
+    checkFlows(*grid);
+    CHECK_EQ(tie(*grid, "T-CS").flowKw, 0.0);
+    // South is down to its own 100 kW
+    CHECK(!grid->getLoad("HOSP-S")->isLoadServed());
+    CHECK(grid->getLoad("RES-S1")->isLoadServed());
+
+    // Closing it again re-solves both sides, as a full dispatch would
+    grid->setTieClosed("T-CS", true);
+    grid->distributeLoadOptimally();
+    checkFlows(*grid);
+    CHECK(testing::servedPowers(*grid) == tied);
+    grid->getState().markAllBusbarsDirty();
+    grid->distributeLoadOptimally();
+    CHECK(testing::servedPowers(*grid) == tied);
+}
+
+GRID_TEST(BusTie, LimitCapsTransfers) {
+    auto grid = testing::loadScenario("scenarios/bus-ties.txt");
+    REQUIRE(grid);
+    // Neither the hospital (150 kW) nor RES-S2 (120 kW) fits through 100 kW
+    grid->setTieLimit("T-CS", 100.0);
+    grid->distributeLoadOptimally();
+    checkFlows(*grid);
+    CHECK_EQ(tie(*grid, "T-CS").flowKw, 0.0);
+    CHECK(!grid->getLoad("HOSP-S")->isLoadServed());
+    CHECK(!grid->getLoad("RES-S2")->isLoadServed());
+    CHECK_NEAR(grid->getShedLoad(), 270.0, 1e-9);
+}
+
+GRID_TEST(BusTie, TripFarSourceShedsBehindTheTies) {
+    auto grid = testing::loadScenario("scenarios/bus-ties.txt");
+    REQUIRE(grid);
+    // Without North's generator the chain has only 200 kW, all local
+    grid->getSource("GEN-N")->setOperational(false);
+    grid->distributeLoadOptimally();
+    checkFlows(*grid);
+    for (const auto& tie : grid->getTopology().getTies()) {
+        CHECK_EQ(tie.flowKw, 0.0);
+    }
+    CHECK(!grid->getLoad("FACT-N")->isLoadServed());
+    CHECK_NEAR(grid->getServedDemand(), 170.0, 1e-9);
+}
@@ -0,0 +1,121 @@
+// BusbarTest.cpp
+//
+// Filtered walks over a busbar's connections: each filter visits exactly the
+// connections it names, whether the busbar reads the grid state's columns
+// (attached) or the entities' own fields (detached).
+#include <memory>
+#include <set>
+#include <string>
+#include "../include/Grid.h"
+#include "TestHarness.h"
+
+namespace {
+
+std::set<std::string> visitedLoads(const Busbar& busbar, Busbar::LoadFilter filter) {
+    std::set<std::string> ids;
+    busbar.forEachLoad(filter, [&](const Load& load) { ids.insert(load.getId()); });
+    return ids;
+}
+
+std::set<std::string> visitedSources(const Busbar& busbar, Busbar::SourceFilter filter) {
+    std::set<std::string> ids;
+    busbar.forEachSource(filter, [&](const PowerSource& source) { ids.insert(source.getId()); });
+    return ids;
+}
+
+// The loads a filter should visit, from the loads' own getters
+template <typename Predicate>
+std::set<std::string> loadsWhere(const Busbar& busbar, Predicate keep) {
+    std::set<std::string> ids;
+    for (const Load& load : busbar.getLoadView()) {
+        if (keep(load)) {
+            ids.insert(load.getId());
+        }
+    }
+    return ids;
+}
+
+void checkFilters(const Busbar& busbar) {
+    using Filter = Busbar::LoadFilter;
+    auto all = loadsWhere(busbar, [](const Load&) { return true; });
+    auto connected = loadsWhere(busbar, [](const Load& load) { return load.isLoadConnected(); });
+    auto served = loadsWhere(busbar, [](const Load& load) { return load.isLoadServed(); });
+    auto shed = loadsWhere(busbar, [](const Load& load) {
+        return load.isLoadConnected() && !load.isLoadServed();
+    });
+    CHECK_EQ(all.size(), busbar.getLoadView().size());
+    CHECK(visitedLoads(busbar, Filter::ALL) == all);
+    CHECK(visitedLoads(busbar, Filter::CONNECTED) == connected);
+    CHECK(visitedLoads(busbar, Filter::SERVED) == served);
+    CHECK(visitedLoads(busbar, Filter::SHED) == shed);
+
+    std::set<std::string> sources;
+    std::set<std::string> operational;
+    for (const PowerSource& source : busbar.getSourceView()) {
+        sources.insert(source.getId());
+        if (source.isOperational()) {
+            operational.insert(source.getId());
+        }
+    }
+    CHECK(visitedSources(busbar, Busbar::SourceFilter::ALL) == sources);
+    CHECK(visitedSources(busbar, Busbar::SourceFilter::OPERATIONAL) == operational);
+}
+
+} // namespace
+
+GRID_TEST(Busbar, FiltersVisitMatchingConnections) {
+    Grid grid("Test Grid");
+    grid.setShedReporting(false);
+    grid.addBusbar(grid.createBusbar("A"));
+    grid.addSource(grid.createSource("G1", 80.0), "A");
+    grid.addSource(grid.createSource("G2", 50.0), "A");
+    grid.addLoad(grid.createLoad("L1", 40.0, LoadType::CRITICAL, Priority::CRITICAL), "A");
+    grid.addLoad(grid.createLoad("L2", 30.0, LoadType::COMMERCIAL, Priority::HIGH), "A");
+    grid.addLoad(grid.createLoad("L3", 50.0, LoadType::RESIDENTIAL, Priority::LOW), "A");
+    grid.addLoad(grid.createLoad("L4", 20.0, LoadType::INDUSTRIAL, Priority::MEDIUM), "A");
+    grid.addLoad(grid.createLoad("L5", 10.0, LoadType::RESIDENTIAL, Priority::LOW), "A");
+    grid.getSource("G2")->setOperational(false);
+    grid.getLoad("L4")->disconnect();
+    grid.distributeLoadOptimally();
+
+    // One of each: served, shed, disconnected, and a tripped source
+    const Busbar& busbar = *grid.getBusbar("A");
+    using Filter = Busbar::LoadFilter;
+    CHECK(visitedLoads(busbar, Filter::SERVED) == (std::set<std::string>{"L1", "L2", "L5"}));
+    CHECK(visitedLoads(busbar, Filter::SHED) == std::set<std::string>{"L3"});
+    CHECK(visitedLoads(busbar, Filter::CONNECTED).count("L4") == 0);
+    CHECK(visitedSources(busbar, Busbar::SourceFilter::OPERATIONAL) == std::set<std::string>{"G1"});
+    checkFilters(busbar);
+
+    // Restoring the source serves everything still connected
+    grid.getSource("G2")->setOperational(true);
+    grid.distributeLoadOptimally();
+    CHECK(visitedLoads(busbar, Filter::SHED).empty());
+    checkFilters(busbar);
+}
+
+GRID_TEST(Busbar, DetachedFiltersReadTheEntities) {
+    Busbar busbar("X");
+    auto served = std::make_shared<Load>("S", 10.0, LoadType::COMMERCIAL, Priority::HIGH);
+    auto shed = std::make_shared<Load>("U", 10.0, LoadType::COMMERCIAL, Priority::LOW);
+    auto off = std::make_shared<Load>("D", 10.0, LoadType::COMMERCIAL, Priority::LOW);
+    auto running = std::make_shared<PowerSource>("G1", 100.0);
+    auto tripped = std::make_shared<PowerSource>("G2", 100.0);
+    busbar.connectLoad(served);
+    busbar.connectLoad(shed);
+    busbar.connectLoad(off);
+    busbar.connectSource(running);
+    busbar.connectSource(tripped);
+    served->setServed(true);
+    off->disconnect();
+    tripped->setOperational(false);
+    REQUIRE(!busbar.isAttached());
+
+    using Filter = Busbar::LoadFilter;
+    CHECK(visitedLoads(busbar, Filter::ALL) == (std::set<std::string>{"S", "U", "D"}));
+    CHECK(visitedLoads(busbar, Filter::CONNECTED) == (std::set<std::string>{"S", "U"}));
+    CHECK(visitedLoads(busbar, Filter::SERVED) == std::set<std::string>{"S"});
+    CHECK(visitedLoads(busbar, Filter::SHED) == std::set<std::string>{"U"});
+    CHECK(visitedSources(busbar, Busbar::SourceFilter::OPERATIONAL) == std::set<std::string>{"G1"});
+    checkFilters(busbar);
+}
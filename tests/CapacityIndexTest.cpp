@@ -0,0 +1,98 @@
+// CapacityIndexTest.cpp
+//
+// The segment tree has to find exactly what a linear first-fit scan would,
+// whatever the list's size (padding leaves included) and with unavailable
+// sources marked by a negative headroom.
+#include <random>
+#include <vector>
+#include "../include/CapacityIndex.h"
+#include "TestHarness.h"
+
+namespace {
+
+std::size_t linearFirst(const std::vector<double>& headroom, double demand, std::size_t from) {
+    for (std::size_t i = from; i < headroom.size(); ++i) {
+        if (headroom[i] >= demand) {
+            return i;
+        }
+    }
+    return CapacityIndex::NONE;
+}
+
+// Mostly ordinary headroom, with some exhausted and some unavailable
+double randomHeadroom(std::mt19937& random) {
+    switch (std::uniform_int_distribution<int>(0, 9)(random)) {
+        case 0: return -1.0;
+        case 1: return 0.0;
+        default: return std::uniform_real_distribution<double>(0.0, 100.0)(random);
+    }
+}
+
+// Random demands and starting points against the scan, then each source's
+// own headroom as the demand
+void checkQueries(const CapacityIndex& index, const std::vector<double>& headroom, std::mt19937& random) {
+    std::uniform_real_distribution<double> demands(-2.0, 110.0);
+    std::uniform_int_distribution<std::size_t> starts(0, headroom.size() + 1);
+    for (int query = 0; query < 8; ++query) {
+        double demand = demands(random);
+        std::size_t from = starts(random);
+        CHECK_EQ(index.findFirst(demand, from), linearFirst(headroom, demand, from));
+    }
+    for (std::size_t i = 0; i < headroom.size(); ++i) {
+        CHECK_EQ(index.getHeadroom(i), headroom[i]);
+        CHECK_EQ(index.findFirst(headroom[i], i), i);
+        CHECK_EQ(index.findFirst(headroom[i]), linearFirst(headroom, headroom[i], 0));
+    }
+    CHECK_EQ(index.findFirst(0.0), linearFirst(headroom, 0.0, 0));
+}
+
+} // namespace
+
+GRID_TEST(CapacityIndex, MatchesLinearScan) {
+    std::mt19937 random(12345);
+    CapacityIndex reused;
+    for (std::size_t size : {0, 1, 2, 3, 5, 7, 8, 9, 13, 31, 64, 100, 1000}) {
+        std::vector<double> headroom(size);
+        for (double& value : headroom) {
+            value = randomHeadroom(random);
+        }
+        CapacityIndex index(headroom);
+        reused.assign(headroom);
+        CHECK_EQ(index.size(), size);
+        CHECK_EQ(reused.size(), size);
+        checkQueries(index, headroom, random);
+        checkQueries(reused, headroom, random);
+        if (size == 0) continue;
+
+        std::uniform_int_distribution<std::size_t> slots(0, size - 1);
+        for (int update = 0; update < 200; ++update) {
+            std::size_t slot = slots(random);
+            headroom[slot] = randomHeadroom(random);
+            index.setHeadroom(slot, headroom[slot]);
+            std::uniform_real_distribution<double> demands(-2.0, 110.0);
+            for (int query = 0; query < 4; ++query) {
+                double demand = demands(random);
+                std::size_t from = slots(random);
+                CHECK_EQ(index.findFirst(demand, from), linearFirst(headroom, demand, from));
+            }
+        }
+        checkQueries(index, headroom, random);
+    }
+}
+
+GRID_TEST(CapacityIndex, UnavailableSourcesAreNeverFound) {
+    // Every source unavailable, then one by one back with no headroom
+    std::vector<double> headroom(6, -1.0);
+    CapacityIndex index(headroom);
+    CHECK_EQ(index.findFirst(0.0), CapacityIndex::NONE);
+    CHECK_EQ(index.findFirst(-0.5), CapacityIndex::NONE);
+    CHECK_EQ(index.findFirst(-1.0), 0u);
+    for (std::size_t i = 6; i-- > 0;) {
+        index.setHeadroom(i, 0.0);
+        CHECK_EQ(index.findFirst(0.0), i);
+        CHECK_EQ(index.findFirst(1e-9), CapacityIndex::NONE);
+    }
+    // Padding past the last source is never a match
+    CHECK_EQ(index.findFirst(0.0, 6), CapacityIndex::NONE);
+    CHECK_EQ(index.findFirst(-1e300, 6), CapacityIndex::NONE);
+}
@@ -0,0 +1,80 @@
+// ContingencyAnalyzerTest.cpp
+//
+// Outage studies must report what dispatch itself would shed with the
+// sources tripped, transfers over bus ties included.
+#include <memory>
+#include <string>
+#include "../include/ContingencyAnalyzer.h"
+#include "TestHarness.h"
+#include "TestSupport.h"
+
+namespace {
+
+// Every single-source outage against a dispatch of the grid with that source tripped
+void checkAgainstDispatch(const std::shared_ptr<Grid>& grid, std::shared_ptr<ThreadPool> pool) {
+    ContingencyAnalyzer analyzer(*grid, pool);
+    CHECK_NEAR(analyzer.getBaseShedKw(), grid->getShedLoad(), 1e-9);
+    ContingencyAnalyzer::Options options;
+    options.minAdditionalShed = -1.0;  // Keep every case
+    auto results = analyzer.run(options);
+    CHECK_EQ(results.size(), analyzer.getCandidateCount());
+    for (const auto& result : results) {
+        REQUIRE(result.outagedSources.size() == 1);
+        auto branch = grid->fork();
+        branch->getSource(result.outagedSources[0])->setOperational(false);
+        branch->distributeLoadOptimally();
+        CHECK_NEAR(result.shedKw, branch->getShedLoad(), 1e-9);
+        CHECK_NEAR(result.additionalShedKw, branch->getShedLoad() - grid->getShedLoad(), 1e-9);
+    }
+}
+
+} // namespace
+
+GRID_TEST(ContingencyAnalyzer, TiedGridMatchesDispatch) {
+    auto grid = testing::loadScenario("scenarios/bus-ties.txt");
+    REQUIRE(grid);
+    // South leans on transfers: only the low-priority RES-S2 is shed
+    CHECK_NEAR(grid->getShedLoad(), 120.0, 1e-9);
+    checkAgainstDispatch(grid, nullptr);
+    checkAgainstDispatch(grid, std::make_shared<ThreadPool>(4));
+}
+
+GRID_TEST(ContingencyAnalyzer, TiedOutageShedsOnlyWhatTransfersCannotCover) {
+    auto grid = testing::loadScenario("scenarios/bus-ties.txt");
+    REQUIRE(grid);
+    ContingencyAnalyzer analyzer(*grid);
+    ContingencyAnalyzer::Options options;
+    options.collectLoadIds = true;
+    auto results = analyzer.run(options);
+    for (const auto& result : results) {
+        if (result.outagedSources[0] != "GEN-C") continue;
+        // Centre's loads move onto T-NC, which then has no room for COMM-C2
+        CHECK_NEAR(result.additionalShedKw, 150.0, 1e-9);
+        REQUIRE(result.affectedLoads.size() == 1);
+        CHECK(result.affectedLoads[0] == "COMM-C2");
+    }
+}
+
+GRID_TEST(ContingencyAnalyzer, UntiedGridMatchesDispatch) {
+    auto grid = testing::loadScenario("scenarios/demo.txt");
+    REQUIRE(grid);
+    checkAgainstDispatch(grid, nullptr);
+}
+
+GRID_TEST(ContingencyAnalyzer, PriorityBreakdownCoversAdditionalShed) {
+    for (const char* path : {"scenarios/demo.txt", "scenarios/bus-ties.txt"}) {
+        auto grid = testing::loadScenario(path);
+        REQUIRE(grid);
+        ContingencyAnalyzer analyzer(*grid);
+        ContingencyAnalyzer::Options options;
+        options.outageSize = 2;
+        for (const auto& result : analyzer.run(options)) {
+            double byPriority = 0.0;
+            for (double kw : result.additionalShedKwByPriority) {
+                byPriority += kw;
+            }
+            CHECK_NEAR(byPriority, result.additionalShedKw, 1e-9);
+            CHECK_NEAR(result.shedKw, analyzer.getBaseShedKw() + result.additionalShedKw, 1e-9);
+        }
+    }
+}
@@ -0,0 +1,123 @@
+// ForkTest.cpp
+//
+// A fork shares its origin's columns until one of them writes, so edits on
+// either side, structural ones included, must never show through to the other.
+#include <string>
+#include "../include/Grid.h"
+#include "../include/PagedCowColumn.h"
+#include "TestHarness.h"
+#include "TestSupport.h"
+
+namespace {
+
+// Enough busbars and loads that the paged columns span several pages
+void buildGrid(Grid& grid) {
+    grid.setShedReporting(false);
+    for (int b = 0; b < 20; ++b) {
+        std::string id = "B" + std::to_string(b);
+        grid.addBusbar(grid.createBusbar(id));
+        grid.addSource(grid.createSource("G" + id, 3000.0), id);
+        for (int l = 0; l < 60; ++l) {
+            grid.addLoad(grid.createLoad("L" + id + "-" + std::to_string(l), 20.0 + l,
+                                         LoadType::COMMERCIAL, static_cast<Priority>(1 + l % 5)),
+                         id);
+        }
+    }
+    grid.distributeLoadOptimally();
+}
+
+// Adds, removes and edits entities the other side still shares
+void editStructure(Grid& grid) {
+    grid.addBusbar(grid.createBusbar("B-new"));
+    grid.addSource(grid.createSource("G-new", 100.0), "B-new");
+    grid.addLoad(grid.createLoad("L-new", 50.0, LoadType::INDUSTRIAL, Priority::HIGH), "B0");
+    grid.removeLoad("LB0-3");
+    grid.removeLoad("LB19-59");
+    grid.removeSource("GB7");
+    grid.getLoad("LB3-1")->setPowerDemand(500.0);
+    grid.distributeLoadOptimally();
+}
+
+} // namespace
+
+GRID_TEST(Fork, PagedColumnCopiesOnlyTheEditedPage) {
+    PagedCowColumn<std::string, 4> ids;
+    for (int i = 0; i < 10; ++i) {
+        ids.emplace_back() = "id" + std::to_string(i);
+    }
+    PagedCowColumn<std::string, 4> copy = ids;
+    copy.edit(5) = "changed";
+    copy.emplace_back() = "id10";  // Last page is shared and only half full
+    CHECK(ids[5] == "id5");
+    CHECK(copy[5] == "changed");
+    CHECK(&ids[0] == &copy[0]);    // Untouched pages stay shared
+    CHECK(&ids[8] != &copy[8]);
+    CHECK_EQ(ids.size(), 10u);
+    CHECK_EQ(copy.size(), 11u);
+    CHECK(copy[10] == "id10");
+}
+
+GRID_TEST(Fork, BranchEditsDoNotReachOrigin) {
+    Grid grid("Test Grid");
+    buildGrid(grid);
+    auto before = testing::servedPowers(grid);
+    double shed = grid.getShedLoad();
+
+    auto branch = grid.fork();
+    editStructure(*branch);
+    CHECK(branch->getLoad("L-new"));
+    CHECK(!branch->getLoad("LB0-3"));
+    CHECK(!branch->getSource("GB7"));
+
+    CHECK(!grid.getLoad("L-new"));
+    CHECK(!grid.getBusbar("B-new"));
+    REQUIRE(grid.getLoad("LB0-3"));
+    REQUIRE(grid.getSource("GB7"));
+    CHECK_EQ(grid.getLoad("LB3-1")->getPowerDemand(), 21.0);
+    CHECK(testing::servedPowers(grid) == before);
+
+    // Re-solving from scratch reads only the origin's own columns
+    grid.getState().markAllBusbarsDirty();
+    grid.distributeLoadOptimally();
+    CHECK(testing::servedPowers(grid) == before);
+    CHECK_EQ(grid.getShedLoad(), shed);
+}
+
+GRID_TEST(Fork, OriginEditsDoNotReachBranch) {
+    Grid grid("Test Grid");
+    buildGrid(grid);
+    auto branch = grid.fork();
+    branch->distributeLoadOptimally();
+    auto before = testing::servedPowers(*branch);
+
+    editStructure(grid);
+    CHECK(!branch->getLoad("L-new"));
+    REQUIRE(branch->getLoad("LB19-59"));
+    REQUIRE(branch->getSource("GB7"));
+    CHECK_EQ(branch->getLoad("LB3-1")->getPowerDemand(), 21.0);
+    branch->getState().markAllBusbarsDirty();
+    branch->distributeLoadOptimally();
+    CHECK(testing::servedPowers(*branch) == before);
+}
+
+GRID_TEST(Fork, SiblingBranchesMatchTheSameEditsOnACopy) {
+    Grid grid("Test Grid");
+    buildGrid(grid);
+    auto first = grid.fork();
+    auto second = grid.fork();
+    editStructure(*first);
+    second->removeLoad("LB0-3");
+    second->distributeLoadOptimally();
+
+    // The same edits applied to a grid built from scratch
+    Grid fresh("Test Grid");
+    buildGrid(fresh);
+    editStructure(fresh);
+    CHECK(testing::servedPowers(*first) == testing::servedPowers(fresh));
+    CHECK_EQ(first->getShedLoad(), fresh.getShedLoad());
+
+    CHECK(!second->getLoad("L-new"));
+    CHECK(!second->getLoad("LB0-3"));
+    CHECK(second->getLoad("LB19-59"));
+    CHECK(second->getSource("GB7"));
+}
@@ -0,0 +1,124 @@
+// GridStateTest.cpp
+//
+// Incremental dispatch: only busbars marked dirty are re-solved, so every
+// edit has to mark the busbars it affects, including reused slots.
+#include <cmath>
+#include <string>
+#include "../include/Grid.h"
+#include "TestHarness.h"
+#include "TestSupport.h"
+
+namespace {
+
+// Three busbars, each short of supply so that dispatch has to choose
+void buildGrid(Grid& grid) {
+    grid.setShedReporting(false);
+    for (int b = 0; b < 3; ++b) {
+        std::string id = "B" + std::to_string(b);
+        grid.addBusbar(grid.createBusbar(id));
+        grid.addSource(grid.createSource("G" + id, 100.0), id);
+        for (int l = 0; l < 4; ++l) {
+            grid.addLoad(grid.createLoad("L" + id + "-" + std::to_string(l), 20.0 + 10.0 * l,
+                                         LoadType::COMMERCIAL, static_cast<Priority>(1 + l)),
+                         id);
+        }
+    }
+}
+
+} // namespace
+
+GRID_TEST(GridState, ReusedBusbarSlotIsDispatched) {
+    Grid grid("Test Grid");
+    grid.setShedReporting(false);
+    grid.addBusbar(grid.createBusbar("A"));
+    grid.addSource(grid.createSource("G1", 100.0), "A");
+    grid.addLoad(grid.createLoad("L1", 50.0, LoadType::RESIDENTIAL, Priority::MEDIUM), "A");
+    grid.distributeLoadOptimally();
+    grid.removeBusbar("A");
+    grid.distributeLoadOptimally();
+
+    // B takes A's freed slot
+    grid.addBusbar(grid.createBusbar("B"));
+    grid.addSource(grid.createSource("G2", 100.0), "B");
+    grid.addLoad(grid.createLoad("L2", 40.0, LoadType::RESIDENTIAL, Priority::MEDIUM), "B");
+    grid.distributeLoadOptimally();
+    CHECK_EQ(grid.getLoad("L2")->getServedPower(), 40.0);
+
+    grid.getLoad("L2")->setPowerDemand(60.0);
+    grid.distributeLoadOptimally();
+    CHECK_EQ(grid.getLoad("L2")->getServedPower(), 60.0);
+}
+
+GRID_TEST(GridState, BusbarRemovedWhileDirtyIsNotDispatched) {
+    Grid grid("Test Grid");
+    buildGrid(grid);
+    grid.distributeLoadOptimally();
+    grid.getLoad("LB1-0")->setPowerDemand(25.0);
+    grid.removeBusbar("B1");
+    grid.addBusbar(grid.createBusbar("B3"));
+    grid.addSource(grid.createSource("GB3", 50.0), "B3");
+    grid.addLoad(grid.createLoad("LB3", 30.0, LoadType::INDUSTRIAL, Priority::HIGH), "B3");
+
+    const auto& dirty = grid.getState().getDirtyBusbars();
+    CHECK_EQ(dirty.size(), 1u);
+    grid.distributeLoadOptimally();
+    CHECK_EQ(grid.getLoad("LB3")->getServedPower(), 30.0);
+}
+
+GRID_TEST(GridState, EditMarksOnlyItsBusbar) {
+    Grid grid("Test Grid");
+    buildGrid(grid);
+    grid.distributeLoadOptimally();
+    CHECK(grid.getState().getDirtyBusbars().empty());
+
+    grid.getLoad("LB2-3")->setPowerDemand(5.0);
+    const GridState& state = grid.getState();
+    Busbar* owner = grid.getOwningBusbar(*grid.getLoad("LB2-3"));
+    for (const auto& busbar : grid.getBusbars()) {
+        CHECK_EQ(state.isBusbarDirty(busbar->getIndex()), busbar.get() == owner);
+    }
+}
+
+GRID_TEST(GridState, IncrementalDispatchMatchesFullDispatch) {
+    Grid grid("Test Grid");
+    buildGrid(grid);
+    grid.distributeLoadOptimally();
+
+    grid.getLoad("LB0-1")->setPowerDemand(70.0);
+    grid.getSource("GB1")->setCapacity(40.0);
+    grid.getLoad("LB2-0")->disconnect();
+    grid.removeLoad("LB2-2");
+    grid.addLoad(grid.createLoad("LB1-new", 15.0, LoadType::CRITICAL, Priority::CRITICAL), "B1");
+    grid.distributeLoadOptimally();
+    auto incremental = testing::servedPowers(grid);
+    double shed = grid.getShedLoad();
+
+    grid.getState().markAllBusbarsDirty();
+    grid.distributeLoadOptimally();
+    CHECK(testing::servedPowers(grid) == incremental);
+    CHECK_EQ(grid.getShedLoad(), shed);
+}
+
+GRID_TEST(GridState, CurtailedTierSurvivesRounding) {
+    // The demands sum to one ulp above the capacity in load order, but the
+    // water level's partitioned sums fit, leaving no load capped
+    const double demands[] = {1.4000000000000001, 34.100000000000001, 30.300000000000001,
+                              72.199999999999989, 24.300000000000001};
+    Grid grid("Test Grid");
+    grid.setShedReporting(false);
+    grid.setCurtailment(true);
+    grid.addBusbar(grid.createBusbar("A"));
+    grid.addSource(grid.createSource("G", 162.29999999999998), "A");
+    for (int i = 0; i < 5; ++i) {
+        auto load = grid.createLoad("L" + std::to_string(i), demands[i], LoadType::RESIDENTIAL, Priority::LOW);
+        load->setCurtailable(true);
+        grid.addLoad(load, "A");
+    }
+    grid.distributeLoadOptimally();
+    for (int i = 0; i < 5; ++i) {
+        double served = grid.getLoad("L" + std::to_string(i))->getServedPower();
+        CHECK(std::isfinite(served));
+        CHECK_NEAR(served, demands[i], 1e-9);
+    }
+    CHECK_NEAR(grid.getServedDemand(), 162.3, 1e-9);
+}
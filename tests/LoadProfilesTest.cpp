@@ -0,0 +1,75 @@
+// LoadProfilesTest.cpp
+//
+// Profiles scale each load's base demand; demand changes made while a
+// profile runs set that base, so they survive later profile steps.
+#include <memory>
+#include <string>
+#include <vector>
+#include "../include/Grid.h"
+#include "../include/Scenario.h"
+#include "TestHarness.h"
+#include "TestSupport.h"
+
+GRID_TEST(LoadProfiles, DemandEventSetsBaseDemand) {
+    const std::vector<std::string> lines = {
+        "grid Profiled",
+        "busbar Main",
+        "source G 1000 Main",
+        "load R 100 RESIDENTIAL MEDIUM Main",
+        "load C 100 COMMERCIAL MEDIUM Main",
+        "profile RESIDENTIAL 0.5 1.0 0.5 1.0 0.5",
+        "profile COMMERCIAL 1.0 1.0 1.0 1.0 1.0",
+        "scale R 2",
+        "at 1 demand R 40",
+    };
+    Scenario scenario;
+    REQUIRE(testing::parseScenario(scenario, lines));
+    Grid grid(scenario.getGridName());
+    grid.setShedReporting(false);
+    scenario.buildGrid(grid);
+
+    // Base 100, scale 2, then base 40 from step 1
+    const double expected[] = {100.0, 80.0, 40.0, 80.0, 40.0};
+    for (int step = 0; step < 5; ++step) {
+        scenario.applyEvents(grid, step);
+        grid.applyLoadProfiles(step);
+        grid.distributeLoadOptimally();
+        CHECK_NEAR(grid.getLoad("R")->getPowerDemand(), expected[step], 1e-9);
+        CHECK_NEAR(grid.getLoad("R")->getBaseDemand(), step == 0 ? 100.0 : 40.0, 1e-9);
+        CHECK_NEAR(grid.getTotalDemand(), expected[step] + 100.0, 1e-9);
+        CHECK_NEAR(grid.getServedDemand(), expected[step] + 100.0, 1e-9);
+    }
+}
+
+GRID_TEST(LoadProfiles, SetPowerDemandSurvivesProfileSteps) {
+    Grid grid("Profiled");
+    grid.setShedReporting(false);
+    grid.addBusbar(grid.createBusbar("Main"));
+    grid.addSource(grid.createSource("G", 1000.0), "Main");
+    grid.addLoad(grid.createLoad("I", 200.0, LoadType::INDUSTRIAL, Priority::HIGH), "Main");
+    auto profiles = std::make_shared<LoadProfiles>(2);
+    profiles->setCurve(LoadType::INDUSTRIAL, {0.5, 0.75});
+    grid.setLoadProfiles(profiles);
+
+    grid.applyLoadProfiles(0);
+    CHECK_NEAR(grid.getLoad("I")->getPowerDemand(), 100.0, 1e-9);
+    grid.getLoad("I")->setPowerDemand(300.0);
+    CHECK_NEAR(grid.getLoad("I")->getPowerDemand(), 150.0, 1e-9);
+    grid.applyLoadProfiles(1);
+    CHECK_NEAR(grid.getLoad("I")->getPowerDemand(), 225.0, 1e-9);
+    grid.applyLoadProfiles(2);  // Wraps to the first interval
+    CHECK_NEAR(grid.getLoad("I")->getPowerDemand(), 150.0, 1e-9);
+    grid.distributeLoadOptimally();
+    CHECK_NEAR(grid.getServedDemand(), 150.0, 1e-9);
+}
+
+GRID_TEST(LoadProfiles, DemandWithoutProfilesIsUnscaled) {
+    Grid grid("Plain");
+    grid.setShedReporting(false);
+    grid.addBusbar(grid.createBusbar("Main"));
+    grid.addLoad(grid.createLoad("L", 10.0, LoadType::RESIDENTIAL, Priority::LOW), "Main");
+    grid.getLoad("L")->setProfileScale(3.0);
+    grid.getLoad("L")->setPowerDemand(25.0);
+    CHECK_NEAR(grid.getLoad("L")->getPowerDemand(), 25.0, 1e-9);
+    CHECK_NEAR(grid.getLoad("L")->getBaseDemand(), 25.0, 1e-9);
+}
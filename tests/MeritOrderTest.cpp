@@ -0,0 +1,133 @@
+// MeritOrderTest.cpp
+//
+// Economic dispatch on one busbar with piecewise-linear cost curves: the
+// outputs and cost must match the optimum worked out by hand, minimum
+// outputs must hold, and the merit order kept up to date in place must
+// agree with one rebuilt from scratch.
+#include <string>
+#include <vector>
+#include "../include/Grid.h"
+#include "../include/MeritOrder.h"
+#include "TestHarness.h"
+
+namespace {
+
+// A: 0.10 up to 50 kW, then 0.30 up to 100
+// B: 0.20 up to 40 kW, then 0.25 up to 80, and at least 30 kW when running
+// C: 0.15 flat up to 60
+// and three loads, small enough that no source has to carry more than its
+// capacity before the economic redispatch
+void buildGrid(Grid& grid, double l1, double l2, double l3) {
+    grid.setShedReporting(false);
+    grid.setEconomicDispatch(true);
+    grid.addBusbar(grid.createBusbar("A"));
+    auto a = grid.createSource("GEN-A", 100.0);
+    auto b = grid.createSource("GEN-B", 80.0);
+    auto c = grid.createSource("GEN-C", 60.0);
+    a->setCostCurve({{50.0, 0.10}, {100.0, 0.30}});
+    b->setCostCurve({{40.0, 0.20}, {80.0, 0.25}});
+    b->setMinOutput(30.0);
+    c->setMarginalCost(0.15);
+    grid.addSource(a, "A");
+    grid.addSource(b, "A");
+    grid.addSource(c, "A");
+    grid.addLoad(grid.createLoad("L1", l1, LoadType::INDUSTRIAL, Priority::HIGH), "A");
+    grid.addLoad(grid.createLoad("L2", l2, LoadType::COMMERCIAL, Priority::MEDIUM), "A");
+    grid.addLoad(grid.createLoad("L3", l3, LoadType::RESIDENTIAL, Priority::LOW), "A");
+    grid.distributeLoadOptimally();
+}
+
+void setDemands(Grid& grid, double l1, double l2, double l3) {
+    grid.getLoad("L1")->setPowerDemand(l1);
+    grid.getLoad("L2")->setPowerDemand(l2);
+    grid.getLoad("L3")->setPowerDemand(l3);
+    grid.distributeLoadOptimally();
+}
+
+double output(Grid& grid, const std::string& id) {
+    return grid.getSource(id)->getCurrentLoad();
+}
+
+void checkOutputs(Grid& grid, double a, double b, double c, double cost, double lambda) {
+    CHECK_NEAR(output(grid, "GEN-A"), a, 1e-9);
+    CHECK_NEAR(output(grid, "GEN-B"), b, 1e-9);
+    CHECK_NEAR(output(grid, "GEN-C"), c, 1e-9);
+    CHECK_NEAR(grid.getOperatingCost(), cost, 1e-9);
+    CHECK_NEAR(grid.getBusbar("A")->getIncrementalCost(), lambda, 1e-12);
+}
+
+// The grid's outputs against a merit order rebuilt from the current state
+void checkAgainstRebuild(Grid& grid) {
+    const GridState& state = grid.getState();
+    GridState::Handle busbar = grid.getBusbar("A")->getIndex();
+    double demand = 0.0;
+    for (GridState::Handle source : state.busbarSources[busbar]) {
+        demand += state.sourceCurrentLoad[source];
+    }
+    MeritOrder rebuilt;
+    rebuilt.rebuild(state);
+    std::vector<double> outputs(state.sourceSlotCount(), 0.0);
+    MeritOrder::Dispatch result;
+    REQUIRE(rebuilt.dispatch(state, busbar, demand, outputs.data(), result));
+    for (GridState::Handle source : state.busbarSources[busbar]) {
+        CHECK_NEAR(state.sourceCurrentLoad[source], outputs[source], 1e-9);
+    }
+    CHECK_NEAR(grid.getOperatingCost(), result.costPerHour, 1e-9);
+}
+
+} // namespace
+
+GRID_TEST(MeritOrder, MatchesHandComputedOptimum) {
+    // B's 30 kW minimum (6.00/h), then A's first 50 (5.00), all of C (9.00)
+    // and B's next 10 (2.00), where the 0.20 segment sets lambda
+    Grid grid("Test Grid");
+    buildGrid(grid, 50.0, 50.0, 50.0);
+    checkOutputs(grid, 50.0, 40.0, 60.0, 22.0, 0.20);
+    checkAgainstRebuild(grid);
+
+    // Past C, the next cheapest is B's 0.25 segment, not A's 0.30 one
+    setDemands(grid, 60.0, 60.0, 60.0);
+    checkOutputs(grid, 50.0, 70.0, 60.0, 29.5, 0.25);
+    checkAgainstRebuild(grid);
+}
+
+GRID_TEST(MeritOrder, RespectsMinimumOutput) {
+    // B runs at its minimum although C could carry the 10 kW more cheaply
+    Grid grid("Test Grid");
+    buildGrid(grid, 30.0, 30.0, 30.0);
+    checkOutputs(grid, 50.0, 30.0, 10.0, 12.5, 0.15);
+
+    // Below B's minimum it is left off rather than run under it
+    setDemands(grid, 10.0, 5.0, 5.0);
+    checkOutputs(grid, 20.0, 0.0, 0.0, 2.0, 0.10);
+
+    // Unless it is the only source: then it runs at its minimum or more
+    grid.getSource("GEN-A")->setOperational(false);
+    grid.getSource("GEN-C")->setOperational(false);
+    setDemands(grid, 15.0, 10.0, 10.0);
+    checkOutputs(grid, 0.0, 35.0, 0.0, 7.0, 0.20);
+}
+
+GRID_TEST(MeritOrder, UpdatesInPlaceOnSourceChanges) {
+    Grid grid("Test Grid");
+    buildGrid(grid, 50.0, 50.0, 50.0);
+
+    // C down to 20 kW: B's 0.25 segment takes its place
+    grid.getSource("GEN-C")->setCapacity(20.0);
+    grid.distributeLoadOptimally();
+    checkOutputs(grid, 50.0, 80.0, 20.0, 26.0, 0.25);
+    checkAgainstRebuild(grid);
+
+    // C back, A tripped and less demand: C then B up its curve
+    grid.getSource("GEN-C")->setCapacity(60.0);
+    grid.getSource("GEN-A")->setOperational(false);
+    setDemands(grid, 40.0, 40.0, 40.0);
+    checkOutputs(grid, 0.0, 60.0, 60.0, 22.0, 0.25);
+    checkAgainstRebuild(grid);
+
+    // A restored: back to the original optimum
+    grid.getSource("GEN-A")->setOperational(true);
+    setDemands(grid, 50.0, 50.0, 50.0);
+    checkOutputs(grid, 50.0, 40.0, 60.0, 22.0, 0.20);
+    checkAgainstRebuild(grid);
+}
@@ -0,0 +1,204 @@
+// ModelImporterTest.cpp
+//
+// Asset exports: quoting and escapes must decode to the same IDs however a
+// file is encoded, records must survive the chunked reader's buffer
+// boundary, and a bad record must be reported with its line number.
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include "../include/Grid.h"
+#include "../include/ModelImporter.h"
+#include "TestHarness.h"
+#include "TestSupport.h"
+
+namespace {
+
+constexpr std::size_t CHUNK_SIZE = 1 << 20;  // As read by the importer
+
+std::string writeFile(const std::string& name, const std::string& content) {
+    std::string path = testing::tempPath(name);
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file << content;
+    return path;
+}
+
+// Imports the content into the grid from a scratch file of the given name
+bool importText(Grid& grid, ModelImporter& importer, const std::string& name, const std::string& content) {
+    std::string path = writeFile(name, content);
+    bool ok = importer.importFile(path);
+    std::filesystem::remove(path);
+    return ok;
+}
+
+std::string busbarOf(Grid& grid, const std::string& loadId) {
+    auto load = grid.getLoad(loadId);
+    Busbar* busbar = load ? grid.getOwningBusbar(*load) : nullptr;
+    return busbar ? busbar->getId() : "";
+}
+
+// The error's line number, from "<path>:<line>: <message>"
+int errorLine(const ModelImporter& importer) {
+    const std::string& error = importer.getLastError();
+    std::size_t end = error.find(": ");
+    std::size_t start = error.rfind(':', end - 1);
+    if (end == std::string::npos || start == std::string::npos) {
+        return 0;
+    }
+    return std::stoi(error.substr(start + 1, end - start - 1));
+}
+
+} // namespace
+
+GRID_TEST(ModelImporter, CsvQuotedFields) {
+    Grid grid("Test Grid");
+    ModelImporter importer(grid);
+    REQUIRE(importText(grid, importer, "quoted.csv",
+                       "id,kw,type,priority,busbar,note\n"
+                       "\"L \"\"one\"\"\", 12.5 ,RESIDENTIAL,3,\"B,1\",\"say \"\"hi\"\", ok\"\n"
+                       " \"L2\" ,\"7\",commercial,HIGH,  B2  ,\n"
+                       "\"\"\"\"\"\",1,INDUSTRIAL,5,B2,\"\"\n"));
+    CHECK_EQ(importer.getLoadCount(), 3u);
+    REQUIRE(grid.getLoad("L \"one\""));
+    CHECK_EQ(grid.getLoad("L \"one\"")->getPowerDemand(), 12.5);
+    CHECK(busbarOf(grid, "L \"one\"") == "B,1");
+    REQUIRE(grid.getLoad("L2"));
+    CHECK(grid.getLoad("L2")->getType() == LoadType::COMMERCIAL);
+    CHECK(grid.getLoad("L2")->getPriority() == Priority::HIGH);
+    CHECK(busbarOf(grid, "L2") == "B2");
+    CHECK(grid.getLoad("\"\""));
+
+    // A quote left open is an error, not the rest of the file
+    CHECK(!importText(grid, importer, "open_quote.csv", "id,kw,type,priority,busbar\n\"L3,1,RESIDENTIAL,3,B1\n"));
+    CHECK(importer.getLastError().find("unterminated") != std::string::npos);
+}
+
+GRID_TEST(ModelImporter, JsonEscapes) {
+    Grid grid("Test Grid");
+    ModelImporter importer(grid);
+    REQUIRE(importText(grid, importer, "escapes.jsonl",
+                       "{\"id\":\"L\\u00e9\\t\\\"x\\\"\",\"kw\":5,\"type\":\"COMMERCIAL\",\"priority\":2,"
+                       "\"busbar\":\"B\\/1\",\"note\":\"a\\\\b\\n\\r\\f\\b\"}\n"
+                       "{ \"\\u0069d\" : \"\\u20ac\" , \"kw\" : 1e1 , \"type\" : \"CRITICAL\" , "
+                       "\"priority\" : \"CRITICAL\" , \"busbar\" : \"B\\u00201\" , \"spare\" : null }\n"
+                       "{\"id\":\"G\\\\1\",\"capacity\":250,\"busbar\":\"B/1\"}\n"));
+    CHECK_EQ(importer.getLoadCount(), 2u);
+    CHECK_EQ(importer.getSourceCount(), 1u);
+    REQUIRE(grid.getLoad("L\xC3\xA9\t\"x\""));
+    CHECK(busbarOf(grid, "L\xC3\xA9\t\"x\"") == "B/1");
+    REQUIRE(grid.getLoad("\xE2\x82\xAC"));
+    CHECK_EQ(grid.getLoad("\xE2\x82\xAC")->getPowerDemand(), 10.0);
+    CHECK(busbarOf(grid, "\xE2\x82\xAC") == "B 1");
+    CHECK(grid.getSource("G\\1"));
+
+    for (const char* bad : {"{\"id\":\"L\\q\",\"kw\":1,\"type\":\"CRITICAL\",\"priority\":1,\"busbar\":\"B\"}\n",
+                            "{\"id\":\"L\\u12\",\"kw\":1,\"type\":\"CRITICAL\",\"priority\":1,\"busbar\":\"B\"}\n",
+                            "{\"id\":\"L\\u00zz\",\"kw\":1,\"type\":\"CRITICAL\",\"priority\":1,\"busbar\":\"B\"}\n"}) {
+        CHECK(!importText(grid, importer, "bad_escape.jsonl", bad));
+        CHECK(importer.getLastError().find("escape") != std::string::npos);
+    }
+}
+
+GRID_TEST(ModelImporter, ByteOrderMarkAndCrlf) {
+    Grid grid("Test Grid");
+    ModelImporter importer(grid);
+    REQUIRE(importText(grid, importer, "windows.csv",
+                       "\xEF\xBB\xBFid,kw,type,priority,busbar\r\n"
+                       "L1,10,RESIDENTIAL,3,B1\r\n"
+                       "\r\n"
+                       "# A comment\r\n"
+                       "L2,20,RESIDENTIAL,3,B1\r\n"));
+    REQUIRE(importText(grid, importer, "windows.txt",
+                       "\xEF\xBB\xBF{\"id\":\"L3\",\"kw\":30,\"type\":\"COMMERCIAL\",\"priority\":2,\"busbar\":\"B1\"}\r\n"
+                       "{\"id\":\"G1\",\"capacity\":100,\"busbar\":\"B1\"}\r\n"));
+    CHECK_EQ(importer.getLoadCount(), 3u);
+    CHECK_EQ(importer.getSourceCount(), 1u);
+    CHECK_EQ(importer.getBusbarCount(), 1u);
+    CHECK(grid.getLoad("L1"));
+    CHECK(grid.getLoad("L3"));
+    REQUIRE(grid.getSource("G1"));
+    CHECK_EQ(grid.getSource("G1")->getCapacity(), 100.0);
+    CHECK(busbarOf(grid, "L2") == "B1");
+}
+
+GRID_TEST(ModelImporter, RecordsAcrossChunkBoundaries) {
+    std::string content = "id,kw,type,priority,busbar,note\n";
+    std::string straddling;
+    int records = 0;
+    while (content.size() < 2 * CHUNK_SIZE + 1000) {
+        std::string id = "L" + std::to_string(records);
+        std::string line = id + "," + std::to_string(1 + records % 50) + ",RESIDENTIAL,4,B" +
+                           std::to_string(records % 7) + ",padding padding\n";
+        if (content.size() < CHUNK_SIZE && content.size() + line.size() > CHUNK_SIZE) {
+            straddling = id;
+        }
+        content += line;
+        ++records;
+    }
+    // One record longer than a whole chunk
+    content += "LONG,3,INDUSTRIAL,2,B0," + std::string(CHUNK_SIZE + CHUNK_SIZE / 2, 'x') + "\n";
+    content += "LAST,4,INDUSTRIAL,2,B1,tail";  // No final newline
+    REQUIRE(!straddling.empty());
+
+    Grid grid("Test Grid");
+    ModelImporter importer(grid, 1000);
+    REQUIRE(importText(grid, importer, "large.csv", content));
+    CHECK_EQ(importer.getLoadCount(), static_cast<std::size_t>(records + 2));
+    CHECK_EQ(importer.getBusbarCount(), 7u);
+    int index = std::stoi(straddling.substr(1));
+    REQUIRE(grid.getLoad(straddling));
+    CHECK_EQ(grid.getLoad(straddling)->getPowerDemand(), static_cast<double>(1 + index % 50));
+    CHECK(busbarOf(grid, straddling) == "B" + std::to_string(index % 7));
+    CHECK(grid.getLoad("LONG"));
+    CHECK(busbarOf(grid, "LAST") == "B1");
+
+    // And an error past the first chunk still has its line number
+    Grid second("Test Grid");
+    ModelImporter failing(second);
+    CHECK(!importText(second, failing, "large_bad.csv", content + "\nBAD,x,RESIDENTIAL,4,B1\n"));
+    CHECK_EQ(errorLine(failing), records + 4);
+    CHECK_EQ(failing.getLoadCount(), static_cast<std::size_t>(records + 2));
+}
+
+GRID_TEST(ModelImporter, ErrorsReportTheirLine) {
+    struct Case {
+        const char* record;
+        const char* message;
+    };
+    const std::string header = "id,kind,kw,capacity,type,priority,busbar\r\n"
+                               "# Comment\r\n"
+                               "\r\n"
+                               "L1,load,10,,RESIDENTIAL,3,B1\r\n"
+                               "G1,source,,100,,,B1\r\n";
+    for (const Case& test : {Case{"L2,load,-5,,RESIDENTIAL,3,B1", "negative demand '-5'"},
+                             Case{"G2,source,,-1,,,B1", "negative capacity '-1'"},
+                             Case{"L1,load,20,,COMMERCIAL,2,B2", "duplicate load id 'L1'"},
+                             Case{"G1,source,,50,,,B2", "duplicate source id 'G1'"},
+                             Case{"L2,load,abc,,RESIDENTIAL,3,B1", "invalid demand 'abc'"},
+                             Case{"L2,load,5,,HOUSE,3,B1", "unknown load type 'HOUSE'"},
+                             Case{"L2,load,5,,RESIDENTIAL,9,B1", "unknown priority '9'"},
+                             Case{"L2,pump,5,,RESIDENTIAL,3,B1", "unknown kind 'pump'"},
+                             Case{"L2,load,5,,RESIDENTIAL,3,", "missing busbar"}}) {
+        Grid grid("Test Grid");
+        ModelImporter importer(grid);
+        CHECK(!importText(grid, importer, "bad.csv", header + test.record + "\r\nL9,load,1,,RESIDENTIAL,3,B1\r\n"));
+        CHECK_EQ(errorLine(importer), 6);
+        CHECK(importer.getLastError().find(test.message) != std::string::npos);
+        // Records before the bad one are in, the ones after are not
+        CHECK_EQ(importer.getLoadCount(), 1u);
+        CHECK_EQ(importer.getSourceCount(), 1u);
+        CHECK(!grid.getLoad("L9"));
+    }
+
+    // A load and a source may share an ID, and zero kW is not negative
+    Grid grid("Test Grid");
+    ModelImporter importer(grid);
+    CHECK(importText(grid, importer, "shared.csv", header + "L1,source,,40,,,B1\r\n"));
+    CHECK(importText(grid, importer, "zero.jsonl",
+                     "{\"id\":\"L0\",\"kw\":0,\"type\":\"RESIDENTIAL\",\"priority\":3,\"busbar\":\"B1\"}\n"
+                     "{\"id\":\"G0\",\"capacity\":0,\"busbar\":\"B1\"}\n"));
+    CHECK(!importText(grid, importer, "json_bad.jsonl",
+                      "{\"id\":\"L5\",\"kw\":1,\"type\":\"RESIDENTIAL\",\"priority\":3,\"busbar\":\"B1\"}\n"
+                      "{\"id\":\"L5\",\"kw\":2,\"type\":\"RESIDENTIAL\",\"priority\":3,\"busbar\":\"B1\"}\n"));
+    CHECK_EQ(errorLine(importer), 2);
+    CHECK(importer.getLastError().find("duplicate load id 'L5'") != std::string::npos);
+}
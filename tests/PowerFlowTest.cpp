@@ -0,0 +1,218 @@
+// PowerFlowTest.cpp
+//
+// The DC power flow's sparse factor has to give the same tie flows as
+// solving B * angles = P directly, also after the ties switch (which
+// refactorizes) and on forks that share the factor.
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+#include "../include/Grid.h"
+#include "TestHarness.h"
+
+namespace {
+
+// Five busbars meshed by ties of unequal reactance (two of them parallel),
+// and a sixth behind an open tie, too small for its own load
+void buildGrid(Grid& grid) {
+    grid.setShedReporting(false);
+    grid.setPowerFlow(true);
+    for (int b = 0; b < 6; ++b) {
+        grid.addBusbar(grid.createBusbar("N" + std::to_string(b)));
+    }
+    grid.addTie("T01", "N0", "N1", 1000.0, true, 0.1);
+    grid.addTie("T01b", "N0", "N1", 1000.0, true, 0.7);
+    grid.addTie("T12", "N1", "N2", 1000.0, true, 0.3);
+    grid.addTie("T20", "N2", "N0", 1000.0, true, 0.2);
+    grid.addTie("T13", "N1", "N3", 1000.0, true, 0.25);
+    grid.addTie("T23", "N2", "N3", 1000.0, true, 0.5);
+    grid.addTie("T34", "N3", "N4", 1000.0, true, 0.4);
+    grid.addTie("T45", "N4", "N5", 1000.0, false, 1.0);
+    grid.addSource(grid.createSource("G0", 600.0), "N0");
+    grid.addSource(grid.createSource("G2", 150.0), "N2");
+    grid.addSource(grid.createSource("G5", 50.0), "N5");
+    grid.addLoad(grid.createLoad("L1", 120.0, LoadType::COMMERCIAL, Priority::HIGH), "N1");
+    grid.addLoad(grid.createLoad("L2", 40.0, LoadType::RESIDENTIAL, Priority::MEDIUM), "N2");
+    grid.addLoad(grid.createLoad("L3", 200.0, LoadType::INDUSTRIAL, Priority::MEDIUM), "N3");
+    grid.addLoad(grid.createLoad("L4", 180.0, LoadType::RESIDENTIAL, Priority::LOW), "N4");
+    grid.addLoad(grid.createLoad("L5", 80.0, LoadType::RESIDENTIAL, Priority::LOW), "N5");
+    grid.distributeLoadOptimally();
+}
+
+// Tie flows from a dense Gaussian elimination of B * angles = P, with each
+// tie-connected group's lowest busbar handle as its reference at angle 0
+std::vector<double> denseFlows(Grid& grid) {
+    const GridState& state = grid.getState();
+    const std::vector<Topology::Tie>& ties = grid.getTopology().getTies();
+    std::size_t slots = state.busbarSlotCount();
+
+    std::vector<GridState::Handle> group(slots);
+    for (GridState::Handle b = 0; b < slots; ++b) {
+        group[b] = b;
+    }
+    std::vector<bool> tied(slots, false);
+    for (bool merged = true; merged;) {
+        merged = false;
+        for (const auto& tie : ties) {
+            if (!tie.closed) continue;
+            tied[tie.from] = tied[tie.to] = true;
+            GridState::Handle low = std::min(group[tie.from], group[tie.to]);
+            if (group[tie.from] != low || group[tie.to] != low) {
+                group[tie.from] = group[tie.to] = low;
+                merged = true;
+            }
+        }
+    }
+    std::vector<std::size_t> row(slots, PowerFlow::NONE);
+    std::vector<GridState::Handle> busbarOf;
+    for (GridState::Handle b = 0; b < slots; ++b) {
+        if (tied[b] && group[b] != b) {
+            row[b] = busbarOf.size();
+            busbarOf.push_back(b);
+        }
+    }
+    std::size_t n = busbarOf.size();
+
+    // [B | P]
+    std::vector<std::vector<double>> a(n, std::vector<double>(n + 1, 0.0));
+    for (std::size_t i = 0; i < n; ++i) {
+        GridState::Handle busbar = busbarOf[i];
+        a[i][n] = -state.busbarServedPower(busbar);
+        for (GridState::Handle source : state.busbarSources[busbar]) {
+            a[i][n] += state.sourceCurrentLoad[source];
+        }
+    }
+    for (const auto& tie : ties) {
+        if (!tie.closed) continue;
+        double b = 1.0 / tie.reactance;
+        std::size_t from = row[tie.from];
+        std::size_t to = row[tie.to];
+        if (from != PowerFlow::NONE) a[from][from] += b;
+        if (to != PowerFlow::NONE) a[to][to] += b;
+        if (from != PowerFlow::NONE && to != PowerFlow::NONE) {
+            a[from][to] -= b;
+            a[to][from] -= b;
+        }
+    }
+    for (std::size_t k = 0; k < n; ++k) {
+        std::size_t pivot = k;
+        for (std::size_t i = k + 1; i < n; ++i) {
+            if (std::fabs(a[i][k]) > std::fabs(a[pivot][k])) pivot = i;
+        }
+        std::swap(a[k], a[pivot]);
+        for (std::size_t i = k + 1; i < n; ++i) {
+            double factor = a[i][k] / a[k][k];
+            for (std::size_t j = k; j <= n; ++j) {
+                a[i][j] -= factor * a[k][j];
+            }
+        }
+    }
+    std::vector<double> angles(n, 0.0);
+    for (std::size_t k = n; k-- > 0;) {
+        double sum = a[k][n];
+        for (std::size_t j = k + 1; j < n; ++j) {
+            sum -= a[k][j] * angles[j];
+        }
+        angles[k] = sum / a[k][k];
+    }
+
+    auto angleOf = [&](GridState::Handle busbar) {
+        return row[busbar] == PowerFlow::NONE ? 0.0 : angles[row[busbar]];
+    };
+    std::vector<double> flows(ties.size(), 0.0);
+    for (std::size_t i = 0; i < ties.size(); ++i) {
+        if (ties[i].closed) {
+            flows[i] = (angleOf(ties[i].from) - angleOf(ties[i].to)) / ties[i].reactance;
+        }
+    }
+    return flows;
+}
+
+// The stored flows against the dense solve; false if every tie is idle
+bool checkFlows(Grid& grid) {
+    std::vector<double> expected = denseFlows(grid);
+    const std::vector<Topology::Tie>& ties = grid.getTopology().getTies();
+    bool flowing = false;
+    for (std::size_t i = 0; i < ties.size(); ++i) {
+        CHECK_NEAR(ties[i].powerFlowKw, expected[i], 1e-6);
+        flowing = flowing || std::fabs(expected[i]) > 1.0;
+    }
+    return flowing;
+}
+
+std::map<std::string, double> flowsById(const Grid& grid) {
+    std::map<std::string, double> flows;
+    for (const auto& tie : grid.getTopology().getTies()) {
+        flows[tie.id] = tie.powerFlowKw;
+    }
+    return flows;
+}
+
+double flowOf(const Grid& grid, const std::string& id) {
+    return grid.getTopology().findTie(id)->powerFlowKw;
+}
+
+} // namespace
+
+GRID_TEST(PowerFlow, MeshedTiesMatchDenseSolve) {
+    Grid grid("Test Grid");
+    buildGrid(grid);
+    CHECK(checkFlows(grid));
+    CHECK_EQ(flowOf(grid, "T45"), 0.0);
+    // Parallel ties split in inverse proportion to their reactance
+    CHECK_NEAR(flowOf(grid, "T01"), 7.0 * flowOf(grid, "T01b"), 1e-6);
+}
+
+GRID_TEST(PowerFlow, SwitchingTiesRefactorizes) {
+    Grid grid("Test Grid");
+    buildGrid(grid);
+    auto meshed = flowsById(grid);
+
+    grid.setTieClosed("T13", false);
+    grid.distributeLoadOptimally();
+    CHECK(checkFlows(grid));
+    CHECK_EQ(flowOf(grid, "T13"), 0.0);
+    // All of N3 and N4 now comes in over T23
+    CHECK(std::fabs(flowOf(grid, "T23") - meshed["T23"]) > 1.0);
+
+    // Closing the open tie joins N5 to the mesh, which then serves L5
+    grid.setTieClosed("T45", true);
+    grid.distributeLoadOptimally();
+    CHECK(checkFlows(grid));
+    CHECK(flowOf(grid, "T45") != 0.0);
+
+    // Back to the original ties, back to the original flows
+    grid.setTieClosed("T13", true);
+    grid.setTieClosed("T45", false);
+    grid.distributeLoadOptimally();
+    CHECK(checkFlows(grid));
+    for (const auto& flow : flowsById(grid)) {
+        CHECK_NEAR(flow.second, meshed[flow.first], 1e-6);
+    }
+}
+
+GRID_TEST(PowerFlow, ForksShareTheFactor) {
+    Grid grid("Test Grid");
+    buildGrid(grid);
+    auto before = flowsById(grid);
+
+    // Same ties, new injections: the branch solves over the shared factor
+    auto branch = grid.fork();
+    branch->getLoad("L3")->setPowerDemand(90.0);
+    branch->distributeLoadOptimally();
+    CHECK(checkFlows(*branch));
+    CHECK(flowsById(*branch) != before);
+    CHECK(flowsById(grid) == before);
+
+    // The branch refactorizes for its own ties; the origin keeps its factor
+    branch->setTieClosed("T12", false);
+    branch->distributeLoadOptimally();
+    CHECK(checkFlows(*branch));
+    CHECK_EQ(flowOf(*branch, "T12"), 0.0);
+    grid.getLoad("L4")->setPowerDemand(60.0);
+    grid.distributeLoadOptimally();
+    CHECK(checkFlows(grid));
+    CHECK(flowOf(grid, "T12") != 0.0);
+}
@@ -0,0 +1,83 @@
+// TestHarness.h
+#ifndef TEST_HARNESS_H
+#define TEST_HARNESS_H
+
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// A minimal test runner, so the tests build wherever the simulator does.
+// GRID_TEST(Suite, Name) defines a test; grid_tests runs every test, or
+// only those of the suites named on its command line, and exits non-zero
+// if any check failed.
+namespace testing {
+
+struct TestCase {
+    std::string suite;
+    std::string name;
+    std::function<void()> body;
+};
+
+std::vector<TestCase>& registry();
+// Records a failed check against the running test
+void fail(const char* file, int line, const std::string& message);
+
+struct Registrar {
+    Registrar(const char* suite, const char* name, std::function<void()> body) {
+        registry().push_back({suite, name, std::move(body)});
+    }
+};
+
+template <typename A, typename B>
+std::string describe(const char* expression, const A& actual, const B& expected) {
+    std::string text = expression;
+    text += " (";
+    text += std::to_string(actual);
+    text += " vs ";
+    text += std::to_string(expected);
+    text += ")";
+    return text;
+}
+
+} // namespace testing
+
+#define GRID_TEST(suite, name)                                                   \
+    static void suite##_##name();                                                \
+    static testing::Registrar suite##_##name##_registrar(#suite, #name, suite##_##name); \
+    static void suite##_##name()
+
+#define CHECK(condition)                                                         \
+    do {                                                                         \
+        if (!(condition)) testing::fail(__FILE__, __LINE__, #condition);         \
+    } while (0)
+
+// Ends the test on failure, for checks later ones depend on
+#define REQUIRE(condition)                                                       \
+    do {                                                                         \
+        if (!(condition)) {                                                      \
+            testing::fail(__FILE__, __LINE__, #condition);                       \
+            return;                                                              \
+        }                                                                        \
+    } while (0)
+
+#define CHECK_EQ(actual, expected)                                               \
+    do {                                                                         \
+        auto actualValue = (actual);                                             \
+        auto expectedValue = (expected);                                         \
+        if (!(actualValue == expectedValue))                                     \
+            testing::fail(__FILE__, __LINE__,                                    \
+                          testing::describe(#actual " == " #expected, actualValue, expectedValue)); \
+    } while (0)
+
+#define CHECK_NEAR(actual, expected, tolerance)                                  \
+    do {                                                                         \
+        double actualValue = (actual);                                           \
+        double expectedValue = (expected);                                       \
+        if (!(std::fabs(actualValue - expectedValue) <= (tolerance)))            \
+            testing::fail(__FILE__, __LINE__,                                    \
+                          testing::describe(#actual " ~ " #expected, actualValue, expectedValue)); \
+    } while (0)
+
+#endif // TEST_HARNESS_H
@@ -0,0 +1,45 @@
+// TestMain.cpp
+#include "TestHarness.h"
+#include <algorithm>
+
+namespace testing {
+
+namespace {
+
+std::size_t failures = 0;
+const TestCase* running = nullptr;
+
+} // namespace
+
+std::vector<TestCase>& registry() {
+    static std::vector<TestCase> tests;
+    return tests;
+}
+
+void fail(const char* file, int line, const std::string& message) {
+    ++failures;
+    std::cerr << file << ":" << line << ": " << running->suite << "." << running->name
+              << " failed: " << message << "\n";
+}
+
+} // namespace testing
+
+int main(int argc, char* argv[]) {
+    std::vector<std::string> suites(argv + 1, argv + argc);
+    std::size_t run = 0;
+    std::size_t failed = 0;
+    for (const testing::TestCase& test : testing::registry()) {
+        if (!suites.empty() && std::find(suites.begin(), suites.end(), test.suite) == suites.end()) {
+            continue;
+        }
+        std::size_t before = testing::failures;
+        testing::running = &test;
+        test.body();
+        ++run;
+        if (testing::failures != before) {
+            ++failed;
+        }
+    }
+    std::cout << run << " tests run, " << failed << " failed\n";
+    return (failed == 0 && run > 0) ? 0 : 1;
+}
@@ -0,0 +1,55 @@
+// TestSupport.cpp
+#include "TestSupport.h"
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+namespace testing {
+
+std::string tempPath(const std::string& name) {
+    return (std::filesystem::temp_directory_path() / ("grid_tests_" + name)).string();
+}
+
+std::string readFile(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    std::stringstream bytes;
+    bytes << file.rdbuf();
+    return bytes.str();
+}
+
+bool parseScenario(Scenario& scenario, const std::vector<std::string>& lines) {
+    std::string path = tempPath("scenario.txt");
+    {
+        std::ofstream file(path);
+        for (const std::string& line : lines) {
+            file << line << "\n";
+        }
+    }
+    bool loaded = scenario.loadFromFile(path);
+    std::filesystem::remove(path);
+    return loaded;
+}
+
+std::shared_ptr<Grid> loadScenario(const std::string& path) {
+    Scenario scenario;
+    if (!scenario.loadFromFile(path)) {
+        return nullptr;
+    }
+    auto grid = std::make_shared<Grid>(scenario.getGridName());
+    grid->setShedReporting(false);
+    scenario.buildGrid(*grid);
+    grid->distributeLoadOptimally();
+    return grid;
+}
+
+std::map<std::string, double> servedPowers(Grid& grid) {
+    std::map<std::string, double> served;
+    for (const auto& busbar : grid.getBusbars()) {
+        for (const Load& load : busbar->getLoadView()) {
+            served[load.getId()] = load.getServedPower();
+        }
+    }
+    return served;
+}
+
+} // namespace testing
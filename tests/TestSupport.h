@@ -0,0 +1,30 @@
+// TestSupport.h
+#ifndef TEST_SUPPORT_H
+#define TEST_SUPPORT_H
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include "../include/Grid.h"
+#include "../include/Scenario.h"
+
+// Fixtures shared by the test suites
+namespace testing {
+
+// A scratch file in the system's temporary directory
+std::string tempPath(const std::string& name);
+std::string readFile(const std::string& path);
+
+// Writes the lines to a scratch scenario file and loads that
+bool parseScenario(Scenario& scenario, const std::vector<std::string>& lines);
+// The scenario file's grid, dispatched once with shed reporting off
+// (nullptr if the file does not load)
+std::shared_ptr<Grid> loadScenario(const std::string& path);
+
+// Power served to every connected load, by ID
+std::map<std::string, double> servedPowers(Grid& grid);
+
+} // namespace testing
+
+#endif // TEST_SUPPORT_H